@@ -37,6 +37,8 @@ namespace Akregator
 namespace Backend
 {
 class FeedStorage;
+struct ArticleData;
+struct ArticleHeader;
 }
 
 class Feed;
@@ -59,12 +61,27 @@ public:
         */
     Article(const QString &guid, Feed *feed, Backend::FeedStorage *archive = nullptr);
 
+    /** creates an article object for an existing article from header columns
+        already read by Backend::FeedStorage::forEachArticleHeader(), without another archive lookup
+        */
+    Article(const Backend::ArticleHeader &header, Feed *feed, Backend::FeedStorage *archive);
+
     /** creates an article object from a parsed librss Article
         the article is added to the archive if not yet stored, or updated if stored but modified
     */
     Article(const Syndication::ItemPtr &article, Feed *feed);
 
     Article(const Syndication::ItemPtr &article, Backend::FeedStorage *archive);
+
+    /** creates an article object from data prepared by prepareItem().
+        Like the ItemPtr constructor, the article is added to the archive if not yet stored, or updated if stored but modified
+    */
+    Article(const Backend::ArticleData &data, Feed *feed);
+
+    /** extracts everything to store for a parsed item, including its hash and fallback title.
+        Does not access any archive, so it is safe to call from a worker thread.
+    */
+    [[nodiscard]] static Backend::ArticleData prepareItem(const Syndication::ItemPtr &article);
     Article(const Article &other);
     ~Article();
 
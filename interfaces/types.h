@@ -15,4 +15,12 @@ enum ArticleStatus {
     Read, /**< article is read */
     New /**< article was fetched in the last fetch of it's feed and not read yet. Note that, semantically, new implies unread */
 };
+
+/** priority lanes of the fetch queue, in the order they are served */
+enum FetchPriority {
+    InteractiveFetch = 0, /**< the user asked for these feeds explicitly */
+    StartupFetch, /**< all feeds are refreshed, at startup or on request */
+    BackgroundFetch, /**< interval fetches */
+    FetchPriorityCount
+};
 }
@@ -312,6 +312,11 @@ void ActionManagerImpl::initMainWidget(MainWidget *mainWidget)
     coll->setDefaultShortcut(stopAction, QKeySequence(Qt::Key_Escape));
     stopAction->setEnabled(false);
 
+    action = coll->addAction(QStringLiteral("feed_fetch_statistics"));
+    action->setIcon(QIcon::fromTheme(QStringLiteral("view-statistics")));
+    action->setText(i18n("Fetch &Statistics…"));
+    connect(action, &QAction::triggered, d->mainWidget, &MainWidget::slotShowFetchStatistics);
+
     action = coll->addAction(QStringLiteral("feed_mark_all_as_read"));
     action->setIcon(QIcon::fromTheme(QStringLiteral("mail-mark-read")));
     action->setText(i18n("&Mark Feed as Read"));
@@ -18,6 +18,8 @@
 #include "akregatorconfig.h"
 #include "article.h"
 #include "feedlist.h"
+#include "fetchqueue.h"
+#include "fetchstatistics.h"
 #include "framemanager.h"
 #include "kernel.h"
 #include "loadfeedlistcommand.h"
@@ -47,6 +49,7 @@
 #include <QApplication>
 #include <QDomDocument>
 #include <QFile>
+#include <QJsonDocument>
 #include <QObject>
 #include <QStringList>
 #include <QTextStream>
@@ -133,9 +136,19 @@ Part::Part(QWidget *parentWidget, QObject *parent, const KPluginMetaData &data,
     m_standardFeedList = path + QStringLiteral("/feeds.opml");
 
     m_storage = new Backend::Storage;
+    m_storage->setSharedArchive(Settings::archiveBackend() == QLatin1StringView("metakit-shared"));
     m_storage->open(true);
+    applyCommitDelays();
 
     Kernel::self()->setStorage(m_storage);
+    // don't write the archive while feeds are being fetched, but right after
+    FetchQueue *const fetchQueue = Kernel::self()->fetchQueue();
+    connect(fetchQueue, &FetchQueue::signalStarted, m_storage, [this, fetchQueue]() {
+        m_storage->holdCommits(fetchQueue);
+    });
+    connect(fetchQueue, &FetchQueue::signalStopped, m_storage, [this, fetchQueue]() {
+        m_storage->releaseCommits(fetchQueue);
+    });
 
     m_actionManager = new ActionManagerImpl(this);
     ActionManager::setInstance(m_actionManager);
@@ -223,8 +236,17 @@ void Part::initializeTrayIcon()
     m_mainWidget->slotSetTotalUnread();
 }
 
+void Part::applyCommitDelays()
+{
+    m_storage->setCommitDelays(std::chrono::seconds(Settings::commitMinDelay()), std::chrono::seconds(Settings::commitMaxDelay()));
+}
+
 void Part::slotSettingsChanged()
 {
+    if (m_storage) {
+        applyCommitDelays();
+    }
+
     if (Settings::showUnreadInTaskbar()) {
         connect(m_mainWidget.data(), &MainWidget::signalUnreadCountChanged, qGuiApp, &QGuiApplication::setBadgeNumber);
         m_mainWidget->slotSetTotalUnread();
@@ -503,6 +525,19 @@ void Part::fetchAllFeeds()
     m_mainWidget->slotFetchAllFeeds();
 }
 
+QString Part::fetchStatistics() const
+{
+    if (!m_mainWidget) {
+        return {};
+    }
+    return QString::fromUtf8(QJsonDocument(m_mainWidget->fetchStatistics()->toJson()).toJson());
+}
+
+bool Part::saveFetchStatistics(const QString &path)
+{
+    return m_mainWidget && writeToTextFile(fetchStatistics(), path);
+}
+
 void Part::fetchFeedUrl(const QString &s)
 {
     qCDebug(AKREGATOR_LOG) << "fetchFeedURL==" << s;
@@ -90,6 +90,11 @@ public:
 
     bool handleCommandLine(const QStringList &args);
 
+    /** returns the timings of the fetches of this session as JSON, see FetchStatistics */
+    [[nodiscard]] QString fetchStatistics() const;
+    /** writes fetchStatistics() to @p path */
+    bool saveFetchStatistics(const QString &path);
+
     KSharedConfig::Ptr config();
     void updateQuickSearchLineText();
 public Q_SLOTS:
@@ -160,6 +165,9 @@ private: // methods
      */
     void clearCrashProperties();
 
+    /** passes the archive commit delays from the settings to the storage */
+    void applyCommitDelays();
+
 private: // attributes
     void initializeTrayIcon();
 
@@ -78,7 +78,8 @@ namespace Akregator
 struct Article::Private : public Shared {
     Private();
     Private(const QString &guid, Feed *feed, Backend::FeedStorage *archive);
-    Private(const ItemPtr &article, Feed *feed, Backend::FeedStorage *archive);
+    Private(const Backend::ArticleHeader &header, Feed *feed, Backend::FeedStorage *archive);
+    Private(const Backend::ArticleData &data, Feed *feed, Backend::FeedStorage *archive);
 
     /** The status of the article is stored in an int, the bits having the
         following meaning:
@@ -104,6 +105,7 @@ struct Article::Private : public Shared {
     uint hash;
     QDateTime pubDate;
     QString title; // Cache the title, for performance
+    mutable Backend::ArticleRow row; // Cache the archive position, saves a guid lookup per field access
     mutable QSharedPointer<const Enclosure> enclosure;
 };
 
@@ -171,77 +173,59 @@ Article::Private::Private(const QString &guid_, Feed *feed_, Backend::FeedStorag
     , guid(guid_)
     , archive(archive_)
 {
-    archive->article(guid, hash, title, status, pubDate);
+    archive->article(guid, hash, title, status, pubDate, &row);
 }
 
-Article::Private::Private(const ItemPtr &article, Feed *feed_, Backend::FeedStorage *archive_)
+Article::Private::Private(const Backend::ArticleHeader &header, Feed *feed_, Backend::FeedStorage *archive_)
     : feed(feed_)
+    , guid(header.guid)
     , archive(archive_)
-    , status(New)
-    , hash(0)
+    , status(header.status)
+    , hash(header.hash)
+    , pubDate(header.pubDate)
+    , title(header.title)
+    , row(header.row)
+{
+}
+
+Backend::ArticleData Article::prepareItem(const ItemPtr &article)
 {
-    Q_ASSERT(archive);
     const QList<PersonPtr> authorList = article->authors();
 
     QString author;
 
     const PersonPtr firstAuthor = !authorList.isEmpty() ? authorList.first() : PersonPtr();
 
-    hash = Utils::calcHash(article->title() + article->description() + article->content() + article->link() + author);
-
-    guid = article->id();
-
-    if (!archive->contains(guid)) {
-        archive->addEntry(guid);
-
-        archive->setHash(guid, hash);
-        title = article->title();
-        if (title.isEmpty()) {
-            title = buildTitle(article->description());
-        }
-        archive->setTitle(guid, title);
-        archive->setContent(guid, article->content());
-        archive->setDescription(guid, article->description());
-        archive->setLink(guid, article->link());
-        archive->setGuidIsPermaLink(guid, false);
-        archive->setGuidIsHash(guid, guid.startsWith(QLatin1StringView("hash:")));
-        const time_t datePublished = article->datePublished();
-        if (datePublished > 0) {
-            pubDate = QDateTime::fromSecsSinceEpoch(datePublished);
-        } else {
-            pubDate = QDateTime::currentDateTime();
-        }
-        archive->setPubDate(guid, pubDate);
-        if (firstAuthor) {
-            archive->setAuthorName(guid, firstAuthor->name());
-            archive->setAuthorUri(guid, firstAuthor->uri());
-            archive->setAuthorEMail(guid, firstAuthor->email());
-        }
+    Backend::ArticleData data;
+    data.guid = article->id();
+    data.title = article->title();
+    data.description = article->description();
+    data.content = article->content();
+    data.link = article->link();
+    data.hash = Utils::calcHash(data.title + data.description + data.content + data.link + author);
+    if (data.title.isEmpty()) {
+        data.title = buildTitle(data.description);
+    }
+    data.guidIsPermaLink = false;
+    data.guidIsHash = data.guid.startsWith(QLatin1StringView("hash:"));
+    const time_t datePublished = article->datePublished();
+    if (datePublished > 0) {
+        data.pubDate = QDateTime::fromSecsSinceEpoch(datePublished);
     } else {
-        // always update comments count, as it's not used for hash calculation
-        if (hash != archive->hash(guid)) { // article is in archive, was it modified?
-            // if yes, update
-            pubDate = archive->pubDate(guid);
-            archive->setHash(guid, hash);
-            title = article->title();
-            if (title.isEmpty()) {
-                title = buildTitle(article->description());
-            }
-            archive->setTitle(guid, title);
-            archive->setDescription(guid, article->description());
-            archive->setContent(guid, article->content());
-            archive->setLink(guid, article->link());
-            if (firstAuthor) {
-                archive->setAuthorName(guid, firstAuthor->name());
-                archive->setAuthorUri(guid, firstAuthor->uri());
-                archive->setAuthorEMail(guid, firstAuthor->email());
-            }
-        }
+        data.pubDate = QDateTime::currentDateTime();
+    }
+    if (firstAuthor) {
+        data.hasAuthor = true;
+        data.authorName = firstAuthor->name();
+        data.authorUri = firstAuthor->uri();
+        data.authorEMail = firstAuthor->email();
     }
-
     const QList<EnclosurePtr> encs = article->enclosures();
     if (!encs.isEmpty()) {
-        archive->setEnclosure(guid, encs[0]->url(), encs[0]->type(), encs[0]->length());
+        data.hasEnclosure = true;
+        data.enclosureUrl = encs[0]->url();
+        data.enclosureType = encs[0]->type();
+        data.enclosureLength = encs[0]->length();
     }
 #if 0 // We need additionalProperties for Bug 366487
     qDebug() << "article " << article->additionalProperties().count();
@@ -253,6 +237,32 @@ Article::Private::Private(const ItemPtr &article, Feed *feed_, Backend::FeedStor
         qDebug() << key << ": " << str;
     }
 #endif
+    return data;
+}
+
+Article::Private::Private(const Backend::ArticleData &data, Feed *feed_, Backend::FeedStorage *archive_)
+    : feed(feed_)
+    , guid(data.guid)
+    , archive(archive_)
+    , status(New)
+    , hash(data.hash)
+{
+    Q_ASSERT(archive);
+    if (!archive->contains(guid, &row)) {
+        title = data.title;
+        pubDate = data.pubDate;
+        archive->addArticle(data, &row);
+    } else {
+        // always update comments count, as it's not used for hash calculation
+        if (hash != archive->hash(guid, &row)) { // article is in archive, was it modified?
+            // if yes, update
+            pubDate = archive->pubDate(guid, &row);
+            title = data.title;
+            archive->updateArticle(data, &row);
+        } else if (data.hasEnclosure) {
+            archive->setEnclosure(guid, data.enclosureUrl, data.enclosureType, data.enclosureLength, &row);
+        }
+    }
 }
 
 Article::Article()
@@ -269,13 +279,23 @@ Article::Article(const QString &guid, Feed *feed, Backend::FeedStorage *archive)
     d = new Private(guid, feed, archive);
 }
 
+Article::Article(const Backend::ArticleHeader &header, Feed *feed, Backend::FeedStorage *archive)
+    : d(new Private(header, feed, archive))
+{
+}
+
 Article::Article(const Syndication::ItemPtr &article, Feed *feed)
-    : d(new Private(article, feed, feed->storage()->archiveFor(feed->xmlUrl())))
+    : d(new Private(prepareItem(article), feed, feed->storage()->archiveFor(feed->xmlUrl())))
 {
 }
 
 Article::Article(const Syndication::ItemPtr &article, Backend::FeedStorage *archive)
-    : d(new Private(article, nullptr, archive))
+    : d(new Private(prepareItem(article), nullptr, archive))
+{
+}
+
+Article::Article(const Backend::ArticleData &data, Feed *feed)
+    : d(new Private(data, feed, feed->storage()->archiveFor(feed->xmlUrl())))
 {
 }
 
@@ -287,7 +307,7 @@ bool Article::isNull() const
 void Article::offsetPubDate(int secs)
 {
     d->pubDate = d->pubDate.addSecs(secs);
-    d->archive->setPubDate(d->guid, d->pubDate);
+    d->archive->setPubDate(d->guid, d->pubDate, &d->row);
 }
 
 void Article::setDeleted()
@@ -298,8 +318,8 @@ void Article::setDeleted()
 
     setStatus(Read);
     d->status = Private::Deleted | Private::Read;
-    d->archive->setStatus(d->guid, d->status);
-    d->archive->setDeleted(d->guid);
+    d->archive->setStatus(d->guid, d->status, &d->row);
+    d->archive->setDeleted(d->guid, &d->row);
 
     if (d->feed) {
         d->feed->setArticleDeleted(*this);
@@ -392,7 +412,7 @@ void Article::setStatus(int stat)
             break;
         }
         if (d->archive) {
-            d->archive->setStatus(d->guid, d->status);
+            d->archive->setStatus(d->guid, d->status, &d->row);
         }
         if (d->feed) {
             d->feed->setArticleChanged(*this, oldStatus, stat != Read);
@@ -409,7 +429,7 @@ QString Article::authorName() const
 {
     QString str;
     if (d->archive) {
-        str = d->archive->authorName(d->guid);
+        str = d->archive->authorName(d->guid, &d->row);
     }
     return str;
 }
@@ -418,7 +438,7 @@ QString Article::authorEMail() const
 {
     QString str;
     if (d->archive) {
-        str = d->archive->authorEMail(d->guid);
+        str = d->archive->authorEMail(d->guid, &d->row);
     }
     return str;
 }
@@ -427,7 +447,7 @@ QString Article::authorUri() const
 {
     QString str;
     if (d->archive) {
-        str = d->archive->authorUri(d->guid);
+        str = d->archive->authorUri(d->guid, &d->row);
     }
     return str;
 }
@@ -479,17 +499,17 @@ QString Article::authorAsHtml() const
 
 QUrl Article::link() const
 {
-    return QUrl(d->archive->link(d->guid));
+    return QUrl(d->archive->link(d->guid, &d->row));
 }
 
 QString Article::description() const
 {
-    return d->archive->description(d->guid);
+    return d->archive->description(d->guid, &d->row);
 }
 
 QString Article::content(ContentOption opt) const
 {
-    const QString cnt = d->archive->content(d->guid);
+    const QString cnt = d->archive->content(d->guid, &d->row);
     return opt == ContentAndOnlyContent ? cnt : (!cnt.isEmpty() ? cnt : description());
 }
 
@@ -500,12 +520,12 @@ QString Article::guid() const
 
 bool Article::guidIsPermaLink() const
 {
-    return d->archive->guidIsPermaLink(d->guid);
+    return d->archive->guidIsPermaLink(d->guid, &d->row);
 }
 
 bool Article::guidIsHash() const
 {
-    return d->archive->guidIsHash(d->guid);
+    return d->archive->guidIsHash(d->guid, &d->row);
 }
 
 uint Article::hash() const
@@ -521,7 +541,7 @@ bool Article::keep() const
 void Article::setKeep(bool keep)
 {
     d->status = keep ? (d->status | Private::Keep) : (d->status & ~Private::Keep);
-    d->archive->setStatus(d->guid, d->status);
+    d->archive->setStatus(d->guid, d->status, &d->row);
     if (d->feed) {
         d->feed->setArticleChanged(*this);
     }
@@ -544,7 +564,7 @@ QSharedPointer<const Enclosure> Article::enclosure() const
         QString type;
         int length;
         bool hasEnc;
-        d->archive->enclosure(d->guid, hasEnc, url, type, length);
+        d->archive->enclosure(d->guid, hasEnc, url, type, length, &d->row);
         if (hasEnc) {
             d->enclosure.reset(new EnclosureImpl(url, type, static_cast<uint>(length)));
         } else {
@@ -11,6 +11,7 @@
 #include "feed.h"
 #include "feedlist.h"
 #include "kernel.h"
+#include "storage/storage.h"
 
 #include "akregator_debug.h"
 #include <KLocalizedString>
@@ -96,6 +97,10 @@ void ArticleModifyJob::setKeep(const ArticleId &id, bool keep)
 
 void ArticleModifyJob::start()
 {
+    // keep the archive from being written between scheduling and applying the changes
+    if (Backend::Storage *const storage = Kernel::self()->storage()) {
+        storage->holdCommits(this);
+    }
     QTimer::singleShot(20ms, this, &ArticleModifyJob::doStart);
 }
 
@@ -103,6 +108,9 @@ void ArticleModifyJob::doStart()
 {
     if (!m_feedList) {
         qCWarning(AKREGATOR_LOG) << "Feedlist object was deleted, items not modified";
+        if (Backend::Storage *const storage = Kernel::self()->storage()) {
+            storage->releaseCommits(this);
+        }
         emitResult();
         return;
     }
@@ -139,6 +147,9 @@ void ArticleModifyJob::doStart()
     for (Feed *const i : std::as_const(feeds)) {
         i->setNotificationMode(true);
     }
+    if (Backend::Storage *const storage = Kernel::self()->storage()) {
+        storage->releaseCommits(this);
+    }
     emitResult();
 }
 
@@ -10,6 +10,7 @@
 #include "articlelistview.h"
 #include "actionmanager.h"
 #include "akregatorconfig.h"
+#include "articlematcher.h"
 #include "articlemodel.h"
 #include "types.h"
 
@@ -27,9 +28,14 @@
 #include <QHeaderView>
 #include <QPainter>
 #include <QPalette>
+#include <QPromise>
 #include <QScrollBar>
+#include <QThreadPool>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <utility>
 
 using namespace Akregator;
 
@@ -43,6 +49,38 @@ bool FilterDeletedProxyModel::filterAcceptsRow(int source_row, const QModelIndex
     return !sourceModel()->index(source_row, 0, source_parent).data(ArticleModel::IsDeletedRole).toBool();
 }
 
+namespace
+{
+/** article lists with at least this many rows are filtered on the thread pool */
+constexpr int parallelFilterRows = 2000;
+/** rows evaluated by one task of a filter run */
+constexpr int filterChunkRows = 512;
+
+/** whether every article accepted by @p matchers is accepted by @p previous as well */
+bool narrows(const std::vector<QSharedPointer<const Filters::AbstractMatcher>> &matchers,
+             const std::vector<QSharedPointer<const Filters::AbstractMatcher>> &previous)
+{
+    return std::all_of(previous.cbegin(), previous.cend(), [&matchers](const auto &old) {
+        return std::any_of(matchers.cbegin(), matchers.cend(), [&old](const auto &matcher) {
+            return matcher->refines(*old);
+        });
+    });
+}
+}
+
+/** the evaluation of new filters over a snapshot of the article list.
+    Only the GUI thread owns it: Article is not reference counted atomically, so copies of the
+    snapshot must neither be made nor destroyed by the tasks, which just get a pointer to it. */
+struct SortColorizeProxyModel::FilterRun {
+    std::vector<QSharedPointer<const Filters::AbstractMatcher>> matchers;
+    QList<Article> articles;
+    /** the rows to evaluate, all if empty */
+    std::vector<char> candidates;
+    /** one byte per row, so that the tasks can write their chunks concurrently */
+    std::vector<char> accepted;
+    std::atomic<int> pendingChunks{0};
+};
+
 SortColorizeProxyModel::SortColorizeProxyModel(QObject *parent)
     : QSortFilterProxyModel(parent)
     , m_keepFlagIcon(QIcon::fromTheme(QStringLiteral("mail-mark-important")))
@@ -51,12 +89,69 @@ SortColorizeProxyModel::SortColorizeProxyModel(QObject *parent)
     m_newColor = KColorScheme(QPalette::Normal, KColorScheme::View).foreground(KColorScheme::NegativeText).color();
 }
 
+SortColorizeProxyModel::~SortColorizeProxyModel()
+{
+    // cancelled runs finish in the background, none may outlive the articles it reads
+    const QList<QFutureWatcher<void> *> watchers = findChildren<QFutureWatcher<void> *>();
+    for (QFutureWatcher<void> *const watcher : watchers) {
+        watcher->cancel();
+        watcher->waitForFinished();
+    }
+}
+
+void SortColorizeProxyModel::setSourceModel(QAbstractItemModel *model)
+{
+    cancelFilterRun();
+    for (const QMetaObject::Connection &connection : std::as_const(m_sourceConnections)) {
+        disconnect(connection);
+    }
+    m_sourceConnections.clear();
+
+    QSortFilterProxyModel::setSourceModel(model);
+
+    if (model) {
+        const auto sourceChanged = [this]() {
+            m_sourceChanged = true;
+        };
+        // appended rows are checked one by one once the result is applied, changed rows are rechecked
+        const auto rowsInserted = [this](const QModelIndex &, int first) {
+            if (m_filterRun && static_cast<size_t>(first) < m_filterRun->accepted.size()) {
+                m_sourceChanged = true;
+            }
+        };
+        const auto dataChanged = [this](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+            if (!m_filterRun) {
+                return;
+            }
+            const int last = std::min(bottomRight.row(), static_cast<int>(m_filterRun->accepted.size()) - 1);
+            for (int row = topLeft.row(); row <= last; ++row) {
+                m_changedRows.insert(row);
+            }
+        };
+        m_sourceConnections = {
+            connect(model, &QAbstractItemModel::rowsInserted, this, rowsInserted),
+            connect(model, &QAbstractItemModel::rowsRemoved, this, sourceChanged),
+            connect(model, &QAbstractItemModel::dataChanged, this, dataChanged),
+            connect(model, &QAbstractItemModel::layoutChanged, this, sourceChanged),
+            connect(model, &QAbstractItemModel::modelReset, this, sourceChanged),
+        };
+    }
+}
+
 bool SortColorizeProxyModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
 {
     if (source_parent.isValid()) {
         return false;
     }
 
+    if (static_cast<size_t>(source_row) < m_accepted.size()) {
+        return m_accepted[source_row];
+    }
+    // rejected by the previous filters, which the new ones only narrow down
+    if (static_cast<size_t>(source_row) < m_candidates.size() && !m_candidates[source_row]) {
+        return false;
+    }
+
     for (ulong i = 0, total = m_matchers.size(); i < total; ++i) {
         if (!static_cast<ArticleModel *>(sourceModel())->rowMatches(source_row, m_matchers[i])) {
             return false;
@@ -68,18 +163,140 @@ bool SortColorizeProxyModel::filterAcceptsRow(int source_row, const QModelIndex
 
 void SortColorizeProxyModel::setFilters(const std::vector<QSharedPointer<const Filters::AbstractMatcher>> &matchers)
 {
+    if (m_filterRun && m_filterRun->matchers == matchers) {
+        return;
+    }
+    // the user kept typing, the running evaluation is outdated
+    cancelFilterRun();
     if (m_matchers == matchers) {
         return;
     }
+
+    auto model = qobject_cast<ArticleModel *>(sourceModel());
+    if (!model) {
+        applyFilters(matchers, {});
+        return;
+    }
+
+    // typing on in the search line or picking a narrower status only has to recheck the rows shown
+    std::vector<char> candidates;
+    if (!m_matchers.empty() && narrows(matchers, m_matchers)) {
+        candidates = acceptedRows();
+    }
+    const qsizetype rows = candidates.empty() ? model->rowCount() : std::count(candidates.cbegin(), candidates.cend(), 1);
+    if (matchers.empty() || rows < parallelFilterRows) {
+        applyFilters(matchers, {}, std::move(candidates));
+        return;
+    }
+    startFilterRun(matchers, std::move(candidates));
+}
+
+std::vector<char> SortColorizeProxyModel::acceptedRows() const
+{
+    std::vector<char> rows(sourceModel()->rowCount(), 0);
+    for (int row = 0, count = rowCount(); row < count; ++row) {
+        rows[mapToSource(index(row, 0)).row()] = 1;
+    }
+    return rows;
+}
+
+void SortColorizeProxyModel::startFilterRun(const std::vector<QSharedPointer<const Filters::AbstractMatcher>> &matchers, std::vector<char> candidates)
+{
+    for (const auto &matcher : matchers) {
+        matcher->prepare();
+    }
+
+    auto run = std::make_shared<FilterRun>();
+    run->matchers = matchers;
+    run->candidates = std::move(candidates);
+    run->articles = static_cast<ArticleModel *>(sourceModel())->articles();
+    const int rows = static_cast<int>(run->articles.size());
+    run->accepted.assign(rows, 0);
+    run->pendingChunks = (rows + filterChunkRows - 1) / filterChunkRows;
+    m_filterRun = run;
+    m_sourceChanged = false;
+    m_changedRows.clear();
+
+    auto promise = std::make_shared<QPromise<void>>();
+    m_filterWatcher = new QFutureWatcher<void>(this);
+    connect(m_filterWatcher, &QFutureWatcherBase::finished, this, &SortColorizeProxyModel::slotFilterRunFinished);
+    m_filterWatcher->setFuture(promise->future());
+    promise->start();
+
+    for (int first = 0; first < rows; first += filterChunkRows) {
+        const int last = std::min(rows, first + filterChunkRows);
+        QThreadPool::globalInstance()->start([promise, run = run.get(), first, last]() {
+            for (int row = first; row < last && !promise->isCanceled(); ++row) {
+                if (!run->candidates.empty() && !run->candidates[row]) {
+                    continue;
+                }
+                const Article &article = run->articles.at(row);
+                run->accepted[row] = std::all_of(run->matchers.cbegin(), run->matchers.cend(), [&article](const auto &matcher) {
+                    return matcher->matches(article);
+                });
+            }
+            if (--run->pendingChunks == 0) {
+                promise->finish();
+            }
+        });
+    }
+}
+
+void SortColorizeProxyModel::cancelFilterRun()
+{
+    if (!m_filterWatcher) {
+        return;
+    }
+    // the watcher and the snapshot go away once the tasks noticed, the tasks still read it until then
+    disconnect(m_filterWatcher, nullptr, this, nullptr);
+    QFutureWatcher<void> *const watcher = m_filterWatcher;
+    connect(watcher, &QFutureWatcherBase::finished, watcher, [watcher, run = std::move(m_filterRun)]() mutable {
+        run.reset();
+        watcher->deleteLater();
+    });
+    m_filterWatcher->cancel();
+    m_filterWatcher = nullptr;
+}
+
+void SortColorizeProxyModel::slotFilterRunFinished()
+{
+    m_filterWatcher->deleteLater();
+    m_filterWatcher = nullptr;
+    const std::shared_ptr<FilterRun> run = std::move(m_filterRun);
+    const QSet<int> changedRows = std::exchange(m_changedRows, {});
+    if (m_sourceChanged) {
+        // rows were removed or moved meanwhile, the result does not fit them anymore
+        applyFilters(run->matchers, {});
+        return;
+    }
+    // the tasks may have seen these rows before they changed
+    auto model = static_cast<ArticleModel *>(sourceModel());
+    for (const int row : changedRows) {
+        run->accepted[row] = std::all_of(run->matchers.cbegin(), run->matchers.cend(), [model, row](const auto &matcher) {
+            return model->rowMatches(row, matcher);
+        });
+    }
+    applyFilters(run->matchers, std::move(run->accepted));
+}
+
+void SortColorizeProxyModel::applyFilters(const std::vector<QSharedPointer<const Filters::AbstractMatcher>> &matchers,
+                                          std::vector<char> accepted,
+                                          std::vector<char> candidates)
+{
 #if QT_VERSION >= QT_VERSION_CHECK(6, 10, 0)
     beginFilterChange();
 #endif
     m_matchers = matchers;
+    m_accepted = std::move(accepted);
+    m_candidates = std::move(candidates);
 #if QT_VERSION >= QT_VERSION_CHECK(6, 10, 0)
     endFilterChange(QSortFilterProxyModel::Direction::Rows);
 #else
     invalidateFilter();
 #endif
+    // rows added later are checked one by one
+    m_accepted.clear();
+    m_candidates.clear();
 }
 
 QVariant SortColorizeProxyModel::data(const QModelIndex &idx, int role) const
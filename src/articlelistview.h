@@ -11,13 +11,18 @@
 #include "abstractselectioncontroller.h"
 #include "akregatorpart_export.h"
 
+#include <QFutureWatcher>
 #include <QPointer>
+#include <QSet>
 #include <QSortFilterProxyModel>
 #include <QTreeView>
 
 #include <QSharedPointer>
 #include <QUrl>
 
+#include <memory>
+#include <vector>
+
 class QContextMenuEvent;
 template<class T>
 class QList;
@@ -45,17 +50,48 @@ class AKREGATORPART_EXPORT SortColorizeProxyModel : public QSortFilterProxyModel
     Q_OBJECT
 public:
     explicit SortColorizeProxyModel(QObject *parent = nullptr);
+    ~SortColorizeProxyModel() override;
 
     [[nodiscard]] QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+
+    /** sets the filters. Long article lists are filtered on the thread pool, the new filters
+        are applied in one go once all rows are evaluated; until then the old ones stay active. */
     void setFilters(const std::vector<QSharedPointer<const Akregator::Filters::AbstractMatcher>> &);
 
 private:
+    struct FilterRun;
+
     bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const override;
 
+    /** evaluates @p matchers on the thread pool, only for the rows set in @p candidates unless it is empty */
+    void startFilterRun(const std::vector<QSharedPointer<const Akregator::Filters::AbstractMatcher>> &matchers, std::vector<char> candidates);
+    void cancelFilterRun();
+    void slotFilterRunFinished();
+    /** makes @p matchers the active filters. @p accepted holds their result per source row, if known;
+        otherwise only the rows set in @p candidates are checked, unless it is empty. */
+    void applyFilters(const std::vector<QSharedPointer<const Akregator::Filters::AbstractMatcher>> &matchers,
+                      std::vector<char> accepted,
+                      std::vector<char> candidates = {});
+    /** returns which source rows pass the active filters */
+    [[nodiscard]] std::vector<char> acceptedRows() const;
+
     QIcon m_keepFlagIcon;
     std::vector<QSharedPointer<const Akregator::Filters::AbstractMatcher>> m_matchers;
 
+    QFutureWatcher<void> *m_filterWatcher = nullptr;
+    std::shared_ptr<FilterRun> m_filterRun;
+    /** the result of the filter run being applied, empty otherwise */
+    std::vector<char> m_accepted;
+    /** the rows still to be checked while narrower filters are applied, empty otherwise */
+    std::vector<char> m_candidates;
+    /** set if source rows were removed or moved while a filter run was in progress */
+    bool m_sourceChanged = false;
+    /** the source rows of the filter run's snapshot which changed while it was in progress */
+    QSet<int> m_changedRows;
+    QList<QMetaObject::Connection> m_sourceConnections;
+
     QColor m_unreadColor;
     QColor m_newColor;
 };
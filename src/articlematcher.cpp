@@ -8,13 +8,20 @@
 #include "articlematcher.h"
 #include "akregator_debug.h"
 #include "article.h"
+#include "feed.h"
+#include "kernel.h"
+#include "storage/storage.h"
 #include <KConfig>
 #include <KConfigGroup>
+#include <QCoreApplication>
+#include <QThread>
 #include <QUrl>
 #include <TextUtils/ConvertText>
 
 #include <QRegularExpression>
 
+#include <algorithm>
+
 namespace Akregator
 {
 namespace Filters
@@ -23,6 +30,15 @@ AbstractMatcher::AbstractMatcher() = default;
 
 AbstractMatcher::~AbstractMatcher() = default;
 
+void AbstractMatcher::prepare() const
+{
+}
+
+bool AbstractMatcher::refines(const AbstractMatcher &other) const
+{
+    return *this == other;
+}
+
 QString Criterion::subjectToString(Subject subj)
 {
     switch (subj) {
@@ -100,6 +116,7 @@ Criterion::Criterion(Subject subject, Predicate predicate, const QVariant &objec
     , m_predicate(predicate)
     , m_object(object)
 {
+    compile();
 }
 
 void Criterion::writeConfig(KConfigGroup *config) const
@@ -122,59 +139,107 @@ void Criterion::readConfig(KConfigGroup *config)
     if (QMetaType::Type(type.id()) != QMetaType::UnknownType) {
         m_object = config->readEntry(QStringLiteral("objectValue"), QVariant(type));
     }
+    compile();
 }
 
-bool Criterion::satisfiedBy(const Article &article) const
+void Criterion::compile()
 {
-    if (article.isNull()) {
-        return false;
-    }
-
-    QVariant concreteSubject;
-
     switch (m_subject) {
     case Title:
-        concreteSubject = QVariant(article.title());
+        m_text = [](const Article &article) {
+            return article.title();
+        };
         break;
     case Description:
-        concreteSubject = QVariant(article.description());
+        m_text = [](const Article &article) {
+            return article.description();
+        };
         break;
     case Link:
         // ### Maybe use prettyUrl here?
-        concreteSubject = QVariant(article.link().url());
+        m_text = [](const Article &article) {
+            return article.link().url();
+        };
+        break;
+    case Author:
+        m_text = [](const Article &article) {
+            return article.authorName();
+        };
         break;
     case Status:
-        concreteSubject = QVariant(article.status());
+    case KeepFlag:
+        m_text = nullptr;
         break;
+    }
+
+    m_number = m_subject == KeepFlag ? m_object.toBool() : m_object.toInt();
+    m_needle = TextUtils::ConvertText::normalize(m_object.toString());
+    m_regExp = QRegularExpression();
+    if ((m_predicate & ~Negation) == Matches) {
+        m_regExp.setPattern(m_object.toString());
+        m_regExp.optimize();
+    }
+}
+
+int Criterion::cost() const
+{
+    int cost = 0;
+    switch (m_subject) {
+    case Status:
     case KeepFlag:
-        concreteSubject = QVariant(article.keep());
+        cost = 0;
+        break;
+    case Title:
+        cost = 2;
         break;
+    case Link:
     case Author:
-        concreteSubject = QVariant(article.authorName());
+        cost = 4;
+        break;
+    case Description:
+        cost = 6;
+        break;
     }
+    return (m_predicate & ~Negation) == Matches ? cost + 1 : cost;
+}
 
-    bool satisfied = false;
+bool Criterion::satisfiedBy(const Article &article) const
+{
+    if (article.isNull()) {
+        return false;
+    }
 
     const auto predicateType = static_cast<Predicate>(m_predicate & ~Negation);
-    QString subjectType = QLatin1StringView(concreteSubject.typeName());
+    bool satisfied = false;
 
-    switch (predicateType) {
-    case Contains:
-        satisfied = TextUtils::ConvertText::normalize(concreteSubject.toString()).indexOf(m_object.toString(), 0, Qt::CaseInsensitive) != -1;
-        break;
-    case Equals:
-        if (subjectType == QLatin1StringView("int")) {
-            satisfied = concreteSubject.toInt() == m_object.toInt();
+    if (!m_text && predicateType == Equals) {
+        const int value = m_subject == Status ? article.status() : article.keep();
+        satisfied = value == m_number;
+    } else {
+        QString text;
+        if (m_text) {
+            text = m_text(article);
+        } else if (m_subject == Status) {
+            text = QString::number(article.status());
         } else {
-            satisfied = TextUtils::ConvertText::normalize(concreteSubject.toString()) == m_object.toString();
+            text = article.keep() ? QStringLiteral("true") : QStringLiteral("false");
+        }
+        const QString subject = TextUtils::ConvertText::normalize(text);
+
+        switch (predicateType) {
+        case Contains:
+            satisfied = subject.contains(m_needle, Qt::CaseInsensitive);
+            break;
+        case Equals:
+            satisfied = subject == m_needle;
+            break;
+        case Matches:
+            satisfied = subject.contains(m_regExp);
+            break;
+        default:
+            qCDebug(AKREGATOR_LOG) << "Internal inconsistency; predicateType should never be Negation";
+            break;
         }
-        break;
-    case Matches:
-        satisfied = TextUtils::ConvertText::normalize(concreteSubject.toString()).contains(QRegularExpression(m_object.toString()));
-        break;
-    default:
-        qCDebug(AKREGATOR_LOG) << "Internal inconsistency; predicateType should never be Negation";
-        break;
     }
 
     if (m_predicate & Negation) {
@@ -210,6 +275,16 @@ ArticleMatcher::ArticleMatcher(const QList<Criterion> &criteria, Association ass
     : m_criteria(criteria)
     , m_association(assoc)
 {
+    compile();
+}
+
+void ArticleMatcher::compile()
+{
+    // the result does not depend on the order, so the criteria which do not hit the archive go first
+    m_plan = m_criteria;
+    std::stable_sort(m_plan.begin(), m_plan.end(), [](const Criterion &a, const Criterion &b) {
+        return a.cost() < b.cost();
+    });
 }
 
 bool ArticleMatcher::matches(const Article &a) const
@@ -255,6 +330,27 @@ void ArticleMatcher::readConfig(KConfigGroup *config)
         c.readConfig(config);
         m_criteria.append(c);
     }
+    compile();
+}
+
+bool ArticleMatcher::refines(const AbstractMatcher &other) const
+{
+    auto o = dynamic_cast<const ArticleMatcher *>(&other);
+    if (!o) {
+        return false;
+    }
+    if (o->m_association == None || o->m_criteria.isEmpty()) {
+        return true;
+    }
+    if (m_association != o->m_association || m_criteria.isEmpty()) {
+        return false;
+    }
+
+    const QList<Criterion> &fewer = m_association == LogicalOr ? m_criteria : o->m_criteria;
+    const QList<Criterion> &more = m_association == LogicalOr ? o->m_criteria : m_criteria;
+    return std::all_of(fewer.cbegin(), fewer.cend(), [&more](const Criterion &criterion) {
+        return more.contains(criterion);
+    });
 }
 
 bool ArticleMatcher::operator==(const AbstractMatcher &other) const
@@ -278,9 +374,8 @@ bool ArticleMatcher::anyCriterionMatches(const Article &a) const
     if (m_criteria.isEmpty()) {
         return true;
     }
-    const int criteriaSize(m_criteria.size());
-    for (int index = 0; index < criteriaSize; ++index) {
-        if (m_criteria.at(index).satisfiedBy(a)) {
+    for (const Criterion &criterion : m_plan) {
+        if (criterion.satisfiedBy(a)) {
             return true;
         }
     }
@@ -292,9 +387,8 @@ bool ArticleMatcher::allCriteriaMatch(const Article &a) const
     if (m_criteria.isEmpty()) {
         return true;
     }
-    const int criteriaSize(m_criteria.size());
-    for (int index = 0; index < criteriaSize; ++index) {
-        if (!m_criteria.at(index).satisfiedBy(a)) {
+    for (const Criterion &criterion : m_plan) {
+        if (!criterion.satisfiedBy(a)) {
             return false;
         }
     }
@@ -323,5 +417,94 @@ QString ArticleMatcher::associationToString(Association association)
         return QStringLiteral("None");
     }
 }
+FullTextMatcher::FullTextMatcher(const QString &text)
+    : m_text(text)
+    , m_matcher({Criterion(Criterion::Title, Criterion::Contains, text),
+                 Criterion(Criterion::Description, Criterion::Contains, text),
+                 Criterion(Criterion::Author, Criterion::Contains, text)},
+                ArticleMatcher::LogicalOr)
+{
+    const QStringList words = Backend::SearchIndex::words(text);
+    m_exact = words.size() == 1 && words.constFirst() == Backend::SearchIndex::fold(text);
+}
+
+FullTextMatcher::~FullTextMatcher() = default;
+
+std::shared_ptr<const FullTextMatcher::Lookup> FullTextMatcher::lookUp() const
+{
+    const QMutexLocker lock(&m_mutex);
+    Backend::Storage *const storage = Kernel::self()->storage();
+    // the index is only updated from the GUI thread, other threads use the last lookup
+    if (storage && QThread::currentThread() == qApp->thread()) {
+        // articles were added or changed since the last lookup
+        if (!m_lookup || m_lookup->generation != storage->searchIndex()->generation()) {
+            auto lookup = std::make_shared<Lookup>();
+            lookup->candidates = storage->searchArticles(m_text);
+            lookup->generation = storage->searchIndex()->generation();
+            m_lookup = lookup;
+        }
+    }
+    return m_lookup;
+}
+
+void FullTextMatcher::prepare() const
+{
+    if (!m_text.isEmpty()) {
+        (void)lookUp();
+    }
+}
+
+bool FullTextMatcher::matches(const Article &article) const
+{
+    const Feed *const feed = article.feed();
+    if (feed && !m_text.isEmpty()) {
+        const std::shared_ptr<const Lookup> lookup = lookUp();
+        if (lookup && lookup->candidates) {
+            const auto it = lookup->candidates->constFind(feed->xmlUrl());
+            if (it == lookup->candidates->cend() || !it->contains(article.guid())) {
+                return false;
+            }
+            if (m_exact) {
+                return true;
+            }
+        }
+    }
+    return m_matcher.matches(article);
+}
+
+bool FullTextMatcher::refines(const AbstractMatcher &other) const
+{
+    auto o = dynamic_cast<const FullTextMatcher *>(&other);
+    if (!o || m_text.isEmpty() || o->m_text.isEmpty()) {
+        return *this == other;
+    }
+    // a field containing the longer text contains the shorter one as well
+    return m_text.contains(o->m_text, Qt::CaseInsensitive);
+}
+
+bool FullTextMatcher::operator==(const AbstractMatcher &other) const
+{
+    auto o = dynamic_cast<const FullTextMatcher *>(&other);
+    return o && m_text == o->m_text && m_matcher == o->m_matcher;
+}
+
+bool FullTextMatcher::operator!=(const AbstractMatcher &other) const
+{
+    return !(*this == other);
+}
+
+void FullTextMatcher::writeConfig(KConfigGroup *config) const
+{
+    m_matcher.writeConfig(config);
+}
+
+void FullTextMatcher::readConfig(KConfigGroup *config)
+{
+    m_matcher.readConfig(config);
+    m_text.clear();
+    m_exact = false;
+    const QMutexLocker lock(&m_mutex);
+    m_lookup.reset();
+}
 } // namespace Filters
 } // namespace Akregator
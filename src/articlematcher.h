@@ -9,10 +9,16 @@
 #pragma once
 
 #include "akregatorpart_export.h"
+#include "storage/searchindex.h"
 #include <QList>
+#include <QMutex>
+#include <QRegularExpression>
 #include <QString>
 #include <QVariant>
 
+#include <memory>
+#include <optional>
+
 class KConfigGroup;
 
 namespace Akregator
@@ -34,6 +40,15 @@ public:
 
     virtual bool matches(const Article &article) const = 0;
 
+    /** called on the GUI thread before matches() is called from other threads, to prepare
+        whatever must not be done there. Does nothing by default. */
+    virtual void prepare() const;
+
+    /** returns whether every article matching this matcher also matches @p other, so that
+        filtering with it only has to look at the articles @p other accepted.
+        By default only equal matchers are recognized. */
+    [[nodiscard]] virtual bool refines(const AbstractMatcher &other) const;
+
     virtual void writeConfig(KConfigGroup *config) const = 0;
     virtual void readConfig(KConfigGroup *config) = 0;
 
@@ -65,6 +80,9 @@ public:
     ~ArticleMatcher() override;
 
     bool matches(const Article &article) const override;
+    /** true if @p other matches everything, or this matcher has a subset of its criteria
+        (LogicalOr) or a superset of them (LogicalAnd) */
+    [[nodiscard]] bool refines(const AbstractMatcher &other) const override;
     bool operator==(const AbstractMatcher &other) const override;
     bool operator!=(const AbstractMatcher &other) const override;
 
@@ -77,11 +95,58 @@ private:
 
     [[nodiscard]] bool anyCriterionMatches(const Article &a) const;
     [[nodiscard]] bool allCriteriaMatch(const Article &a) const;
+    /** sorts the criteria cheapest first into m_plan */
+    void compile();
 
     QList<Criterion> m_criteria;
+    /** m_criteria in evaluation order */
+    QList<Criterion> m_plan;
     Association m_association;
 };
 
+/** matches articles whose title, description or author contains a text, like an ArticleMatcher
+ *  with one Contains criterion per field. The candidates are looked up in the search index of the
+ *  archive first, so that only they have to be loaded and compared.
+ */
+class AKREGATORPART_EXPORT FullTextMatcher : public AbstractMatcher
+{
+public:
+    /** @param text the search text, normalized by TextUtils::ConvertText::normalize() */
+    explicit FullTextMatcher(const QString &text);
+    ~FullTextMatcher() override;
+
+    bool matches(const Article &article) const override;
+    /** looks the text up in the search index */
+    void prepare() const override;
+    /** true if the text of @p other is part of this one */
+    [[nodiscard]] bool refines(const AbstractMatcher &other) const override;
+    bool operator==(const AbstractMatcher &other) const override;
+    bool operator!=(const AbstractMatcher &other) const override;
+
+    /** writes the criteria of the equivalent ArticleMatcher */
+    void writeConfig(KConfigGroup *config) const override;
+    /** reads the criteria of an ArticleMatcher, which are then checked without the index */
+    void readConfig(KConfigGroup *config) override;
+
+private:
+    /** the result of a lookup, and the state of the index it belongs to */
+    struct Lookup {
+        std::optional<Backend::SearchIndex::Matches> candidates;
+        uint generation = 0;
+    };
+
+    /** returns the current lookup, repeating it first if the index changed and this is the GUI thread */
+    [[nodiscard]] std::shared_ptr<const Lookup> lookUp() const;
+
+    QString m_text;
+    ArticleMatcher m_matcher;
+    /** true if the text is a single word: the index then finds exactly the matching articles */
+    bool m_exact = false;
+    /** guards m_lookup, matches() may run on several threads at once */
+    mutable QMutex m_mutex;
+    mutable std::shared_ptr<const Lookup> m_lookup;
+};
+
 /** Criterion for ArticleMatcher
  *  @author Frerich Raabe
  */
@@ -127,10 +192,27 @@ public:
         return m_subject == other.m_subject && m_predicate == other.m_predicate && m_object == other.m_object;
     }
 
+    /** relative cost of satisfiedBy(): fields cached in Article are cheap, the others are read from the archive */
+    [[nodiscard]] int cost() const;
+
 private:
+    using TextAccessor = QString (*)(const Article &);
+
+    /** prepares everything satisfiedBy() needs which does not depend on the article */
+    void compile();
+
     Subject m_subject;
     Predicate m_predicate;
     QVariant m_object;
+
+    /** reads the subject, nullptr for Status and KeepFlag */
+    TextAccessor m_text = nullptr;
+    /** m_object normalized, for Contains and Equals */
+    QString m_needle;
+    /** m_object as integer, for Equals on Status and KeepFlag */
+    int m_number = 0;
+    /** m_object compiled, for Matches */
+    QRegularExpression m_regExp;
 };
 } // namespace Filters
 } // namespace Akregator
@@ -16,6 +16,7 @@
 
 #include <QList>
 #include <QMimeData>
+#include <QSet>
 #include <QString>
 
 #include <KLocalizedString>
@@ -24,6 +25,7 @@
 #include <memory>
 
 #include <QLocale>
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 
@@ -46,9 +48,13 @@ ArticleModel::ArticleModel(const QList<Article> &articles, QObject *parent)
 {
     const int articlesCount(articles.count());
     m_titleCache.resize(articlesCount);
+    m_rowStates.resize(articlesCount);
     for (int i = 0; i < articlesCount; ++i) {
         m_titleCache[i] = stripHtml(articles[i].title());
+        m_rowStates[i] = rowState(articles[i]);
     }
+    m_rowIndex.reserve(articlesCount);
+    indexRows(0);
 }
 
 ArticleModel::~ArticleModel() = default;
@@ -139,9 +145,58 @@ void ArticleModel::clear()
     beginResetModel();
     m_articles.clear();
     m_titleCache.clear();
+    m_rowStates.clear();
+    m_rowIndex.clear();
     endResetModel();
 }
 
+ArticleModel::RowState ArticleModel::rowState(const Article &article)
+{
+    RowState state;
+    state.hash = article.hash();
+    state.status = article.status();
+    state.keep = article.keep();
+    state.deleted = article.isDeleted();
+    return state;
+}
+
+QList<int> ArticleModel::changedRoles(int changes)
+{
+    if (changes & ContentChange) {
+        return {};
+    }
+    // the article list's proxies derive the foreground color and the keep flag icon from these
+    QList<int> roles;
+    if (changes & StatusChange) {
+        roles << StatusRole << Qt::ForegroundRole;
+    }
+    if (changes & KeepChange) {
+        roles << IsImportantRole << Qt::DecorationRole;
+    }
+    if (changes & DeletedChange) {
+        roles << IsDeletedRole;
+    }
+    return roles;
+}
+
+ArticleModel::RowKey ArticleModel::rowKey(const Article &article)
+{
+    return {article.feed(), article.guid()};
+}
+
+int ArticleModel::rowOf(const Article &article) const
+{
+    return m_rowIndex.value(rowKey(article), -1);
+}
+
+void ArticleModel::indexRows(int first)
+{
+    const int count = m_articles.count();
+    for (int i = first; i < count; ++i) {
+        m_rowIndex.insert(rowKey(m_articles[i]), i);
+    }
+}
+
 void ArticleModel::articlesAdded(Akregator::TreeNode *, const QList<Article> &l)
 {
     if (l.isEmpty()) { // assert?
@@ -155,43 +210,109 @@ void ArticleModel::articlesAdded(Akregator::TreeNode *, const QList<Article> &l)
 
     const int newArticlesCount(m_articles.count());
     m_titleCache.resize(newArticlesCount);
+    m_rowStates.resize(newArticlesCount);
     for (int i = oldSize; i < newArticlesCount; ++i) {
         m_titleCache[i] = stripHtml(m_articles[i].title());
+        m_rowStates[i] = rowState(m_articles[i]);
     }
+    indexRows(oldSize);
     endInsertRows();
 }
 
 void ArticleModel::articlesRemoved(Akregator::TreeNode *, const QList<Article> &l)
 {
-    // might want to avoid indexOf() in case of performance problems
+    QList<int> rows;
+    rows.reserve(l.size());
     for (const Article &i : l) {
-        const int row = m_articles.indexOf(i);
-        Q_ASSERT(row != -1);
-        removeRow(row, QModelIndex());
+        const int row = rowOf(i);
+        if (row != -1) {
+            rows.append(row);
+        }
     }
+    if (rows.isEmpty()) {
+        return;
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    for (const Article &i : l) {
+        m_rowIndex.remove(rowKey(i));
+    }
+
+    // remove contiguous ranges, starting at the end so that the rows before stay valid
+    qsizetype end = rows.size();
+    while (end > 0) {
+        qsizetype begin = end - 1;
+        while (begin > 0 && rows.at(begin - 1) == rows.at(begin) - 1) {
+            --begin;
+        }
+        const int first = rows.at(begin);
+        const int last = rows.at(end - 1);
+        beginRemoveRows(QModelIndex(), first, last);
+        m_articles.remove(first, last - first + 1);
+        m_titleCache.remove(first, last - first + 1);
+        m_rowStates.remove(first, last - first + 1);
+        endRemoveRows();
+        end = begin;
+    }
+    indexRows(rows.constFirst());
 }
 
 void ArticleModel::articlesUpdated(Akregator::TreeNode *, const QList<Article> &l)
 {
-    int rmin = 0;
-    int rmax = 0;
-
-    const int numberOfArticles(m_articles.count());
-    if (numberOfArticles > 0) {
-        rmin = numberOfArticles - 1;
-        // might want to avoid indexOf() in case of performance problems
-        for (const Article &i : l) {
-            const int row = m_articles.indexOf(i);
-            // TODO: figure out how why the Article might not be found in
-            // TODO: the articles list because we should need this conditional.
-            if (row >= 0) {
-                m_titleCache[row] = stripHtml(m_articles[row].title());
-                rmin = std::min(row, rmin);
-                rmax = std::max(row, rmax);
-            }
+    // changed rows and what changed in them
+    QList<std::pair<int, int>> changed;
+    changed.reserve(l.size());
+    QSet<int> seen;
+    for (const Article &i : l) {
+        const int row = rowOf(i);
+        // TODO: figure out how why the Article might not be found in
+        // TODO: the articles list because we should need this conditional.
+        if (row < 0 || seen.contains(row)) {
+            continue;
+        }
+        seen.insert(row);
+        const Article &article = m_articles[row];
+        const RowState state = rowState(article);
+        const RowState &old = m_rowStates[row];
+        QString title = stripHtml(article.title());
+        int changes = 0;
+        if (state.hash != old.hash || title != m_titleCache[row]) {
+            changes |= ContentChange;
         }
+        if (state.status != old.status) {
+            changes |= StatusChange;
+        }
+        if (state.keep != old.keep) {
+            changes |= KeepChange;
+        }
+        if (state.deleted != old.deleted) {
+            changes |= DeletedChange;
+        }
+        // something not tracked here changed, e.g. the enclosure
+        if (changes == 0) {
+            changes = ContentChange;
+        }
+        m_titleCache[row] = std::move(title);
+        m_rowStates[row] = state;
+        changed.append({row, changes});
+    }
+    if (changed.isEmpty()) {
+        return;
+    }
+    std::sort(changed.begin(), changed.end());
+
+    // one signal per run of adjacent rows with the same changes
+    qsizetype begin = 0;
+    while (begin < changed.size()) {
+        const int changes = changed.at(begin).second;
+        qsizetype end = begin + 1;
+        while (end < changed.size() && changed.at(end).first == changed.at(end - 1).first + 1 && changed.at(end).second == changes) {
+            ++end;
+        }
+        Q_EMIT dataChanged(index(changed.at(begin).first, 0), index(changed.at(end - 1).first, ColumnCount - 1), changedRoles(changes));
+        begin = end;
     }
-    Q_EMIT dataChanged(index(rmin, 0), index(rmax, ColumnCount - 1));
 }
 
 bool ArticleModel::rowMatches(int row, const QSharedPointer<const Filters::AbstractMatcher> &matcher) const
@@ -208,6 +329,11 @@ Article ArticleModel::article(int row) const
     return m_articles[row];
 }
 
+QList<Article> ArticleModel::articles() const
+{
+    return m_articles;
+}
+
 QStringList ArticleModel::mimeTypes() const
 {
     return {QStringLiteral("text/uri-list")};
@@ -12,10 +12,14 @@
 #include "akregatorpart_export.h"
 #include "article.h"
 
+#include <QHash>
 #include <QSharedPointer>
 
+#include <utility>
+
 namespace Akregator
 {
+class Feed;
 class TreeNode;
 
 namespace Filters
@@ -64,6 +68,9 @@ public:
 
     [[nodiscard]] Article article(int row) const;
 
+    /** returns the articles of all rows, in row order */
+    [[nodiscard]] QList<Article> articles() const;
+
     [[nodiscard]] QStringList mimeTypes() const override;
 
     QMimeData *mimeData(const QModelIndexList &indexes) const override;
@@ -81,7 +88,37 @@ private:
     ArticleModel(const ArticleModel &);
     ArticleModel &operator=(const ArticleModel &);
 
+    /** what changed in an updated row */
+    enum Change {
+        StatusChange = 0x1,
+        KeepChange = 0x2,
+        DeletedChange = 0x4,
+        ContentChange = 0x8,
+    };
+
+    /** the values of a row which updates are compared against */
+    struct RowState {
+        uint hash = 0;
+        int status = 0;
+        bool keep = false;
+        bool deleted = false;
+    };
+
+    [[nodiscard]] static RowState rowState(const Article &article);
+    /** returns the roles affected by @p changes, an empty list meaning all of them */
+    [[nodiscard]] static QList<int> changedRoles(int changes);
+
+    using RowKey = std::pair<const Feed *, QString>;
+    [[nodiscard]] static RowKey rowKey(const Article &article);
+    /** returns the row of @p article, or -1 */
+    [[nodiscard]] int rowOf(const Article &article) const;
+    /** updates m_rowIndex for the rows starting at @p first */
+    void indexRows(int first);
+
     QList<Article> m_articles;
     QList<QString> m_titleCache;
+    QList<RowState> m_rowStates;
+    /** row of every article, by feed and guid */
+    QHash<RowKey, int> m_rowIndex;
 };
 } // namespace Akregator
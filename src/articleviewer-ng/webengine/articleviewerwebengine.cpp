@@ -32,6 +32,8 @@
 #include <QClipboard>
 #include <QFileDialog>
 #include <QIcon>
+#include <QJsonArray>
+#include <QJsonDocument>
 #include <QMenu>
 #include <QMouseEvent>
 #include <QPrinter>
@@ -128,6 +130,41 @@ void ArticleViewerWebEngine::printPreviewPage(QPrinter *printer)
     print(printer);
 }
 
+void ArticleViewerWebEngine::updateArticleElements(const QJsonArray &changes, const std::function<void()> &done)
+{
+    // JavaScript is disabled for the articles, this runs in a world of its own
+    static const QString script = QStringLiteral(
+        "(function(changes) {"
+        "    const list = document.getElementById('articles');"
+        "    if (!list) {"
+        "        return;"
+        "    }"
+        "    const find = token => Array.prototype.find.call(list.children, element => element.dataset.article === token);"
+        "    const parse = html => {"
+        "        const template = document.createElement('template');"
+        "        template.innerHTML = html;"
+        "        return template.content;"
+        "    };"
+        "    for (const change of changes) {"
+        "        if (change.op === 'insert') {"
+        "            list.insertBefore(parse(change.html), (change.before && find(change.before)) || null);"
+        "            continue;"
+        "        }"
+        "        const element = find(change.article);"
+        "        if (element) {"
+        "            element.remove();"
+        "        }"
+        "    }"
+        "})(");
+    page()->runJavaScript(script + QString::fromUtf8(QJsonDocument(changes).toJson(QJsonDocument::Compact)) + QStringLiteral(");"),
+                          WebEngineViewer::WebEngineManageScript::scriptWordId(),
+                          [done](const QVariant &) {
+                              if (done) {
+                                  done();
+                              }
+                          });
+}
+
 void ArticleViewerWebEngine::updateSecurity()
 {
     mExternalReference->setAllowExternalContent(Settings::self()->loadExternalReferences());
@@ -12,7 +12,10 @@
 #include <WebEngineViewer/CheckPhishingUrlJob>
 #include <WebEngineViewer/WebEngineView>
 
+#include <functional>
+
 class KActionCollection;
+class QJsonArray;
 namespace WebEngineViewer
 {
 class WebHitTestResult;
@@ -65,6 +68,12 @@ public:
 
     void printPreviewPage(QPrinter *printer);
 
+    /** applies @p changes to the article elements of the combined view, see combinedview.html.
+        Each change is an object with an "op": "remove" the element of "article", or "insert"
+        the "html" before the element of "before", at the end if there is none.
+        @p done is called once the changes were applied. */
+    void updateArticleElements(const QJsonArray &changes, const std::function<void()> &done = {});
+
 protected:
     QUrl mCurrentUrl;
     KActionCollection *const mActionCollection;
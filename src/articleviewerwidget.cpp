@@ -13,6 +13,7 @@
 #include "akregator_debug.h"
 #include "akregatorconfig.h"
 #include "articleformatter.h"
+#include "articlegrantleeobject.h"
 #include "articlejobs.h"
 #include "feed.h"
 #include "openurlrequest.h"
@@ -21,6 +22,11 @@
 #include <KActionCollection>
 
 #include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QPointer>
+#include <QSet>
+#include <QWebEnginePage>
 
 #include "articleviewer-ng/webengine/articlehtmlwebenginewriter.h"
 #include "articleviewer-ng/webengine/articleviewerwebengine.h"
@@ -34,6 +40,12 @@
 using namespace Akregator;
 using namespace Akregator::Filters;
 
+namespace
+{
+/** articles added to the combined view at a time */
+constexpr qsizetype combinedViewPageSize = 25;
+}
+
 ArticleViewerWidget::ArticleViewerWidget(KActionCollection *ac, QWidget *parent)
     : QWidget(parent)
     , m_node(nullptr)
@@ -45,6 +57,20 @@ ArticleViewerWidget::ArticleViewerWidget(KActionCollection *ac, QWidget *parent)
     m_articleHtmlWriter = new Akregator::ArticleHtmlWebEngineWriter(m_articleViewerWidgetNg->articleViewerNg(), this);
     connect(m_articleViewerWidgetNg->articleViewerNg(), &ArticleViewerWebEngine::signalOpenUrlRequest, this, &ArticleViewerWidget::signalOpenUrlRequest);
     connect(m_articleViewerWidgetNg->articleViewerNg(), &ArticleViewerWebEngine::showStatusBarMessage, this, &ArticleViewerWidget::showStatusBarMessage);
+
+    QWebEnginePage *page = m_articleViewerWidgetNg->articleViewerNg()->page();
+    connect(page, &QWebEnginePage::scrollPositionChanged, this, &ArticleViewerWidget::slotFillCombinedView);
+    connect(page, &QWebEnginePage::contentsSizeChanged, this, [this]() {
+        m_combinedViewAppending = false;
+        slotFillCombinedView();
+    });
+    connect(page, &QWebEnginePage::loadFinished, this, [this](bool ok) {
+        // a failed load must not block the next patches either
+        m_combinedViewLoading = false;
+        if (ok) {
+            slotFillCombinedView();
+        }
+    });
 }
 
 ArticleViewerWidget::~ArticleViewerWidget() = default;
@@ -57,10 +83,10 @@ QSharedPointer<ArticleFormatter> ArticleViewerWidget::normalViewFormatter()
     return m_normalViewFormatter;
 }
 
-QSharedPointer<ArticleFormatter> ArticleViewerWidget::combinedViewFormatter()
+QSharedPointer<DefaultCombinedViewFormatter> ArticleViewerWidget::combinedViewFormatter()
 {
     if (!m_combinedViewFormatter.data()) {
-        m_combinedViewFormatter = QSharedPointer<ArticleFormatter>(new DefaultCombinedViewFormatter(m_articleViewerWidgetNg->articleViewerNg()));
+        m_combinedViewFormatter = QSharedPointer<DefaultCombinedViewFormatter>(new DefaultCombinedViewFormatter(m_articleViewerWidgetNg->articleViewerNg()));
     }
     return m_combinedViewFormatter;
 }
@@ -94,7 +120,7 @@ void ArticleViewerWidget::connectToNode(TreeNode *node)
 {
     if (node) {
         if (m_viewMode == CombinedView) {
-            connect(node, &TreeNode::signalChanged, this, &ArticleViewerWidget::slotUpdateCombinedView);
+            connect(node, &TreeNode::signalChanged, this, &ArticleViewerWidget::slotSyncCombinedView);
             connect(node, &TreeNode::signalArticlesAdded, this, &ArticleViewerWidget::slotArticlesAdded);
             connect(node, &TreeNode::signalArticlesRemoved, this, &ArticleViewerWidget::slotArticlesRemoved);
             connect(node, &TreeNode::signalArticlesUpdated, this, &ArticleViewerWidget::slotArticlesUpdated);
@@ -193,6 +219,7 @@ void ArticleViewerWidget::setFilters(const std::vector<QSharedPointer<const Abst
 
     m_filters = filters;
 
+    m_renderedArticles.clear();
     slotUpdateCombinedView();
 }
 
@@ -207,12 +234,12 @@ void ArticleViewerWidget::slotUpdateCombinedView()
     }
 
     m_articleViewerWidgetNg->saveCurrentPosition();
-    QString text;
-
-    int num = 0;
-    QElapsedTimer spent;
-    spent.start();
+    // render as far as the view was scrolled, so that the position can be restored
+    renderCombinedView(std::max(m_renderedArticles.size(), combinedViewPageSize));
+}
 
+QList<Article> ArticleViewerWidget::filteredArticles() const
+{
     const auto filterEnd = m_filters.cend();
 
     QList<Article> articles;
@@ -228,20 +255,129 @@ void ArticleViewerWidget::slotUpdateCombinedView()
             continue;
         }
         articles << i;
-        ++num;
     }
-    text = combinedViewFormatter()->formatArticles(articles, ArticleFormatter::NoIcon);
+    return articles;
+}
+
+void ArticleViewerWidget::renderCombinedView(qsizetype count)
+{
+    QElapsedTimer spent;
+    spent.start();
 
-    qCDebug(AKREGATOR_LOG) << "Combined view rendering: (" << num << " articles):"
+    m_shownArticles = filteredArticles();
+    m_renderedArticles = m_shownArticles.mid(0, count);
+    const QString text = combinedViewFormatter()->formatArticles(m_renderedArticles, ArticleFormatter::NoIcon);
+
+    qCDebug(AKREGATOR_LOG) << "Combined view rendering: (" << m_renderedArticles.size() << "of" << m_shownArticles.size() << " articles):"
                            << "generating HTML:" << spent.elapsed() << "ms";
+    m_combinedViewLoading = true;
+    m_combinedViewAppending = false;
     renderContent(text);
     qCDebug(AKREGATOR_LOG) << "HTML rendering:" << spent.elapsed() << "ms";
 }
 
-void ArticleViewerWidget::slotArticlesUpdated(TreeNode * /*node*/, const QList<Article> & /*list*/)
+void ArticleViewerWidget::syncCombinedView(const QList<Article> &updated)
+{
+    if (m_viewMode != CombinedView || !m_node) {
+        return;
+    }
+
+    const qsizetype count = std::max(m_renderedArticles.size(), combinedViewPageSize);
+    if (m_combinedViewLoading) {
+        renderCombinedView(count);
+        return;
+    }
+
+    m_shownArticles = filteredArticles();
+    const QList<Article> rendered = m_shownArticles.mid(0, count);
+
+    QStringList tokens;
+    tokens.reserve(rendered.size());
+    for (const Article &article : rendered) {
+        tokens << ArticleGrantleeObject::actionToken(article);
+    }
+    const QSet<QString> wanted(tokens.cbegin(), tokens.cend());
+    QSet<QString> changed;
+    for (const Article &article : updated) {
+        changed.insert(ArticleGrantleeObject::actionToken(article));
+    }
+
+    // drop what is gone or outdated, then insert the missing articles in runs before the next kept one
+    QJsonArray changes;
+    QSet<QString> kept;
+    for (const Article &article : std::as_const(m_renderedArticles)) {
+        const QString token = ArticleGrantleeObject::actionToken(article);
+        if (wanted.contains(token) && !changed.contains(token)) {
+            kept.insert(token);
+        } else {
+            changes.append(QJsonObject{{QStringLiteral("op"), QStringLiteral("remove")}, {QStringLiteral("article"), token}});
+        }
+    }
+    for (qsizetype i = 0; i < rendered.size();) {
+        if (kept.contains(tokens.at(i))) {
+            ++i;
+            continue;
+        }
+        qsizetype end = i + 1;
+        while (end < rendered.size() && !kept.contains(tokens.at(end))) {
+            ++end;
+        }
+        changes.append(QJsonObject{
+            {QStringLiteral("op"), QStringLiteral("insert")},
+            {QStringLiteral("before"), end < rendered.size() ? tokens.at(end) : QString()},
+            {QStringLiteral("html"), combinedViewFormatter()->formatArticleFragments(rendered.mid(i, end - i), ArticleFormatter::NoIcon)},
+        });
+        i = end;
+    }
+
+    m_renderedArticles = rendered;
+    if (!changes.isEmpty()) {
+        m_articleViewerWidgetNg->articleViewerNg()->updateArticleElements(changes);
+    }
+}
+
+void ArticleViewerWidget::slotSyncCombinedView()
+{
+    syncCombinedView({});
+}
+
+void ArticleViewerWidget::slotFillCombinedView()
+{
+    if (m_viewMode != CombinedView || m_combinedViewLoading || m_combinedViewAppending || m_renderedArticles.size() >= m_shownArticles.size()) {
+        return;
+    }
+
+    ArticleViewerWebEngine *viewer = m_articleViewerWidgetNg->articleViewerNg();
+    const QWebEnginePage *page = viewer->page();
+    // keep another screen of articles below the visible ones
+    const qreal screen = viewer->height() / page->zoomFactor();
+    if (page->scrollPosition().y() + 2 * screen < page->contentsSize().height()) {
+        return;
+    }
+
+    const QList<Article> articles = m_shownArticles.mid(m_renderedArticles.size(), combinedViewPageSize);
+    m_renderedArticles += articles;
+    m_combinedViewAppending = true;
+    // the page does not grow if the script failed, so do not wait for its size to change
+    const QPointer<ArticleViewerWidget> guard(this);
+    viewer->updateArticleElements(
+        {QJsonObject{
+            {QStringLiteral("op"), QStringLiteral("insert")},
+            {QStringLiteral("html"), combinedViewFormatter()->formatArticleFragments(articles, ArticleFormatter::NoIcon)},
+        }},
+        [guard]() {
+            if (guard) {
+                guard->m_combinedViewAppending = false;
+            }
+        });
+}
+
+void ArticleViewerWidget::slotArticlesUpdated(TreeNode * /*node*/, const QList<Article> &list)
 {
     if (m_viewMode == CombinedView) {
-        slotUpdateCombinedView();
+        // an updated article may have a new date
+        std::sort(m_articles.begin(), m_articles.end());
+        syncCombinedView(list);
     }
 }
 
@@ -251,7 +387,7 @@ void ArticleViewerWidget::slotArticlesAdded(TreeNode * /*node*/, const QList<Art
         // TODO sort list, then merge
         m_articles << list;
         std::sort(m_articles.begin(), m_articles.end());
-        slotUpdateCombinedView();
+        syncCombinedView({});
     }
 }
 
@@ -260,7 +396,7 @@ void ArticleViewerWidget::slotArticlesRemoved(TreeNode * /*node*/, const QList<A
     Q_UNUSED(list)
 
     if (m_viewMode == CombinedView) {
-        slotUpdateCombinedView();
+        syncCombinedView({});
     }
 }
 
@@ -270,6 +406,8 @@ void ArticleViewerWidget::slotClear()
     m_node = nullptr;
     m_article = Article();
     m_articles.clear();
+    m_shownArticles.clear();
+    m_renderedArticles.clear();
 
     renderContent(QString());
 }
@@ -285,6 +423,8 @@ void ArticleViewerWidget::showNode(TreeNode *node)
     connectToNode(node);
 
     m_articles.clear();
+    m_shownArticles.clear();
+    m_renderedArticles.clear();
     m_article = Article();
     m_node = node;
 
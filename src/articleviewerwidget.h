@@ -28,6 +28,7 @@ namespace Akregator
 
 class ArticleFormatter;
 class ArticleListJob;
+class DefaultCombinedViewFormatter;
 class OpenUrlRequest;
 class TreeNode;
 class ArticleHtmlWebEngineWriter;
@@ -105,9 +106,14 @@ protected Q_SLOTS:
     void slotArticlesAdded(Akregator::TreeNode *node, const QList<Akregator::Article> &list);
     void slotArticlesRemoved(Akregator::TreeNode *node, const QList<Akregator::Article> &list);
 
+    /** brings the combined view up to date with the articles and filters, without reloading it */
+    void slotSyncCombinedView();
+    /** appends the next articles when the combined view is scrolled close to its end */
+    void slotFillCombinedView();
+
     // from ArticleViewer
 private:
-    QSharedPointer<ArticleFormatter> combinedViewFormatter();
+    QSharedPointer<DefaultCombinedViewFormatter> combinedViewFormatter();
     QSharedPointer<ArticleFormatter> normalViewFormatter();
     void keyPressEvent(QKeyEvent *e) override;
 
@@ -127,12 +133,27 @@ private:
 
     void setArticleActionsEnabled(bool enabled);
 
+    /** returns the articles of the node which are not deleted and pass the filters */
+    [[nodiscard]] QList<Article> filteredArticles() const;
+    /** loads the combined view with the first @p count articles */
+    void renderCombinedView(qsizetype count);
+    /** patches the combined view in place; the elements of @p updated are rendered again */
+    void syncCombinedView(const QList<Article> &updated);
+
 private:
     QString m_currentText;
     QPointer<TreeNode> m_node;
     QPointer<ArticleListJob> m_listJob;
     Article m_article;
     QList<Article> m_articles;
+    /** the articles of the combined view, i.e. m_articles filtered */
+    QList<Article> m_shownArticles;
+    /** the leading part of m_shownArticles which is in the page */
+    QList<Article> m_renderedArticles;
+    /** true until the page of the combined view finished loading, it cannot be patched before */
+    bool m_combinedViewLoading = false;
+    /** true while articles are being appended to the page */
+    bool m_combinedViewAppending = false;
     QUrl m_link;
     std::vector<QSharedPointer<const Filters::AbstractMatcher>> m_filters;
     enum ViewMode {
@@ -144,6 +165,6 @@ private:
     Akregator::ArticleHtmlWebEngineWriter *m_articleHtmlWriter = nullptr;
     Akregator::ArticleViewerWebEngineWidgetNg *const m_articleViewerWidgetNg;
     QSharedPointer<ArticleFormatter> m_normalViewFormatter;
-    QSharedPointer<ArticleFormatter> m_combinedViewFormatter;
+    QSharedPointer<DefaultCombinedViewFormatter> m_combinedViewFormatter;
 };
 } // namespace Akregator
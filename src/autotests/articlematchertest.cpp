@@ -0,0 +1,257 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "articlematchertest.h"
+#include "articlematcher.h"
+#include "storage/feedstorage.h"
+#include "storage/storage.h"
+
+#include <QTest>
+#include <TextUtils/ConvertText>
+
+using namespace Akregator;
+using Akregator::Filters::ArticleMatcher;
+using Akregator::Filters::Criterion;
+using Akregator::Filters::FullTextMatcher;
+
+QTEST_MAIN(ArticleMatcherTest)
+
+namespace
+{
+/** cheap and expensive criteria, so that the plan reorders them */
+const QList<Criterion> criteria = {
+    Criterion(Criterion::Description, Criterion::Contains, QStringLiteral("rain")),
+    Criterion(Criterion::Title, Criterion::Contains, QStringLiteral("kde")),
+    Criterion(Criterion::Author, static_cast<Criterion::Predicate>(Criterion::Contains | Criterion::Negation), QStringLiteral("jane")),
+    Criterion(Criterion::Status, Criterion::Equals, int(Read)),
+    Criterion(Criterion::Link, Criterion::Matches, QStringLiteral("example\\.org")),
+    Criterion(Criterion::KeepFlag, Criterion::Equals, true),
+    Criterion(Criterion::Title, Criterion::Matches, QStringLiteral("^re")),
+    Criterion(Criterion::Description, Criterion::Equals, QString()),
+};
+
+[[nodiscard]] QList<Criterion> pick(const QList<int> &indexes)
+{
+    QList<Criterion> result;
+    for (const int index : indexes) {
+        result.append(criteria.at(index));
+    }
+    return result;
+}
+
+/** Criterion::satisfiedBy() as it was before the criteria were compiled */
+[[nodiscard]] bool satisfiedBy(const Criterion &criterion, const Article &article)
+{
+    QVariant subject;
+    switch (criterion.subject()) {
+    case Criterion::Title:
+        subject = article.title();
+        break;
+    case Criterion::Description:
+        subject = article.description();
+        break;
+    case Criterion::Link:
+        subject = article.link().url();
+        break;
+    case Criterion::Status:
+        subject = article.status();
+        break;
+    case Criterion::KeepFlag:
+        subject = article.keep();
+        break;
+    case Criterion::Author:
+        subject = article.authorName();
+        break;
+    }
+
+    const QString text = TextUtils::ConvertText::normalize(subject.toString());
+    const QString object = criterion.object().toString();
+    bool satisfied = false;
+    switch (criterion.predicate() & ~Criterion::Negation) {
+    case Criterion::Contains:
+        satisfied = text.contains(object, Qt::CaseInsensitive);
+        break;
+    case Criterion::Equals:
+        satisfied = subject.typeId() == QMetaType::Int ? subject.toInt() == criterion.object().toInt() : text == object;
+        break;
+    case Criterion::Matches:
+        satisfied = text.contains(QRegularExpression(object));
+        break;
+    }
+    return criterion.predicate() & Criterion::Negation ? !satisfied : satisfied;
+}
+
+/** ArticleMatcher::matches(), checking the criteria in the given order */
+[[nodiscard]] bool matches(const QList<Criterion> &criteria, ArticleMatcher::Association association, const Article &article)
+{
+    const auto satisfied = [&article](const Criterion &criterion) {
+        return satisfiedBy(criterion, article);
+    };
+    switch (association) {
+    case ArticleMatcher::LogicalAnd:
+        return std::all_of(criteria.cbegin(), criteria.cend(), satisfied);
+    case ArticleMatcher::LogicalOr:
+        return criteria.isEmpty() || std::any_of(criteria.cbegin(), criteria.cend(), satisfied);
+    case ArticleMatcher::None:
+        break;
+    }
+    return true;
+}
+}
+
+ArticleMatcherTest::ArticleMatcherTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ArticleMatcherTest::~ArticleMatcherTest() = default;
+
+void ArticleMatcherTest::initTestCase()
+{
+    QVERIFY(mArchiveDir.isValid());
+    mStorage = std::make_unique<Backend::Storage>();
+    mStorage->setArchivePath(mArchiveDir.path());
+    QVERIFY(mStorage->open(true));
+    Backend::FeedStorage *const archive = mStorage->archiveFor(QStringLiteral("https://example.org/feed"));
+
+    struct Data {
+        QString title;
+        QString description;
+        QString author;
+        QString link;
+        int status;
+        bool keep;
+    };
+    const QList<Data> articles = {
+        {QStringLiteral("Release of KDE"), QStringLiteral("The KDE community released"), QStringLiteral("Jane"), QStringLiteral("https://example.org/1"), New, true},
+        {QStringLiteral("Weather report"), QStringLiteral("Rain, then more rain"), QStringLiteral("John"), QStringLiteral("https://other.org/2"), Read, false},
+        {QStringLiteral("Re: KDE"), QString(), QString(), QStringLiteral("https://example.org/3"), Unread, false},
+        {QStringLiteral("Crème brûlée"), QStringLiteral("Raining desserts"), QStringLiteral("Jane Doe"), QStringLiteral("https://example.org/4"), Read, true},
+    };
+    for (qsizetype i = 0; i < articles.size(); ++i) {
+        const Data &data = articles.at(i);
+        Backend::ArticleData article;
+        article.guid = QStringLiteral("guid%1").arg(i);
+        article.title = data.title;
+        article.description = data.description;
+        article.link = data.link;
+        article.hasAuthor = !data.author.isEmpty();
+        article.authorName = data.author;
+        article.pubDate = QDateTime::fromSecsSinceEpoch(1700000000 + i);
+        archive->addArticle(article);
+
+        Article a(article.guid, nullptr, archive);
+        a.setStatus(data.status);
+        a.setKeep(data.keep);
+        mArticles.append(a);
+    }
+}
+
+void ArticleMatcherTest::cleanupTestCase()
+{
+    mArticles.clear();
+    mStorage.reset();
+}
+
+void ArticleMatcherTest::shouldRefineArticleMatcher_data()
+{
+    QTest::addColumn<int>("association");
+    QTest::addColumn<QList<int>>("criteria");
+    QTest::addColumn<int>("otherAssociation");
+    QTest::addColumn<QList<int>>("otherCriteria");
+    QTest::addColumn<bool>("refines");
+    constexpr int none = ArticleMatcher::None;
+    constexpr int all = ArticleMatcher::LogicalAnd;
+    constexpr int any = ArticleMatcher::LogicalOr;
+    QTest::newRow("or, fewer alternatives") << any << QList<int>{0, 1} << any << QList<int>{0, 1, 2} << true;
+    QTest::newRow("or, more alternatives") << any << QList<int>{0, 1, 2} << any << QList<int>{0, 1} << false;
+    QTest::newRow("or, other alternative") << any << QList<int>{3} << any << QList<int>{0, 1} << false;
+    QTest::newRow("or, reordered") << any << QList<int>{1, 0} << any << QList<int>{0, 1} << true;
+    QTest::newRow("and, more conditions") << all << QList<int>{0, 1, 2} << all << QList<int>{0, 2} << true;
+    QTest::newRow("and, fewer conditions") << all << QList<int>{0} << all << QList<int>{0, 1} << false;
+    QTest::newRow("and, other condition") << all << QList<int>{3, 4} << all << QList<int>{0} << false;
+    QTest::newRow("and, reordered") << all << QList<int>{2, 0} << all << QList<int>{0, 2} << true;
+    QTest::newRow("other without association") << all << QList<int>{0} << none << QList<int>() << true;
+    QTest::newRow("other without association, with criteria") << any << QList<int>{0} << none << QList<int>{1} << true;
+    QTest::newRow("other without criteria") << all << QList<int>{0} << any << QList<int>() << true;
+    QTest::newRow("without association") << none << QList<int>() << all << QList<int>{0} << false;
+    QTest::newRow("without criteria") << all << QList<int>() << any << QList<int>{0} << false;
+    QTest::newRow("and refining or") << all << QList<int>{0, 1} << any << QList<int>{0, 1} << false;
+    QTest::newRow("or refining and") << any << QList<int>{0} << all << QList<int>{0} << false;
+}
+
+void ArticleMatcherTest::shouldRefineArticleMatcher()
+{
+    QFETCH(int, association);
+    QFETCH(QList<int>, criteria);
+    QFETCH(int, otherAssociation);
+    QFETCH(QList<int>, otherCriteria);
+    QFETCH(bool, refines);
+    const ArticleMatcher matcher(pick(criteria), static_cast<ArticleMatcher::Association>(association));
+    const ArticleMatcher other(pick(otherCriteria), static_cast<ArticleMatcher::Association>(otherAssociation));
+    QCOMPARE(matcher.refines(other), refines);
+
+    // a refinement never accepts an article the other matcher rejects
+    if (refines) {
+        for (const Article &article : std::as_const(mArticles)) {
+            QVERIFY(!matcher.matches(article) || other.matches(article));
+        }
+    }
+}
+
+void ArticleMatcherTest::shouldRefineFullTextMatcher_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("otherText");
+    QTest::addColumn<bool>("refines");
+    QTest::newRow("longer") << QStringLiteral("kde plasma") << QStringLiteral("kde") << true;
+    QTest::newRow("longer, other case") << QStringLiteral("KDE Plasma") << QStringLiteral("plasma") << true;
+    QTest::newRow("equal") << QStringLiteral("kde") << QStringLiteral("kde") << true;
+    QTest::newRow("shorter") << QStringLiteral("kde") << QStringLiteral("kde plasma") << false;
+    QTest::newRow("other text") << QStringLiteral("gnome") << QStringLiteral("kde") << false;
+    QTest::newRow("both empty") << QString() << QString() << true;
+    QTest::newRow("empty") << QString() << QStringLiteral("kde") << false;
+}
+
+void ArticleMatcherTest::shouldRefineFullTextMatcher()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, otherText);
+    QFETCH(bool, refines);
+    const FullTextMatcher matcher(text);
+    const FullTextMatcher other(otherText);
+    QCOMPARE(matcher.refines(other), refines);
+}
+
+void ArticleMatcherTest::shouldNotRefineOtherMatchers()
+{
+    const ArticleMatcher articleMatcher({criteria.at(1)}, ArticleMatcher::LogicalOr);
+    const FullTextMatcher fullTextMatcher(QStringLiteral("kde"));
+    QVERIFY(!articleMatcher.refines(fullTextMatcher));
+    QVERIFY(!fullTextMatcher.refines(articleMatcher));
+}
+
+void ArticleMatcherTest::shouldMatchLikeCriteriaInGivenOrder()
+{
+    // every subset of the criteria, with both associations
+    for (int subset = 0; subset < (1 << criteria.size()); ++subset) {
+        QList<int> indexes;
+        for (int i = 0; i < criteria.size(); ++i) {
+            if (subset & (1 << i)) {
+                indexes.append(i);
+            }
+        }
+        const QList<Criterion> picked = pick(indexes);
+        for (const auto association : {ArticleMatcher::LogicalAnd, ArticleMatcher::LogicalOr}) {
+            const ArticleMatcher matcher(picked, association);
+            for (const Article &article : std::as_const(mArticles)) {
+                QCOMPARE(matcher.matches(article), matches(picked, association, article));
+            }
+        }
+    }
+}
+
+#include "moc_articlematchertest.cpp"
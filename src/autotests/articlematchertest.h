@@ -0,0 +1,44 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "article.h"
+
+#include <QObject>
+#include <QTemporaryDir>
+
+#include <memory>
+
+namespace Akregator
+{
+namespace Backend
+{
+class Storage;
+}
+}
+
+class ArticleMatcherTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ArticleMatcherTest(QObject *parent = nullptr);
+    ~ArticleMatcherTest() override;
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void shouldRefineArticleMatcher_data();
+    void shouldRefineArticleMatcher();
+    void shouldRefineFullTextMatcher_data();
+    void shouldRefineFullTextMatcher();
+    void shouldNotRefineOtherMatchers();
+    void shouldMatchLikeCriteriaInGivenOrder();
+
+private:
+    QTemporaryDir mArchiveDir;
+    std::unique_ptr<Akregator::Backend::Storage> mStorage;
+    QList<Akregator::Article> mArticles;
+};
@@ -0,0 +1,255 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "articlemodeltest.h"
+#include "articlemodel.h"
+#include "storage/feedstorage.h"
+#include "storage/storage.h"
+
+#include <QAbstractItemModelTester>
+#include <QSignalSpy>
+#include <QTest>
+
+using namespace Akregator;
+
+QTEST_MAIN(ArticleModelTest)
+
+/** the rows and roles of one dataChanged signal */
+struct DataChangedRun {
+    int first;
+    int last;
+    QList<int> roles;
+};
+Q_DECLARE_METATYPE(DataChangedRun)
+
+namespace
+{
+constexpr int modelRows = 10;
+
+/** what a row of shouldEmitDataChangedPerRun does to an article before passing it on */
+enum ArticleChange {
+    Touch,
+    ToggleStatus,
+    ToggleKeep,
+    Delete,
+    ToggleStatusAndKeep,
+};
+
+const QList<int> statusRoles = {ArticleModel::StatusRole, Qt::ForegroundRole};
+const QList<int> keepRoles = {ArticleModel::IsImportantRole, Qt::DecorationRole};
+
+[[nodiscard]] QList<Article> pick(const QList<Article> &articles, const QList<int> &indexes)
+{
+    QList<Article> result;
+    for (const int index : indexes) {
+        result.append(articles.at(index));
+    }
+    return result;
+}
+
+/** checks that the model holds @p expected in this order and that updates find each of them at its row */
+void verifyRows(ArticleModel &model, const QList<Article> &expected)
+{
+    QCOMPARE(model.rowCount(), int(expected.size()));
+    for (int row = 0; row < expected.size(); ++row) {
+        QCOMPARE(model.article(row).guid(), expected.at(row).guid());
+    }
+
+    QSignalSpy spy(&model, &QAbstractItemModel::dataChanged);
+    for (int row = 0; row < expected.size(); ++row) {
+        model.articlesUpdated(nullptr, {expected.at(row)});
+        QCOMPARE(spy.count(), 1);
+        const QList<QVariant> arguments = spy.takeFirst();
+        QCOMPARE(arguments.at(0).toModelIndex().row(), row);
+        QCOMPARE(arguments.at(1).toModelIndex().row(), row);
+        QCOMPARE(arguments.at(1).toModelIndex().column(), ArticleModel::ColumnCount - 1);
+    }
+}
+}
+
+ArticleModelTest::ArticleModelTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ArticleModelTest::~ArticleModelTest() = default;
+
+void ArticleModelTest::initTestCase()
+{
+    QVERIFY(mArchiveDir.isValid());
+    mStorage = std::make_unique<Backend::Storage>();
+    mStorage->setArchivePath(mArchiveDir.path());
+    QVERIFY(mStorage->open(true));
+}
+
+void ArticleModelTest::cleanupTestCase()
+{
+    mArticles.clear();
+    mStorage.reset();
+}
+
+void ArticleModelTest::init()
+{
+    // a feed of its own for every test, as the tests change the articles
+    Backend::FeedStorage *const archive = mStorage->archiveFor(QStringLiteral("https://example.org/feed%1").arg(++mFeedCount));
+    mArticles.clear();
+    for (int i = 0; i <= modelRows; ++i) {
+        Backend::ArticleData data;
+        data.guid = QStringLiteral("guid%1").arg(i);
+        data.title = QStringLiteral("Article %1").arg(i);
+        data.pubDate = QDateTime::fromSecsSinceEpoch(1700000000 + i);
+        archive->addArticle(data);
+
+        Article article(data.guid, nullptr, archive);
+        article.setStatus(Read);
+        article.setKeep(false);
+        mArticles.append(article);
+    }
+}
+
+void ArticleModelTest::shouldRemoveArticles_data()
+{
+    QTest::addColumn<QList<int>>("removed");
+    QTest::addColumn<QList<std::pair<int, int>>>("ranges");
+    QTest::addColumn<QList<int>>("remaining");
+
+    QTest::newRow("single") << QList<int>{3} << QList<std::pair<int, int>>{{3, 3}} << QList<int>{0, 1, 2, 4, 5, 6, 7, 8, 9};
+    QTest::newRow("contiguous") << QList<int>{2, 3, 4} << QList<std::pair<int, int>>{{2, 4}} << QList<int>{0, 1, 5, 6, 7, 8, 9};
+    QTest::newRow("descending") << QList<int>{4, 3, 2} << QList<std::pair<int, int>>{{2, 4}} << QList<int>{0, 1, 5, 6, 7, 8, 9};
+    QTest::newRow("non-contiguous") << QList<int>{1, 5, 8, 6} << QList<std::pair<int, int>>{{8, 8}, {5, 6}, {1, 1}} << QList<int>{0, 2, 3, 4, 7, 9};
+    QTest::newRow("duplicates") << QList<int>{5, 5, 2, 5} << QList<std::pair<int, int>>{{5, 5}, {2, 2}} << QList<int>{0, 1, 3, 4, 6, 7, 8, 9};
+    QTest::newRow("first and last") << QList<int>{9, 0} << QList<std::pair<int, int>>{{9, 9}, {0, 0}} << QList<int>{1, 2, 3, 4, 5, 6, 7, 8};
+    QTest::newRow("all") << QList<int>{9, 8, 7, 6, 5, 4, 3, 2, 1, 0} << QList<std::pair<int, int>>{{0, 9}} << QList<int>{};
+    QTest::newRow("not in the model") << QList<int>{modelRows} << QList<std::pair<int, int>>{} << QList<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    QTest::newRow("partly in the model") << QList<int>{modelRows, 7} << QList<std::pair<int, int>>{{7, 7}} << QList<int>{0, 1, 2, 3, 4, 5, 6, 8, 9};
+    QTest::newRow("empty") << QList<int>{} << QList<std::pair<int, int>>{} << QList<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+}
+
+void ArticleModelTest::shouldRemoveArticles()
+{
+    QFETCH(QList<int>, removed);
+    QFETCH(QList<std::pair<int, int>>, ranges);
+    QFETCH(QList<int>, remaining);
+
+    ArticleModel model(mArticles.mid(0, modelRows));
+    QAbstractItemModelTester tester(&model);
+    QSignalSpy spy(&model, &QAbstractItemModel::rowsRemoved);
+
+    model.articlesRemoved(nullptr, pick(mArticles, removed));
+
+    QList<std::pair<int, int>> emitted;
+    for (const QList<QVariant> &arguments : std::as_const(spy)) {
+        emitted.append({arguments.at(1).toInt(), arguments.at(2).toInt()});
+    }
+    QCOMPARE(emitted, ranges);
+    verifyRows(model, pick(mArticles, remaining));
+
+    // the removed articles are gone from the index as well
+    QSignalSpy changedSpy(&model, &QAbstractItemModel::dataChanged);
+    model.articlesUpdated(nullptr, pick(mArticles, removed));
+    QCOMPARE(changedSpy.count(), 0);
+}
+
+void ArticleModelTest::shouldReindexRowsAfterRemoval()
+{
+    ArticleModel model(mArticles.mid(0, modelRows));
+    QAbstractItemModelTester tester(&model);
+    QSignalSpy spy(&model, &QAbstractItemModel::rowsRemoved);
+
+    model.articlesRemoved(nullptr, pick(mArticles, {1, 4}));
+    verifyRows(model, pick(mArticles, {0, 2, 3, 5, 6, 7, 8, 9}));
+
+    // rows moved up by the first removal
+    spy.clear();
+    model.articlesRemoved(nullptr, pick(mArticles, {9, 5}));
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(0).at(1).toInt(), 7);
+    QCOMPARE(spy.at(1).at(1).toInt(), 3);
+    verifyRows(model, pick(mArticles, {0, 2, 3, 6, 7, 8}));
+
+    // appended rows follow the remaining ones
+    model.articlesAdded(nullptr, pick(mArticles, {modelRows}));
+    verifyRows(model, pick(mArticles, {0, 2, 3, 6, 7, 8, modelRows}));
+
+    spy.clear();
+    model.articlesRemoved(nullptr, pick(mArticles, {modelRows, 0}));
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(0).at(1).toInt(), 6);
+    QCOMPARE(spy.at(1).at(1).toInt(), 0);
+    verifyRows(model, pick(mArticles, {2, 3, 6, 7, 8}));
+}
+
+void ArticleModelTest::shouldEmitDataChangedPerRun_data()
+{
+    QTest::addColumn<QList<std::pair<int, int>>>("changes");
+    QTest::addColumn<QList<DataChangedRun>>("runs");
+
+    QTest::newRow("status") << QList<std::pair<int, int>>{{3, ToggleStatus}} << QList<DataChangedRun>{{3, 3, statusRoles}};
+    QTest::newRow("keep") << QList<std::pair<int, int>>{{3, ToggleKeep}} << QList<DataChangedRun>{{3, 3, keepRoles}};
+    QTest::newRow("deleted") << QList<std::pair<int, int>>{{3, Delete}} << QList<DataChangedRun>{{3, 3, {ArticleModel::IsDeletedRole}}};
+    QTest::newRow("status and keep") << QList<std::pair<int, int>>{{3, ToggleStatusAndKeep}} << QList<DataChangedRun>{{3, 3, statusRoles + keepRoles}};
+    QTest::newRow("untracked") << QList<std::pair<int, int>>{{3, Touch}} << QList<DataChangedRun>{{3, 3, {}}};
+    QTest::newRow("run") << QList<std::pair<int, int>>{{2, ToggleStatus}, {3, ToggleStatus}, {4, ToggleStatus}}
+                         << QList<DataChangedRun>{{2, 4, statusRoles}};
+    QTest::newRow("descending run") << QList<std::pair<int, int>>{{4, ToggleStatus}, {3, ToggleStatus}, {2, ToggleStatus}}
+                                    << QList<DataChangedRun>{{2, 4, statusRoles}};
+    QTest::newRow("gap") << QList<std::pair<int, int>>{{1, ToggleStatus}, {3, ToggleStatus}, {4, ToggleStatus}}
+                         << QList<DataChangedRun>{{1, 1, statusRoles}, {3, 4, statusRoles}};
+    QTest::newRow("different changes") << QList<std::pair<int, int>>{{2, ToggleStatus}, {3, ToggleKeep}, {4, ToggleKeep}, {5, Touch}}
+                                       << QList<DataChangedRun>{{2, 2, statusRoles}, {3, 4, keepRoles}, {5, 5, {}}};
+    QTest::newRow("duplicates") << QList<std::pair<int, int>>{{2, ToggleStatus}, {3, ToggleStatus}, {2, Touch}, {3, Touch}}
+                                << QList<DataChangedRun>{{2, 3, statusRoles}};
+    QTest::newRow("not in the model") << QList<std::pair<int, int>>{{modelRows, ToggleStatus}} << QList<DataChangedRun>{};
+    QTest::newRow("partly in the model") << QList<std::pair<int, int>>{{9, ToggleKeep}, {modelRows, ToggleKeep}, {8, ToggleKeep}}
+                                         << QList<DataChangedRun>{{8, 9, keepRoles}};
+}
+
+void ArticleModelTest::shouldEmitDataChangedPerRun()
+{
+    QFETCH(QList<std::pair<int, int>>, changes);
+    QFETCH(QList<DataChangedRun>, runs);
+
+    ArticleModel model(mArticles.mid(0, modelRows));
+    QAbstractItemModelTester tester(&model);
+    QSignalSpy spy(&model, &QAbstractItemModel::dataChanged);
+
+    QList<Article> updated;
+    for (const auto &[index, change] : std::as_const(changes)) {
+        Article article = mArticles.at(index);
+        if (change == ToggleStatus || change == ToggleStatusAndKeep) {
+            article.setStatus(article.status() == Read ? Unread : Read);
+        }
+        if (change == ToggleKeep || change == ToggleStatusAndKeep) {
+            article.setKeep(!article.keep());
+        }
+        if (change == Delete) {
+            article.setDeleted();
+        }
+        updated.append(article);
+    }
+    model.articlesUpdated(nullptr, updated);
+
+    QCOMPARE(spy.count(), runs.size());
+    for (qsizetype i = 0; i < runs.size(); ++i) {
+        const QList<QVariant> &arguments = spy.at(i);
+        const QModelIndex topLeft = arguments.at(0).toModelIndex();
+        const QModelIndex bottomRight = arguments.at(1).toModelIndex();
+        QCOMPARE(topLeft.row(), runs.at(i).first);
+        QCOMPARE(topLeft.column(), 0);
+        QCOMPARE(bottomRight.row(), runs.at(i).last);
+        QCOMPARE(bottomRight.column(), ArticleModel::ColumnCount - 1);
+        QCOMPARE(arguments.at(2).value<QList<int>>(), runs.at(i).roles);
+    }
+
+    // the new state was recorded, so passing the same articles again changes no tracked roles
+    spy.clear();
+    model.articlesUpdated(nullptr, updated);
+    for (const QList<QVariant> &arguments : std::as_const(spy)) {
+        QVERIFY(arguments.at(2).value<QList<int>>().isEmpty());
+    }
+}
+
+#include "moc_articlemodeltest.cpp"
@@ -0,0 +1,46 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "article.h"
+
+#include <QObject>
+#include <QTemporaryDir>
+
+#include <memory>
+
+namespace Akregator
+{
+namespace Backend
+{
+class Storage;
+}
+}
+
+class ArticleModelTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ArticleModelTest(QObject *parent = nullptr);
+    ~ArticleModelTest() override;
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void shouldRemoveArticles_data();
+    void shouldRemoveArticles();
+    void shouldReindexRowsAfterRemoval();
+    void shouldEmitDataChangedPerRun_data();
+    void shouldEmitDataChangedPerRun();
+
+private:
+    QTemporaryDir mArchiveDir;
+    std::unique_ptr<Akregator::Backend::Storage> mStorage;
+    /** the first modelRows articles are in the model, the last one is not */
+    QList<Akregator::Article> mArticles;
+    int mFeedCount = 0;
+};
@@ -0,0 +1,417 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "fetchqueuetest.h"
+#include "akregatorconfig.h"
+#include "feed.h"
+#include "fetchqueue.h"
+#include "storage/storage.h"
+
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+
+#include <algorithm>
+
+using namespace Akregator;
+
+QTEST_MAIN(FetchQueueTest)
+
+namespace
+{
+/** records the fetches the queue starts instead of going to the network */
+class TestFetchQueue : public FetchQueue
+{
+public:
+    using FetchQueue::FetchQueue;
+
+    QList<Feed *> started;
+    QHash<const Feed *, std::chrono::microseconds> queueWaits;
+    QHash<const Feed *, FetchTimings::Failure> failures;
+
+protected:
+    void startFetch(Feed *feed, std::chrono::microseconds queueWait) override
+    {
+        started.append(feed);
+        queueWaits.insert(feed, queueWait);
+    }
+
+    FetchTimings fetchTimings(const Feed *feed) const override
+    {
+        FetchTimings timings;
+        timings.failure = failures.value(feed, FetchTimings::NoFailure);
+        timings.outcome = timings.failure == FetchTimings::NoFailure ? FetchTimings::Fetched : FetchTimings::Failed;
+        return timings;
+    }
+};
+
+void finish(Feed *feed)
+{
+    Q_EMIT feed->fetched(feed);
+}
+
+void fail(TestFetchQueue &queue, Feed *feed, FetchTimings::Failure failure)
+{
+    queue.failures.insert(feed, failure);
+    Q_EMIT feed->fetchError(feed);
+}
+}
+
+FetchQueueTest::FetchQueueTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+FetchQueueTest::~FetchQueueTest() = default;
+
+void FetchQueueTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    // no favicon downloads for the feeds of the tests
+    Settings::setFetchOnStartup(true);
+
+    QVERIFY(mArchiveDir.isValid());
+    mStorage = std::make_unique<Backend::Storage>();
+    mStorage->setArchivePath(mArchiveDir.path());
+    QVERIFY(mStorage->open(true));
+}
+
+void FetchQueueTest::cleanupTestCase()
+{
+    mStorage.reset();
+}
+
+void FetchQueueTest::init()
+{
+    Settings::setConcurrentFetches(2);
+    Settings::setConcurrentFetchesPerHost(1);
+}
+
+void FetchQueueTest::cleanup()
+{
+    mFeeds.clear();
+}
+
+Feed *FetchQueueTest::createFeed(const QString &host)
+{
+    auto feed = std::make_unique<Feed>(mStorage.get());
+    feed->setXmlUrl(QStringLiteral("https://%1/feed%2.xml").arg(host).arg(mFeeds.size()));
+    mFeeds.push_back(std::move(feed));
+    return mFeeds.back().get();
+}
+
+void FetchQueueTest::destroyFeed(Feed *feed)
+{
+    const auto it = std::find_if(mFeeds.begin(), mFeeds.end(), [feed](const auto &created) {
+        return created.get() == feed;
+    });
+    QVERIFY(it != mFeeds.end());
+    mFeeds.erase(it);
+}
+
+void FetchQueueTest::shouldSkipDuplicates()
+{
+    TestFetchQueue queue;
+    QSignalSpy startedSpy(&queue, &FetchQueue::signalStarted);
+    Feed *const a = createFeed(QStringLiteral("a.org"));
+    Feed *const b = createFeed(QStringLiteral("b.org"));
+    Feed *const c = createFeed(QStringLiteral("c.org"));
+
+    queue.addFeeds({a, b, a, c, b});
+    QCOMPARE(queue.started, (QList<Feed *>{a, b}));
+
+    // fetching or queued already
+    queue.addFeeds({a, c});
+    queue.addFeed(b);
+    QCOMPARE(startedSpy.count(), 1);
+
+    finish(a);
+    finish(b);
+    finish(c);
+    QCOMPARE(queue.started, (QList<Feed *>{a, b, c}));
+    QVERIFY(queue.isEmpty());
+}
+
+void FetchQueueTest::shouldEmitSignalStartedOncePerBatch()
+{
+    TestFetchQueue queue;
+    QSignalSpy startedSpy(&queue, &FetchQueue::signalStarted);
+    Feed *const a = createFeed(QStringLiteral("a.org"));
+    Feed *const b = createFeed(QStringLiteral("b.org"));
+    Feed *const c = createFeed(QStringLiteral("c.org"));
+    Feed *const d = createFeed(QStringLiteral("d.org"));
+
+    // nothing to fetch, nothing started
+    queue.addFeeds({});
+    QCOMPARE(startedSpy.count(), 0);
+
+    queue.addFeeds({a, b, c});
+    QCOMPARE(startedSpy.count(), 1);
+
+    // joining the running batch
+    queue.addFeeds({d});
+    QCOMPARE(startedSpy.count(), 1);
+
+    finish(a);
+    finish(b);
+    finish(c);
+    finish(d);
+    QVERIFY(queue.isEmpty());
+
+    queue.addFeed(a);
+    QCOMPARE(startedSpy.count(), 2);
+}
+
+void FetchQueueTest::shouldRemoveDestroyedQueuedFeed()
+{
+    TestFetchQueue queue;
+    QSignalSpy stoppedSpy(&queue, &FetchQueue::signalStopped);
+    Feed *const a = createFeed(QStringLiteral("a.org"));
+    Feed *const b = createFeed(QStringLiteral("b.org"));
+    Feed *const c = createFeed(QStringLiteral("c.org"));
+
+    queue.addFeeds({a, b, c});
+    QCOMPARE(queue.started, (QList<Feed *>{a, b}));
+
+    destroyFeed(c);
+    QVERIFY(!queue.isEmpty());
+    QCOMPARE(stoppedSpy.count(), 0);
+
+    // the slot goes to nobody
+    finish(a);
+    QCOMPARE(queue.started, (QList<Feed *>{a, b}));
+    finish(b);
+    QVERIFY(queue.isEmpty());
+    QCOMPARE(stoppedSpy.count(), 1);
+}
+
+void FetchQueueTest::shouldRemoveDestroyedFetchingFeed()
+{
+    TestFetchQueue queue;
+    QSignalSpy stoppedSpy(&queue, &FetchQueue::signalStopped);
+    Feed *const a = createFeed(QStringLiteral("a.org"));
+    Feed *const b = createFeed(QStringLiteral("b.org"));
+    Feed *const c = createFeed(QStringLiteral("c.org"));
+
+    queue.addFeeds({a, b, c});
+    QCOMPARE(queue.started, (QList<Feed *>{a, b}));
+
+    // its slot is free again
+    destroyFeed(a);
+    QCOMPARE(queue.started, (QList<Feed *>{a, b, c}));
+    QCOMPARE(stoppedSpy.count(), 0);
+
+    finish(b);
+    QCOMPARE(stoppedSpy.count(), 0);
+    // the last fetch going away stops the queue
+    destroyFeed(c);
+    QVERIFY(queue.isEmpty());
+    QCOMPARE(stoppedSpy.count(), 1);
+}
+
+void FetchQueueTest::shouldEmitSignalStoppedWhenEmpty()
+{
+    TestFetchQueue queue;
+    QSignalSpy stoppedSpy(&queue, &FetchQueue::signalStopped);
+    Feed *const a = createFeed(QStringLiteral("a.org"));
+    Feed *const b = createFeed(QStringLiteral("a.org"));
+
+    queue.addFeeds({a, b});
+    // one fetch per host
+    QCOMPARE(queue.started, (QList<Feed *>{a}));
+
+    finish(a);
+    QCOMPARE(stoppedSpy.count(), 0);
+    QCOMPARE(queue.started, (QList<Feed *>{a, b}));
+    Q_EMIT b->fetchError(b);
+    QCOMPARE(stoppedSpy.count(), 1);
+    QVERIFY(queue.isEmpty());
+
+    // a feed which is not fetched anymore changes nothing
+    finish(a);
+    QCOMPARE(stoppedSpy.count(), 1);
+
+    queue.addFeed(a);
+    queue.slotAbort();
+    QCOMPARE(stoppedSpy.count(), 2);
+    QVERIFY(queue.isEmpty());
+}
+
+void FetchQueueTest::shouldStartInteractiveFetchOnNextFreeSlot()
+{
+    TestFetchQueue queue;
+    Feed *const a1 = createFeed(QStringLiteral("a.org"));
+    Feed *const a2 = createFeed(QStringLiteral("a.org"));
+    Feed *const a3 = createFeed(QStringLiteral("a.org"));
+    Feed *const b1 = createFeed(QStringLiteral("b.org"));
+    Feed *const b2 = createFeed(QStringLiteral("b.org"));
+    Feed *const c = createFeed(QStringLiteral("c.org"));
+
+    queue.addFeeds({a1, a2, a3, b1, b2});
+    QCOMPARE(queue.started, (QList<Feed *>{a1, b1}));
+
+    // a3 moves up past the background backlog, c joins the interactive lane
+    queue.addFeed(a3, InteractiveFetch);
+    queue.addFeed(c, InteractiveFetch);
+    QCOMPARE(queue.started, (QList<Feed *>{a1, b1}));
+
+    // the next free slot goes to a3 although a1 keeps its host busy
+    finish(b1);
+    QCOMPARE(queue.started, (QList<Feed *>{a1, b1, a3}));
+    finish(a1);
+    QCOMPARE(queue.started, (QList<Feed *>{a1, b1, a3, c}));
+
+    // then the background lane goes on, one fetch per host
+    finish(a3);
+    QCOMPARE(queue.started, (QList<Feed *>{a1, b1, a3, c, a2}));
+    finish(c);
+    QCOMPARE(queue.started, (QList<Feed *>{a1, b1, a3, c, a2, b2}));
+}
+
+void FetchQueueTest::shouldNotMoveFeedsDown()
+{
+    TestFetchQueue queue;
+    Feed *const a = createFeed(QStringLiteral("a.org"));
+    Feed *const b = createFeed(QStringLiteral("b.org"));
+    Feed *const c = createFeed(QStringLiteral("c.org"));
+    Feed *const d = createFeed(QStringLiteral("d.org"));
+
+    queue.addFeeds({a, b});
+    queue.addFeed(c, BackgroundFetch);
+    queue.addFeed(d, StartupFetch);
+    // a background fetch of d is already covered by its startup fetch
+    queue.addFeed(d, BackgroundFetch);
+
+    finish(a);
+    QCOMPARE(queue.started, (QList<Feed *>{a, b, d}));
+    finish(b);
+    QCOMPARE(queue.started, (QList<Feed *>{a, b, d, c}));
+}
+
+void FetchQueueTest::shouldKeepQueueTimeWhenMovedUp()
+{
+    TestFetchQueue queue;
+    Feed *const a = createFeed(QStringLiteral("a.org"));
+    Feed *const b = createFeed(QStringLiteral("b.org"));
+    Feed *const c = createFeed(QStringLiteral("c.org"));
+
+    queue.addFeeds({a, b, c});
+    QCOMPARE(queue.started, (QList<Feed *>{a, b}));
+    QTest::qWait(50);
+
+    // c waits since it was queued first, not since it moved up
+    queue.addFeed(c, InteractiveFetch);
+    finish(a);
+    QCOMPARE(queue.started, (QList<Feed *>{a, b, c}));
+    QVERIFY(queue.queueWaits.value(c) >= std::chrono::milliseconds(50));
+}
+
+void FetchQueueTest::shouldTripHostBreakerOnTransportFailures_data()
+{
+    QTest::addColumn<int>("failure");
+    QTest::addColumn<bool>("trips");
+    QTest::newRow("unreachable") << int(FetchTimings::HostUnreachable) << true;
+    QTest::newRow("overloaded") << int(FetchTimings::HostOverloaded) << true;
+    QTest::newRow("broken feed") << int(FetchTimings::FeedFailure) << false;
+    QTest::newRow("unknown") << int(FetchTimings::NoFailure) << false;
+}
+
+void FetchQueueTest::shouldTripHostBreakerOnTransportFailures()
+{
+    QFETCH(int, failure);
+    QFETCH(bool, trips);
+    // one fetch at a time, so that the failures come in a row
+    Settings::setConcurrentFetches(1);
+
+    TestFetchQueue queue;
+    QSignalSpy skippedSpy(&queue, &FetchQueue::fetchSkipped);
+    QList<Feed *> feeds;
+    for (int i = 0; i < 5; ++i) {
+        feeds.append(createFeed(QStringLiteral("a.org")));
+    }
+    queue.addFeeds(feeds);
+
+    for (int i = 0; i < 3; ++i) {
+        QCOMPARE(queue.started.size(), i + 1);
+        fail(queue, feeds.at(i), static_cast<FetchTimings::Failure>(failure));
+    }
+
+    if (trips) {
+        QCOMPARE(queue.started.size(), 3);
+        QCOMPARE(skippedSpy.count(), 2);
+        QVERIFY(feeds.at(3)->fetchSkipped());
+        QVERIFY(feeds.at(4)->fetchSkipped());
+        QVERIFY(queue.isEmpty());
+    } else {
+        QCOMPARE(queue.started.size(), 4);
+        QCOMPARE(skippedSpy.count(), 0);
+        QVERIFY(!feeds.at(4)->fetchSkipped());
+    }
+}
+
+void FetchQueueTest::shouldNotSkipInteractiveFeeds()
+{
+    Settings::setConcurrentFetches(1);
+
+    TestFetchQueue queue;
+    QSignalSpy skippedSpy(&queue, &FetchQueue::fetchSkipped);
+    Feed *const a1 = createFeed(QStringLiteral("a.org"));
+    Feed *const a2 = createFeed(QStringLiteral("a.org"));
+    Feed *const a3 = createFeed(QStringLiteral("a.org"));
+    Feed *const a4 = createFeed(QStringLiteral("a.org"));
+    Feed *const a5 = createFeed(QStringLiteral("a.org"));
+
+    queue.addFeeds({a1, a2, a3});
+    fail(queue, a1, FetchTimings::HostUnreachable);
+    fail(queue, a2, FetchTimings::HostUnreachable);
+    QCOMPARE(queue.started, (QList<Feed *>{a1, a2, a3}));
+    queue.addFeed(a4, InteractiveFetch);
+    queue.addFeed(a5, StartupFetch);
+
+    // the host is given up on, except for what the user asked for
+    fail(queue, a3, FetchTimings::HostUnreachable);
+    QCOMPARE(skippedSpy.count(), 1);
+    QCOMPARE(skippedSpy.at(0).at(0).value<Feed *>(), a5);
+    QVERIFY(!a4->fetchSkipped());
+    QCOMPARE(queue.started, (QList<Feed *>{a1, a2, a3, a4}));
+}
+
+void FetchQueueTest::shouldResetHostFailuresAfterAnswer_data()
+{
+    QTest::addColumn<bool>("fetched");
+    QTest::newRow("fetched") << true;
+    QTest::newRow("broken feed") << false;
+}
+
+void FetchQueueTest::shouldResetHostFailuresAfterAnswer()
+{
+    QFETCH(bool, fetched);
+    Settings::setConcurrentFetches(1);
+
+    TestFetchQueue queue;
+    QSignalSpy skippedSpy(&queue, &FetchQueue::fetchSkipped);
+    QList<Feed *> feeds;
+    for (int i = 0; i < 6; ++i) {
+        feeds.append(createFeed(QStringLiteral("a.org")));
+    }
+    queue.addFeeds(feeds);
+
+    fail(queue, feeds.at(0), FetchTimings::HostUnreachable);
+    fail(queue, feeds.at(1), FetchTimings::HostOverloaded);
+    // the host answered, whatever it answered
+    if (fetched) {
+        finish(feeds.at(2));
+    } else {
+        fail(queue, feeds.at(2), FetchTimings::FeedFailure);
+    }
+    fail(queue, feeds.at(3), FetchTimings::HostUnreachable);
+    fail(queue, feeds.at(4), FetchTimings::HostUnreachable);
+
+    QCOMPARE(skippedSpy.count(), 0);
+    QCOMPARE(queue.started, feeds);
+}
+
+#include "moc_fetchqueuetest.cpp"
@@ -0,0 +1,58 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+#include <QTemporaryDir>
+
+#include <memory>
+#include <vector>
+
+namespace Akregator
+{
+class Feed;
+namespace Backend
+{
+class Storage;
+}
+}
+
+class FetchQueueTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FetchQueueTest(QObject *parent = nullptr);
+    ~FetchQueueTest() override;
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+    void shouldSkipDuplicates();
+    void shouldEmitSignalStartedOncePerBatch();
+    void shouldRemoveDestroyedQueuedFeed();
+    void shouldRemoveDestroyedFetchingFeed();
+    void shouldEmitSignalStoppedWhenEmpty();
+    void shouldStartInteractiveFetchOnNextFreeSlot();
+    void shouldNotMoveFeedsDown();
+    void shouldKeepQueueTimeWhenMovedUp();
+    void shouldTripHostBreakerOnTransportFailures_data();
+    void shouldTripHostBreakerOnTransportFailures();
+    void shouldNotSkipInteractiveFeeds();
+    void shouldResetHostFailuresAfterAnswer_data();
+    void shouldResetHostFailuresAfterAnswer();
+
+private:
+    /** creates a feed on @p host, which is deleted after the test unless it was already */
+    Akregator::Feed *createFeed(const QString &host);
+    /** deletes a feed created by createFeed() */
+    void destroyFeed(Akregator::Feed *feed);
+
+    QTemporaryDir mArchiveDir;
+    std::unique_ptr<Akregator::Backend::Storage> mStorage;
+    std::vector<std::unique_ptr<Akregator::Feed>> mFeeds;
+};
@@ -0,0 +1,127 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "fetchschedulertest.h"
+#include "fetchscheduler.h"
+
+#include <QTest>
+
+using Akregator::FetchScheduler;
+
+QTEST_MAIN(FetchSchedulerTest)
+
+namespace
+{
+constexpr qint64 minute = 60;
+constexpr qint64 hour = 60 * minute;
+constexpr qint64 day = 24 * hour;
+}
+
+FetchSchedulerTest::FetchSchedulerTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void FetchSchedulerTest::shouldBoundAdaptiveInterval_data()
+{
+    QTest::addColumn<qint64>("interval");
+    QTest::addColumn<qint64>("configured");
+    QTest::addColumn<qint64>("expected");
+    QTest::newRow("within") << 2 * hour << hour << 2 * hour;
+    QTest::newRow("below configured") << minute << hour << hour;
+    QTest::newRow("stretched 16 times at most") << 20 * hour << hour << 16 * hour;
+    QTest::newRow("one day at most") << 2 * day << 2 * hour << day;
+    QTest::newRow("configured longer than a day") << 3 * day << 2 * day << 2 * day;
+}
+
+void FetchSchedulerTest::shouldBoundAdaptiveInterval()
+{
+    QFETCH(qint64, interval);
+    QFETCH(qint64, configured);
+    QFETCH(qint64, expected);
+    QCOMPARE(FetchScheduler::boundAdaptiveInterval(interval, configured), expected);
+}
+
+void FetchSchedulerTest::shouldLearnInterval_data()
+{
+    QTest::addColumn<qint64>("configured");
+    QTest::addColumn<qint64>("previous");
+    QTest::addColumn<int>("newArticles");
+    QTest::addColumn<qint64>("publishing");
+    QTest::addColumn<qint64>("expected");
+    QTest::newRow("nothing new, first time") << hour << qint64(0) << 0 << qint64(0) << 90 * minute;
+    QTest::newRow("nothing new, stretched again") << hour << 90 * minute << 0 << qint64(0) << 135 * minute;
+    QTest::newRow("nothing new, at the maximum") << hour << 15 * hour << 0 << qint64(0) << 16 * hour;
+    QTest::newRow("nothing new, configured longer than a day") << 2 * day << 2 * day << 0 << qint64(0) << 2 * day;
+    QTest::newRow("new articles") << hour << 10 * hour << 3 << 4 * hour << 2 * hour;
+    QTest::newRow("new articles, publishing faster than configured") << hour << 2 * hour << 1 << 10 * minute << hour;
+    QTest::newRow("new articles, publishing slowly") << hour << hour << 1 << 100 * hour << 16 * hour;
+    QTest::newRow("new articles, publishing unknown") << hour << 10 * hour << 1 << qint64(0) << hour;
+}
+
+void FetchSchedulerTest::shouldLearnInterval()
+{
+    QFETCH(qint64, configured);
+    QFETCH(qint64, previous);
+    QFETCH(int, newArticles);
+    QFETCH(qint64, publishing);
+    QFETCH(qint64, expected);
+    QCOMPARE(FetchScheduler::learnInterval(configured, previous, newArticles, publishing), expected);
+}
+
+void FetchSchedulerTest::shouldBackOffAfterFailures_data()
+{
+    QTest::addColumn<qint64>("configured");
+    QTest::addColumn<int>("failures");
+    QTest::addColumn<bool>("parked");
+    QTest::addColumn<qint64>("expected");
+    QTest::newRow("no failure") << hour << 0 << false << hour;
+    QTest::newRow("first failure") << hour << 1 << false << hour;
+    QTest::newRow("second failure") << hour << 2 << false << 2 * hour;
+    QTest::newRow("third failure") << hour << 3 << false << 4 * hour;
+    QTest::newRow("one day at most") << hour << 6 << false << day;
+    QTest::newRow("many failures") << minute << 100 << false << day;
+    QTest::newRow("short interval") << minute << 10 << false << 512 * minute;
+    QTest::newRow("parked") << hour << 2 << true << day;
+    QTest::newRow("parked, configured longer than a day") << 2 * day << 10 << true << 2 * day;
+}
+
+void FetchSchedulerTest::shouldBackOffAfterFailures()
+{
+    QFETCH(qint64, configured);
+    QFETCH(int, failures);
+    QFETCH(bool, parked);
+    QFETCH(qint64, expected);
+    QCOMPARE(FetchScheduler::retryInterval(configured, failures, parked), expected);
+}
+
+void FetchSchedulerTest::shouldSpreadOverdueFeeds_data()
+{
+    constexpr qint64 now = 1'700'000'000'000;
+    QTest::addColumn<qint64>("lastFetch");
+    QTest::addColumn<qint64>("interval");
+    QTest::addColumn<qint64>("now");
+    QTest::addColumn<double>("spread");
+    QTest::addColumn<qint64>("expected");
+    QTest::newRow("due later") << now - 1000 * 1000 << hour << now << 0.5 << now + 2600 * 1000;
+    QTest::newRow("overdue") << now - 2 * hour * 1000 << hour << now << 0.0 << now;
+    QTest::newRow("overdue, spread") << now - 2 * hour * 1000 << hour << now << 0.5 << now + 30 * 1000;
+    QTest::newRow("overdue, spread fully") << now - 2 * hour * 1000 << hour << now << 1.0 << now + 60 * 1000 - 1;
+    QTest::newRow("due now") << now - hour * 1000 << hour << now << 0.25 << now + 15 * 1000;
+    QTest::newRow("never fetched") << qint64(-1) << hour << now << 0.5 << now + 30 * 1000;
+}
+
+void FetchSchedulerTest::shouldSpreadOverdueFeeds()
+{
+    QFETCH(qint64, lastFetch);
+    QFETCH(qint64, interval);
+    QFETCH(qint64, now);
+    QFETCH(double, spread);
+    QFETCH(qint64, expected);
+    QCOMPARE(FetchScheduler::firstDue(lastFetch, interval, now, spread), expected);
+}
+
+#include "moc_fetchschedulertest.cpp"
@@ -0,0 +1,26 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class FetchSchedulerTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FetchSchedulerTest(QObject *parent = nullptr);
+    ~FetchSchedulerTest() override = default;
+private Q_SLOTS:
+    void shouldBoundAdaptiveInterval_data();
+    void shouldBoundAdaptiveInterval();
+    void shouldLearnInterval_data();
+    void shouldLearnInterval();
+    void shouldBackOffAfterFailures_data();
+    void shouldBackOffAfterFailures();
+    void shouldSpreadOverdueFeeds_data();
+    void shouldSpreadOverdueFeeds();
+};
@@ -0,0 +1,214 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "fetchstatisticstest.h"
+#include "akregatorconfig.h"
+#include "feed.h"
+#include "fetchstatistics.h"
+#include "storage/storage.h"
+
+#include <QAbstractItemModelTester>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QStandardPaths>
+#include <QTest>
+
+using namespace Akregator;
+using namespace std::chrono_literals;
+
+QTEST_MAIN(FetchStatisticsTest)
+
+namespace
+{
+[[nodiscard]] FetchTimings timings(FetchTimings::Outcome outcome, std::chrono::milliseconds total, std::chrono::milliseconds merge = 0ms)
+{
+    FetchTimings result;
+    result.outcome = outcome;
+    result.queueWait = 1ms;
+    result.response = 2ms;
+    result.transfer = 3ms;
+    result.parse = 4ms;
+    result.loadArticles = 5ms;
+    result.merge = merge;
+    result.total = total;
+    result.bytes = 1024;
+    result.newArticles = outcome == FetchTimings::Fetched ? 2 : 0;
+    return result;
+}
+
+[[nodiscard]] QVariant sortValue(const FetchStatistics &statistics, int row, int column)
+{
+    return statistics.index(row, column).data(FetchStatistics::SortRole);
+}
+
+void commit(Backend::Storage *storage, std::chrono::milliseconds duration)
+{
+    Backend::Storage::CommitStats stats;
+    stats.feeds = 1;
+    stats.bytesWritten = 2048;
+    stats.duration = duration;
+    Q_EMIT storage->commitFinished(stats);
+}
+}
+
+FetchStatisticsTest::FetchStatisticsTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+FetchStatisticsTest::~FetchStatisticsTest() = default;
+
+void FetchStatisticsTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    // no favicon downloads for the feeds of the tests
+    Settings::setFetchOnStartup(true);
+
+    QVERIFY(mArchiveDir.isValid());
+    mStorage = std::make_unique<Backend::Storage>();
+    mStorage->setArchivePath(mArchiveDir.path());
+    QVERIFY(mStorage->open(true));
+
+    mFeedA = std::make_unique<Feed>(mStorage.get());
+    mFeedA->setTitle(QStringLiteral("Feed A"));
+    mFeedA->setXmlUrl(QStringLiteral("https://a.org/feed.xml"));
+    mFeedB = std::make_unique<Feed>(mStorage.get());
+    mFeedB->setTitle(QStringLiteral("Feed B"));
+    mFeedB->setXmlUrl(QStringLiteral("https://b.org/feed.xml"));
+}
+
+void FetchStatisticsTest::cleanupTestCase()
+{
+    mFeedA.reset();
+    mFeedB.reset();
+    mStorage.reset();
+}
+
+void FetchStatisticsTest::shouldAddOneRowPerFeed()
+{
+    FetchStatistics statistics(mStorage.get());
+    QAbstractItemModelTester tester(&statistics);
+
+    statistics.addFetch(mFeedA.get(), timings(FetchTimings::Fetched, 100ms));
+    statistics.addFetch(mFeedB.get(), timings(FetchTimings::Failed, 50ms));
+    statistics.addFetch(mFeedA.get(), timings(FetchTimings::NotModified, 300ms));
+    QCOMPARE(statistics.rowCount(), 2);
+
+    // the last fetch, and the average over all of them
+    QCOMPARE(sortValue(statistics, 0, FetchStatistics::FeedColumn).toString(), QStringLiteral("Feed A"));
+    QCOMPARE(statistics.index(0, FetchStatistics::FeedColumn).data(Qt::ToolTipRole).toString(), QStringLiteral("https://a.org/feed.xml"));
+    QCOMPARE(sortValue(statistics, 0, FetchStatistics::OutcomeColumn).toInt(), int(FetchTimings::NotModified));
+    QCOMPARE(sortValue(statistics, 0, FetchStatistics::FetchesColumn).toInt(), 2);
+    QCOMPARE(sortValue(statistics, 0, FetchStatistics::TotalColumn).toDouble(), 300.0);
+    QCOMPARE(sortValue(statistics, 0, FetchStatistics::AverageTotalColumn).toDouble(), 200.0);
+    QCOMPARE(sortValue(statistics, 0, FetchStatistics::ResponseColumn).toDouble(), 2.0);
+    QCOMPARE(sortValue(statistics, 0, FetchStatistics::BytesColumn).toLongLong(), qint64(1024));
+    QCOMPARE(sortValue(statistics, 0, FetchStatistics::NewArticlesColumn).toInt(), 0);
+
+    QCOMPARE(sortValue(statistics, 1, FetchStatistics::FeedColumn).toString(), QStringLiteral("Feed B"));
+    QCOMPARE(sortValue(statistics, 1, FetchStatistics::OutcomeColumn).toInt(), int(FetchTimings::Failed));
+    QCOMPARE(sortValue(statistics, 1, FetchStatistics::FetchesColumn).toInt(), 1);
+    QCOMPARE(sortValue(statistics, 1, FetchStatistics::AverageTotalColumn).toDouble(), 50.0);
+
+    statistics.clear();
+    QCOMPARE(statistics.rowCount(), 0);
+}
+
+void FetchStatisticsTest::shouldChargeCommitToMergedFeeds_data()
+{
+    QTest::addColumn<int>("outcome");
+    QTest::addColumn<int>("mergeMsecs");
+    QTest::addColumn<bool>("charged");
+    QTest::newRow("fetched") << int(FetchTimings::Fetched) << 6 << true;
+    QTest::newRow("not modified") << int(FetchTimings::NotModified) << 0 << false;
+    QTest::newRow("failed") << int(FetchTimings::Failed) << 0 << false;
+    QTest::newRow("aborted while merging") << int(FetchTimings::Aborted) << 6 << true;
+    QTest::newRow("aborted before merging") << int(FetchTimings::Aborted) << 0 << false;
+}
+
+void FetchStatisticsTest::shouldChargeCommitToMergedFeeds()
+{
+    QFETCH(int, outcome);
+    QFETCH(int, mergeMsecs);
+    QFETCH(bool, charged);
+    FetchStatistics statistics(mStorage.get());
+
+    statistics.addFetch(mFeedA.get(), timings(static_cast<FetchTimings::Outcome>(outcome), 100ms, std::chrono::milliseconds(mergeMsecs)));
+    commit(mStorage.get(), 40ms);
+    QCOMPARE(sortValue(statistics, 0, FetchStatistics::StorageColumn).toDouble(), charged ? 40.0 : 0.0);
+
+    // a later commit did not write anything of this fetch
+    commit(mStorage.get(), 70ms);
+    QCOMPARE(sortValue(statistics, 0, FetchStatistics::StorageColumn).toDouble(), charged ? 40.0 : 0.0);
+}
+
+void FetchStatisticsTest::shouldDumpJson()
+{
+    FetchStatistics statistics(mStorage.get());
+    statistics.addFetch(mFeedA.get(), timings(FetchTimings::Fetched, 100ms, 6ms));
+    statistics.addFetch(mFeedB.get(), timings(FetchTimings::Failed, 50ms));
+    commit(mStorage.get(), 40ms);
+
+    const QJsonObject json = statistics.toJson();
+    QCOMPARE(json.keys(), (QStringList{QStringLiteral("feeds"), QStringLiteral("lastCommit"), QStringLiteral("stages")}));
+
+    QStringList stageKeys = {QStringLiteral("queueWait"),
+                             QStringLiteral("response"),
+                             QStringLiteral("transfer"),
+                             QStringLiteral("parse"),
+                             QStringLiteral("loadArticles"),
+                             QStringLiteral("merge"),
+                             QStringLiteral("storage"),
+                             QStringLiteral("total")};
+    QStringList feedKeys = stageKeys
+        + QStringList{QStringLiteral("url"),
+                      QStringLiteral("title"),
+                      QStringLiteral("outcome"),
+                      QStringLiteral("finished"),
+                      QStringLiteral("streamed"),
+                      QStringLiteral("bytes"),
+                      QStringLiteral("newArticles"),
+                      QStringLiteral("fetches"),
+                      QStringLiteral("averageTotal")};
+    stageKeys.sort();
+    feedKeys.sort();
+
+    const QJsonArray feeds = json.value(QLatin1StringView("feeds")).toArray();
+    QCOMPARE(feeds.size(), 2);
+    const QJsonObject feedA = feeds.at(0).toObject();
+    QCOMPARE(feedA.keys(), feedKeys);
+    QCOMPARE(feedA.value(QLatin1StringView("url")).toString(), QStringLiteral("https://a.org/feed.xml"));
+    QCOMPARE(feedA.value(QLatin1StringView("title")).toString(), QStringLiteral("Feed A"));
+    QCOMPARE(feedA.value(QLatin1StringView("outcome")).toString(), QStringLiteral("fetched"));
+    QCOMPARE(feedA.value(QLatin1StringView("newArticles")).toInt(), 2);
+    QCOMPARE(feedA.value(QLatin1StringView("fetches")).toInt(), 1);
+    QCOMPARE(feedA.value(QLatin1StringView("total")).toDouble(), 100.0);
+    QCOMPARE(feedA.value(QLatin1StringView("storage")).toDouble(), 40.0);
+    const QJsonObject feedB = feeds.at(1).toObject();
+    QCOMPARE(feedB.keys(), feedKeys);
+    QCOMPARE(feedB.value(QLatin1StringView("outcome")).toString(), QStringLiteral("failed"));
+    QCOMPARE(feedB.value(QLatin1StringView("storage")).toDouble(), 0.0);
+
+    // summed up over the feeds
+    const QJsonObject stages = json.value(QLatin1StringView("stages")).toObject();
+    QCOMPARE(stages.keys(), stageKeys);
+    QCOMPARE(stages.value(QLatin1StringView("total")).toDouble(), 150.0);
+    QCOMPARE(stages.value(QLatin1StringView("merge")).toDouble(), 6.0);
+    QCOMPARE(stages.value(QLatin1StringView("storage")).toDouble(), 40.0);
+
+    const QJsonObject lastCommit = json.value(QLatin1StringView("lastCommit")).toObject();
+    QCOMPARE(lastCommit.keys(),
+             (QStringList{QStringLiteral("bytesWritten"), QStringLiteral("duration"), QStringLiteral("feeds"), QStringLiteral("ok")}));
+    QCOMPARE(lastCommit.value(QLatin1StringView("feeds")).toInt(), 1);
+    QCOMPARE(lastCommit.value(QLatin1StringView("bytesWritten")).toInteger(), qint64(2048));
+    QCOMPARE(lastCommit.value(QLatin1StringView("duration")).toDouble(), 40.0);
+    QCOMPARE(lastCommit.value(QLatin1StringView("ok")).toBool(), true);
+
+    // the D-Bus call hands out the dump as a JSON document
+    QCOMPARE(QJsonDocument::fromJson(QJsonDocument(json).toJson()).object(), json);
+}
+
+#include "moc_fetchstatisticstest.cpp"
@@ -0,0 +1,42 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+#include <QTemporaryDir>
+
+#include <memory>
+
+namespace Akregator
+{
+class Feed;
+namespace Backend
+{
+class Storage;
+}
+}
+
+class FetchStatisticsTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FetchStatisticsTest(QObject *parent = nullptr);
+    ~FetchStatisticsTest() override;
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void shouldAddOneRowPerFeed();
+    void shouldChargeCommitToMergedFeeds_data();
+    void shouldChargeCommitToMergedFeeds();
+    void shouldDumpJson();
+
+private:
+    QTemporaryDir mArchiveDir;
+    std::unique_ptr<Akregator::Backend::Storage> mStorage;
+    std::unique_ptr<Akregator::Feed> mFeedA;
+    std::unique_ptr<Akregator::Feed> mFeedB;
+};
@@ -0,0 +1,259 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "sortcolorizeproxymodeltest.h"
+#include "articlelistview.h"
+#include "articlematcher.h"
+#include "articlemodel.h"
+#include "storage/feedstorage.h"
+#include "storage/storage.h"
+
+#include <QCoreApplication>
+#include <QScopeGuard>
+#include <QSemaphore>
+#include <QTest>
+#include <QThread>
+#include <QThreadPool>
+
+#include <atomic>
+
+using namespace Akregator;
+
+QTEST_MAIN(SortColorizeProxyModelTest)
+
+namespace
+{
+/** enough rows for the filters to be evaluated on the thread pool */
+constexpr int modelRows = 2100;
+/** the articles appended during a filter run */
+constexpr int appendedRows = 10;
+
+[[nodiscard]] int articleNumber(const Article &article)
+{
+    return article.guid().mid(4).toInt();
+}
+
+/** accepts the unread articles and those whose number is a multiple of the divisor.
+    The evaluation of the last article of the model waits until the gate opens. */
+class RowMatcher : public Filters::AbstractMatcher
+{
+public:
+    RowMatcher(int divisor, QSemaphore *gate)
+        : m_divisor(divisor)
+        , m_gate(gate)
+    {
+    }
+
+    bool matches(const Article &article) const override
+    {
+        const int number = articleNumber(article);
+        if (number == modelRows - 1) {
+            m_gate->acquire();
+            m_gate->release();
+        }
+        if (QThread::currentThread() == QCoreApplication::instance()->thread()) {
+            ++m_guiThreadCalls;
+        }
+        ++m_calls;
+        return article.status() == Unread || number % m_divisor == 0;
+    }
+
+    void writeConfig(KConfigGroup *) const override
+    {
+    }
+
+    void readConfig(KConfigGroup *) override
+    {
+    }
+
+    bool operator==(const AbstractMatcher &other) const override
+    {
+        return this == &other;
+    }
+
+    bool operator!=(const AbstractMatcher &other) const override
+    {
+        return this != &other;
+    }
+
+    [[nodiscard]] int calls() const
+    {
+        return m_calls;
+    }
+
+    [[nodiscard]] int guiThreadCalls() const
+    {
+        return m_guiThreadCalls;
+    }
+
+private:
+    const int m_divisor;
+    QSemaphore *const m_gate;
+    mutable std::atomic<int> m_calls{0};
+    mutable std::atomic<int> m_guiThreadCalls{0};
+};
+
+/** the number of articles among the first @p rows whose number is a multiple of @p divisor */
+[[nodiscard]] int multiples(int divisor, int rows)
+{
+    return (rows + divisor - 1) / divisor;
+}
+
+[[nodiscard]] std::vector<QSharedPointer<const Filters::AbstractMatcher>> filters(const QSharedPointer<RowMatcher> &matcher)
+{
+    return {matcher};
+}
+}
+
+SortColorizeProxyModelTest::SortColorizeProxyModelTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+SortColorizeProxyModelTest::~SortColorizeProxyModelTest() = default;
+
+void SortColorizeProxyModelTest::initTestCase()
+{
+    // a task waiting for the gate must not keep the others from running
+    QThreadPool::globalInstance()->setMaxThreadCount(std::max(QThreadPool::globalInstance()->maxThreadCount(), 3));
+
+    QVERIFY(mArchiveDir.isValid());
+    mStorage = std::make_unique<Backend::Storage>();
+    mStorage->setArchivePath(mArchiveDir.path());
+    QVERIFY(mStorage->open(true));
+    Backend::FeedStorage *const archive = mStorage->archiveFor(QStringLiteral("https://example.org/feed"));
+    for (int i = 0; i < modelRows + appendedRows; ++i) {
+        Backend::ArticleData data;
+        data.guid = QStringLiteral("guid%1").arg(i);
+        data.title = QStringLiteral("Article %1").arg(i);
+        archive->addArticle(data);
+
+        Article article(data.guid, nullptr, archive);
+        article.setStatus(Read);
+        mArticles.append(article);
+    }
+}
+
+void SortColorizeProxyModelTest::cleanupTestCase()
+{
+    mArticles.clear();
+    mStorage.reset();
+}
+
+void SortColorizeProxyModelTest::shouldApplyFilterRunResult()
+{
+    QSemaphore gate(1);
+    ArticleModel model(mArticles.mid(0, modelRows));
+    SortColorizeProxyModel proxy;
+    proxy.setSourceModel(&model);
+
+    const auto matcher = QSharedPointer<RowMatcher>::create(3, &gate);
+    proxy.setFilters(filters(matcher));
+    // the old filters stay active until the run finished
+    QCOMPARE(proxy.rowCount(), modelRows);
+
+    QTRY_COMPARE(proxy.rowCount(), multiples(3, modelRows));
+    QCOMPARE(matcher->calls(), modelRows);
+    QCOMPARE(matcher->guiThreadCalls(), 0);
+}
+
+void SortColorizeProxyModelTest::shouldCancelStaleFilterRun()
+{
+    QSemaphore gate;
+    ArticleModel model(mArticles.mid(0, modelRows));
+    SortColorizeProxyModel proxy;
+    proxy.setSourceModel(&model);
+    auto openGate = qScopeGuard([&gate]() {
+        gate.release();
+    });
+
+    // the user typed on before the first run finished
+    const auto stale = QSharedPointer<RowMatcher>::create(2, &gate);
+    proxy.setFilters(filters(stale));
+    const auto current = QSharedPointer<RowMatcher>::create(5, &gate);
+    proxy.setFilters(filters(current));
+    QCOMPARE(proxy.rowCount(), modelRows);
+
+    gate.release();
+    QTRY_COMPARE(proxy.rowCount(), multiples(5, modelRows));
+
+    // the cancelled run ends as well, without its result showing up
+    QThreadPool::globalInstance()->waitForDone();
+    QTest::qWait(50);
+    QCOMPARE(proxy.rowCount(), multiples(5, modelRows));
+    for (int row = 0; row < proxy.rowCount(); ++row) {
+        QCOMPARE(articleNumber(model.article(proxy.mapToSource(proxy.index(row, 0)).row())) % 5, 0);
+    }
+    QCOMPARE(current->guiThreadCalls(), 0);
+    QCOMPARE(stale->guiThreadCalls(), 0);
+}
+
+void SortColorizeProxyModelTest::shouldKeepFilterRunResultWhenRowsAreAppended()
+{
+    QSemaphore gate;
+    ArticleModel model(mArticles.mid(0, modelRows));
+    SortColorizeProxyModel proxy;
+    proxy.setSourceModel(&model);
+    auto openGate = qScopeGuard([&gate]() {
+        gate.release();
+    });
+
+    const auto matcher = QSharedPointer<RowMatcher>::create(3, &gate);
+    proxy.setFilters(filters(matcher));
+    model.articlesAdded(nullptr, mArticles.mid(modelRows, appendedRows));
+    QCOMPARE(proxy.rowCount(), modelRows + appendedRows);
+
+    gate.release();
+    QTRY_COMPARE(proxy.rowCount(), multiples(3, modelRows + appendedRows));
+    // only the appended rows were checked on the GUI thread
+    QCOMPARE(matcher->guiThreadCalls(), appendedRows);
+}
+
+void SortColorizeProxyModelTest::shouldRecheckRowsChangedDuringFilterRun()
+{
+    QSemaphore gate;
+    ArticleModel model(mArticles.mid(0, modelRows));
+    SortColorizeProxyModel proxy;
+    proxy.setSourceModel(&model);
+    Article changed = mArticles.at(1);
+    auto restore = qScopeGuard([&gate, &changed]() {
+        gate.release();
+        changed.setStatus(Read);
+    });
+
+    const auto matcher = QSharedPointer<RowMatcher>::create(3, &gate);
+    proxy.setFilters(filters(matcher));
+    // every row but the gated one was evaluated, the change comes too late for the tasks
+    QTRY_COMPARE(matcher->calls(), modelRows - 1);
+    changed.setStatus(Unread);
+    model.articlesUpdated(nullptr, {changed});
+
+    gate.release();
+    QTRY_COMPARE(proxy.rowCount(), multiples(3, modelRows) + 1);
+    QCOMPARE(matcher->guiThreadCalls(), 1);
+}
+
+void SortColorizeProxyModelTest::shouldRefilterRowsRemovedDuringFilterRun()
+{
+    QSemaphore gate;
+    ArticleModel model(mArticles.mid(0, modelRows));
+    SortColorizeProxyModel proxy;
+    proxy.setSourceModel(&model);
+    auto openGate = qScopeGuard([&gate]() {
+        gate.release();
+    });
+
+    const auto matcher = QSharedPointer<RowMatcher>::create(3, &gate);
+    proxy.setFilters(filters(matcher));
+    model.articlesRemoved(nullptr, {mArticles.at(0)});
+
+    gate.release();
+    // the result does not fit the rows anymore, they are all checked again
+    QTRY_COMPARE(proxy.rowCount(), multiples(3, modelRows) - 1);
+    QCOMPARE(matcher->guiThreadCalls(), modelRows - 1);
+}
+
+#include "moc_sortcolorizeproxymodeltest.cpp"
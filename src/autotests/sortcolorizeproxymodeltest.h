@@ -0,0 +1,43 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "article.h"
+
+#include <QObject>
+#include <QTemporaryDir>
+
+#include <memory>
+
+namespace Akregator
+{
+namespace Backend
+{
+class Storage;
+}
+}
+
+class SortColorizeProxyModelTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SortColorizeProxyModelTest(QObject *parent = nullptr);
+    ~SortColorizeProxyModelTest() override;
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void shouldApplyFilterRunResult();
+    void shouldCancelStaleFilterRun();
+    void shouldKeepFilterRunResultWhenRowsAreAppended();
+    void shouldRecheckRowsChangedDuringFilterRun();
+    void shouldRefilterRowsRemovedDuringFilterRun();
+
+private:
+    QTemporaryDir mArchiveDir;
+    std::unique_ptr<Akregator::Backend::Storage> mStorage;
+    QList<Akregator::Article> mArticles;
+};
@@ -0,0 +1,203 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "feedstreamparsertest.h"
+#include "feed/feedstreamparser.h"
+
+#include <Syndication/Item>
+#include <Syndication/Person>
+
+#include <QTest>
+
+using Akregator::FeedStreamParser;
+
+QTEST_MAIN(FeedStreamParserTest)
+
+namespace
+{
+const QString url = QStringLiteral("https://example.org/feed");
+
+const QByteArray rss2Document = QByteArrayLiteral(
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<rss version=\"2.0\" xmlns:dc=\"http://purl.org/dc/elements/1.1/\">\n"
+    "<channel>\n"
+    "<title>Channel</title>\n"
+    "<link>https://example.org/</link>\n"
+    "<description>Channel description</description>\n"
+    "<item><title>First</title><link>https://example.org/1</link><guid>1</guid><dc:creator>Jane</dc:creator></item>\n"
+    "<item><title>Cr\xc3\xa8me</title><link>https://example.org/2</link><guid>2</guid></item>\n"
+    "</channel>\n"
+    "</rss>\n");
+
+const QByteArray atomDocument = QByteArrayLiteral(
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+    "<feed xmlns=\"http://www.w3.org/2005/Atom\">\n"
+    "<title>Atom Feed</title>\n"
+    "<id>urn:feed</id>\n"
+    "<updated>2026-01-02T00:00:00Z</updated>\n"
+    "<entry><title>One</title><id>urn:1</id><updated>2026-01-01T00:00:00Z</updated></entry>\n"
+    "<entry><title>Two</title><id>urn:2</id><updated>2026-01-02T00:00:00Z</updated></entry>\n"
+    "</feed>\n");
+
+/** passes @p document to @p parser in blocks of @p blockSize bytes, returns the items taken meanwhile */
+QList<Syndication::ItemPtr> addDocument(FeedStreamParser &parser, const QByteArray &document, int blockSize)
+{
+    QList<Syndication::ItemPtr> items;
+    for (qsizetype i = 0; i < document.size(); i += blockSize) {
+        if (!parser.addData(document.mid(i, blockSize))) {
+            break;
+        }
+        if (const Syndication::FeedPtr feed = parser.takeItems()) {
+            items += feed->items();
+        }
+    }
+    return items;
+}
+
+void addBlockSizes()
+{
+    QTest::addColumn<int>("blockSize");
+    QTest::newRow("whole document") << 4096;
+    QTest::newRow("small blocks") << 7;
+    QTest::newRow("single bytes") << 1;
+}
+}
+
+FeedStreamParserTest::FeedStreamParserTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void FeedStreamParserTest::shouldSplitRss2Items_data()
+{
+    addBlockSizes();
+}
+
+void FeedStreamParserTest::shouldSplitRss2Items()
+{
+    QFETCH(int, blockSize);
+    FeedStreamParser parser(url);
+    const QList<Syndication::ItemPtr> items = addDocument(parser, rss2Document, blockSize);
+    QVERIFY(!parser.hasFailed());
+
+    QCOMPARE(items.size(), 2);
+    QCOMPARE(items.at(0)->title(), QStringLiteral("First"));
+    QCOMPARE(items.at(0)->link(), QStringLiteral("https://example.org/1"));
+    QCOMPARE(items.at(1)->title(), QStringLiteral("Crème"));
+    // the prefix declared by the root element is kept in the envelope of the items
+    const QList<Syndication::PersonPtr> authors = items.at(0)->authors();
+    QCOMPARE(authors.size(), 1);
+    QCOMPARE(authors.at(0)->name(), QStringLiteral("Jane"));
+
+    const Syndication::FeedPtr feed = parser.finish();
+    QVERIFY(feed);
+    QVERIFY(!parser.hasFailed());
+    QCOMPARE(feed->title(), QStringLiteral("Channel"));
+    QCOMPARE(feed->description(), QStringLiteral("Channel description"));
+    QVERIFY(feed->items().isEmpty());
+}
+
+void FeedStreamParserTest::shouldSplitAtomEntries_data()
+{
+    addBlockSizes();
+}
+
+void FeedStreamParserTest::shouldSplitAtomEntries()
+{
+    QFETCH(int, blockSize);
+    FeedStreamParser parser(url);
+    const QList<Syndication::ItemPtr> items = addDocument(parser, atomDocument, blockSize);
+    QVERIFY(!parser.hasFailed());
+
+    QCOMPARE(items.size(), 2);
+    QCOMPARE(items.at(0)->title(), QStringLiteral("One"));
+    QCOMPARE(items.at(0)->id(), QStringLiteral("urn:1"));
+    QCOMPARE(items.at(1)->title(), QStringLiteral("Two"));
+    QCOMPARE(items.at(1)->id(), QStringLiteral("urn:2"));
+
+    const Syndication::FeedPtr feed = parser.finish();
+    QVERIFY(feed);
+    QCOMPARE(feed->title(), QStringLiteral("Atom Feed"));
+    QVERIFY(feed->items().isEmpty());
+}
+
+void FeedStreamParserTest::shouldReturnItemsAsTheyComplete()
+{
+    FeedStreamParser parser(url);
+    const qsizetype firstItemEnd = rss2Document.indexOf("</item>") + qsizetype(sizeof("</item>") - 1);
+
+    // nothing before the first item is complete
+    QVERIFY(parser.addData(rss2Document.left(firstItemEnd - 1)));
+    QVERIFY(!parser.takeItems());
+
+    QVERIFY(parser.addData(rss2Document.mid(firstItemEnd - 1, 1)));
+    Syndication::FeedPtr feed = parser.takeItems();
+    QVERIFY(feed);
+    QCOMPARE(feed->items().size(), 1);
+    QCOMPARE(feed->items().at(0)->title(), QStringLiteral("First"));
+    // taken already
+    QVERIFY(!parser.takeItems());
+
+    QVERIFY(parser.addData(rss2Document.mid(firstItemEnd)));
+    feed = parser.takeItems();
+    QVERIFY(feed);
+    QCOMPARE(feed->items().size(), 1);
+    QCOMPARE(feed->items().at(0)->title(), QStringLiteral("Crème"));
+    QVERIFY(parser.finish());
+}
+
+void FeedStreamParserTest::shouldFailOnOtherDocuments_data()
+{
+    QTest::addColumn<QByteArray>("document");
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("text") << QByteArrayLiteral("Service unavailable\n");
+    QTest::newRow("html") << QByteArrayLiteral(
+        "<!DOCTYPE html>\n<html><head><title>Site</title>"
+        "<link rel=\"alternate\" type=\"application/rss+xml\" href=\"/feed\"></head><body></body></html>\n");
+    QTest::newRow("xhtml") << QByteArrayLiteral(
+        "<?xml version=\"1.0\"?>\n<html xmlns=\"http://www.w3.org/1999/xhtml\"><head><title>Site</title>"
+        "<link rel=\"alternate\" type=\"application/rss+xml\" href=\"/feed\"/></head><body/></html>\n");
+    QTest::newRow("rss 1.0") << QByteArrayLiteral(
+        "<?xml version=\"1.0\"?>\n<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\" xmlns=\"http://purl.org/rss/1.0/\">"
+        "<channel rdf:about=\"https://example.org/\"><title>Channel</title></channel>"
+        "<item rdf:about=\"https://example.org/1\"><title>First</title></item></rdf:RDF>\n");
+    QTest::newRow("atom without namespace") << QByteArrayLiteral("<feed><title>Feed</title><entry><title>One</title></entry></feed>");
+    QTest::newRow("mismatched tags") << QByteArrayLiteral("<rss version=\"2.0\"><channel><item><title>First</item></channel></rss>");
+    QTest::newRow("truncated") << rss2Document.left(rss2Document.indexOf("<item>", rss2Document.indexOf("</item>")) + 10);
+}
+
+void FeedStreamParserTest::shouldFailOnOtherDocuments()
+{
+    QFETCH(QByteArray, document);
+    FeedStreamParser parser(url);
+    if (parser.addData(document)) {
+        QVERIFY(!parser.finish());
+    }
+    QVERIFY(parser.hasFailed());
+    QVERIFY(!parser.addData(rss2Document));
+    QVERIFY(!parser.takeItems());
+}
+
+void FeedStreamParserTest::shouldStreamFeedTypesOnly_data()
+{
+    QTest::addColumn<QString>("mimeType");
+    QTest::addColumn<bool>("canStream");
+    QTest::newRow("rss") << QStringLiteral("application/rss+xml") << true;
+    QTest::newRow("atom") << QStringLiteral("application/atom+xml") << true;
+    QTest::newRow("xml") << QStringLiteral("text/xml") << true;
+    QTest::newRow("unknown") << QStringLiteral("application/octet-stream") << true;
+    QTest::newRow("html") << QStringLiteral("text/html") << false;
+    QTest::newRow("xhtml") << QStringLiteral("application/xhtml+xml") << false;
+}
+
+void FeedStreamParserTest::shouldStreamFeedTypesOnly()
+{
+    QFETCH(QString, mimeType);
+    QFETCH(bool, canStream);
+    QCOMPARE(FeedStreamParser::canStream(mimeType), canStream);
+}
+
+#include "moc_feedstreamparsertest.cpp"
@@ -0,0 +1,27 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class FeedStreamParserTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FeedStreamParserTest(QObject *parent = nullptr);
+    ~FeedStreamParserTest() override = default;
+private Q_SLOTS:
+    void shouldSplitRss2Items_data();
+    void shouldSplitRss2Items();
+    void shouldSplitAtomEntries_data();
+    void shouldSplitAtomEntries();
+    void shouldReturnItemsAsTheyComplete();
+    void shouldFailOnOtherDocuments_data();
+    void shouldFailOnOtherDocuments();
+    void shouldStreamFeedTypesOnly_data();
+    void shouldStreamFeedTypesOnly();
+};
@@ -13,6 +13,7 @@
 #include "articlejobs.h"
 #include "config-akregator.h"
 #include "feedretriever.h"
+#include "feedstreamparser.h"
 #include "fetchqueue.h"
 #include "folder.h"
 #include "job/downloadfeediconjob.h"
@@ -30,25 +31,43 @@
 #include <QDateTime>
 #include <QDomDocument>
 #include <QDomElement>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
 #include <QHash>
 #include <QList>
+#include <QPointer>
+#include <QPromise>
 #include <QRandomGenerator>
+#include <QSet>
+#include <QThreadPool>
 #include <QTimer>
 
 #include <QStandardPaths>
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <numeric>
+
 using Syndication::ItemPtr;
 using namespace Akregator;
+using namespace std::chrono_literals;
+
+// time the GUI thread may spend merging fetched articles before yielding to the event loop
+static constexpr auto mergeSliceBudget = 8ms;
+// the spacing of the latest articles tells more about the current publishing rate than the whole archive
+static constexpr qsizetype publishingSamples = 10;
 
-template<typename Key, typename Value, template<typename, typename> class Container>
-QList<Value> valuesToVector(const Container<Key, Value> &container)
+namespace
 {
-    QList<Value> values;
-    values.reserve(container.size());
-    for (const Value &value : container) {
-        values << value;
-    }
-    return values;
+/** status bits of an article as stored in the archive, see Article::Private::Status */
+enum ArchivedStatus {
+    ArchivedDeleted = 0x01,
+    ArchivedNew = 0x04,
+    ArchivedRead = 0x08,
+    ArchivedKeep = 0x10
+};
 }
 
 class Akregator::FeedPrivate
@@ -58,6 +77,13 @@ class Akregator::FeedPrivate
 public:
     explicit FeedPrivate(Backend::Storage *storage, Akregator::Feed *qq);
 
+    /** an item of a fetched document, prepared off the GUI thread */
+    struct PreparedItem {
+        Backend::ArticleData data;
+        bool known = false; // the guid was in the article list when the fetch completed
+        bool changed = false; // known, but with a different hash
+    };
+
     Backend::Storage *m_storage = nullptr;
     bool m_autoFetch = false;
     int m_fetchInterval;
@@ -69,9 +95,35 @@ public:
     bool m_loadLinkedWebsite = false;
 
     Syndication::ErrorCode m_fetchErrorCode;
+    /** the fetch queue dropped the feed because its host kept failing */
+    bool m_fetchSkipped = false;
     int m_fetchTries;
     bool m_followDiscovery = false;
     Syndication::Loader *m_loader = nullptr;
+    /** retriever of the running fetch, owned by m_loader */
+    QPointer<FeedRetriever> m_retriever;
+    /** validators of the fetched document, stored once its articles are merged */
+    QString m_fetchedEtag;
+    QString m_fetchedLastModified;
+    /** retriever and parser of a streaming fetch, see Settings::streamingFetch() */
+    FeedRetriever *m_streamRetriever = nullptr;
+    std::unique_ptr<FeedStreamParser> m_streamParser;
+    /** the document could not be streamed, the retry downloads it as a whole */
+    bool m_streamFallback = false;
+    /** new articles merged by the running or the last fetch */
+    int m_newArticles = 0;
+    /** fetches in a row which failed, mirrored in the archive index */
+    int m_fetchFailures = 0;
+    void setFetchFailures(int failures);
+    /** timings of the running or the last fetch */
+    FetchTimings m_timings;
+    QElapsedTimer m_fetchTimer;
+    /** when the current attempt was started, relative to m_fetchTimer */
+    std::chrono::nanoseconds m_tryStarted{0};
+    /** adds the network figures of @p retriever to m_timings */
+    void addRetrieverTimings(const FeedRetriever *retriever);
+    /** completes m_timings, to be called right before the fetch signals are emitted */
+    void finishTimings(FetchTimings::Outcome outcome);
     bool m_articlesLoaded = false;
     Backend::FeedStorage *m_archive = nullptr;
 
@@ -81,11 +133,30 @@ public:
     QString m_comment;
     QString m_copyright;
 
-    /** list of feed articles */
+    /** compact per-article data, kept for every archived article of this feed.
+        Article objects are only created when needed, see articleAt() */
+    struct HeaderEntry {
+        QString guid;
+        qint64 pubDate = 0; // seconds since epoch
+        uint hash = 0;
+        int status = 0; // status bits as stored in the archive
+        Backend::ArticleRow row;
+    };
+    QList<HeaderEntry> m_headers;
+    QHash<QString, qsizetype> m_headerIndex;
+
+    /** the newest publication dates of m_headers, newest first, see Feed::publishingInterval().
+        Built on first use, then kept up to date as headers come and go. */
+    QList<qint64> m_latestPubDates;
+    bool m_latestPubDatesValid = false;
+    void addLatestPubDate(qint64 pubDate);
+    void removeLatestPubDate(qint64 pubDate);
+
+    /** articles created from m_headers so far */
     QHash<QString, Article> articles;
 
-    /** list of deleted articles. This contains **/
-    QList<Article> m_deletedArticles;
+    /** guids of deleted articles */
+    QSet<QString> m_deletedGuids;
 
     /** caches guids of deleted articles for notification */
 
@@ -93,14 +164,49 @@ public:
     QList<Article> m_removedArticlesNotify;
     QList<Article> m_updatedArticlesNotify;
 
+    /** state of the merge started by beginMerge() */
+    QFutureWatcher<QList<PreparedItem>> *m_prepareWatcher = nullptr;
+    QList<Syndication::FeedPtr> m_pendingDocuments; // documents whose items wait for the worker
+    QHash<QString, uint> m_knownHashes;
+    QList<PreparedItem> m_preparedItems;
+    qsizetype m_preparedPos = 0;
+    QSet<QString> m_mergeDeletedGuids;
+    int m_nudge = 0;
+    bool m_merging = false;
+    bool m_mergeComplete = false; // endMerge() was called, no more items follow
+    void resetMerge();
+    void resetStreaming();
+
+    /** returns the article for header @p index, creating the Article object on first use */
+    Article articleAt(qsizetype index);
+    /** returns the article with @p guid, or a null article if it is not in the list */
+    Article article(const QString &guid);
+    void insertArticle(const Article &article);
+    void removeArticle(const QString &guid);
+    /** re-reads the status bits of @p guid from the archive after the article changed */
+    void syncHeader(const QString &guid);
+
     Feed::ImageInfo m_logoInfo;
     Feed::ImageInfo m_faviconInfo;
 
     QIcon m_favicon;
     QStringList m_activities;
     bool m_activityEnabled = false;
-    mutable int m_totalCount;
-    void setTotalCountDirty() const;
+    /** number of articles not flagged as deleted, kept up to date with the header table */
+    int m_totalCount = 0;
+
+    /** the contribution of an article with archive status @p status to the unread and total counts */
+    [[nodiscard]] static int unreadWeight(int status)
+    {
+        return (status & (ArchivedDeleted | ArchivedRead)) ? 0 : 1;
+    }
+    [[nodiscard]] static int totalWeight(int status)
+    {
+        return (status & ArchivedDeleted) ? 0 : 1;
+    }
+
+    /** adjusts the unread and total counts and passes the change up the folder chain */
+    void addToCounts(int unreadDelta, int totalDelta);
 };
 
 QString Feed::archiveModeToString(ArchiveMode mode)
@@ -191,6 +297,7 @@ Akregator::Feed *Feed::fromOPML(const QDomElement &e, Backend::Storage *storage)
         // Instead of loading the articles, we use the cache from storage
         feed->d->m_archive = storage->archiveFor(xmlUrl);
         feed->d->m_totalCount = feed->d->m_archive->totalCount();
+        feed->d->m_fetchFailures = feed->d->m_archive->fetchFailures();
     }
 
 #if HAVE_ACTIVITY_SUPPORT
@@ -236,7 +343,7 @@ QList<Akregator::Feed *> Feed::feeds()
 
 Article Feed::findArticle(const QString &guid) const
 {
-    return d->articles.value(guid);
+    return d->article(guid);
 }
 
 QList<Article> Feed::articles()
@@ -244,7 +351,12 @@ QList<Article> Feed::articles()
     if (!d->m_articlesLoaded) {
         loadArticles();
     }
-    return valuesToVector(d->articles);
+    QList<Article> list;
+    list.reserve(d->m_headers.size());
+    for (qsizetype i = 0; i < d->m_headers.size(); ++i) {
+        list.append(d->articleAt(i));
+    }
+    return list;
 }
 
 Backend::Storage *Feed::storage()
@@ -258,44 +370,48 @@ void Feed::loadArticles()
         return;
     }
 
+    QElapsedTimer timer;
+    timer.start();
+
     if (!d->m_archive && d->m_storage) {
         d->m_archive = d->m_storage->archiveFor(xmlUrl());
     }
 
-    const QStringList list = d->m_archive->articles();
-    for (QStringList::ConstIterator it = list.constBegin(); it != list.constEnd(); ++it) {
-        Article mya(*it, this, d->m_archive);
-        d->articles[mya.guid()] = mya;
-        if (mya.isDeleted()) {
-            d->m_deletedArticles.append(mya);
-        }
-    }
+    // Only the compact header table is loaded here, titles and Article objects follow on demand
+    const int count = d->m_archive->totalCount();
+    d->m_headers.reserve(count);
+    d->m_headerIndex.reserve(count);
+    d->m_archive->forEachArticleHeader(
+        [this](const Backend::ArticleHeader &header) {
+            FeedPrivate::HeaderEntry entry;
+            entry.guid = header.guid;
+            entry.pubDate = header.pubDate.toSecsSinceEpoch();
+            entry.hash = header.hash;
+            entry.status = header.status;
+            entry.row = header.row;
+            d->m_headerIndex.insert(entry.guid, d->m_headers.size());
+            d->m_headers.append(entry);
+            if (entry.status & ArchivedDeleted) {
+                d->m_deletedGuids.insert(entry.guid);
+            }
+        },
+        false);
 
     d->m_articlesLoaded = true;
+    recalcCounts();
     enforceLimitArticleNumber();
-    recalcUnreadCount();
+    d->m_timings.loadArticles += std::chrono::duration_cast<std::chrono::microseconds>(timer.durationElapsed());
 }
 
-void Feed::recalcUnreadCount()
+void Feed::recalcCounts()
 {
-    QList<Article> tarticles = articles();
-    QList<Article>::ConstIterator it;
-    QList<Article>::ConstIterator en = tarticles.constEnd();
-
-    const int oldUnread = d->m_archive->unread();
-
     int unread = 0;
-
-    for (it = tarticles.constBegin(); it != en; ++it) {
-        if (!(*it).isDeleted() && (*it).status() != Read) {
-            ++unread;
-        }
-    }
-
-    if (unread != oldUnread) {
-        d->m_archive->setUnread(unread);
-        nodeModified();
+    int total = 0;
+    for (const FeedPrivate::HeaderEntry &entry : std::as_const(d->m_headers)) {
+        unread += FeedPrivate::unreadWeight(entry.status);
+        total += FeedPrivate::totalWeight(entry.status);
     }
+    d->addToCounts(unread - this->unread(), total - d->m_totalCount);
 }
 
 Feed::ArchiveMode Feed::stringToArchiveMode(const QString &str)
@@ -332,15 +448,184 @@ Akregator::FeedPrivate::FeedPrivate(Backend::Storage *storage_, Akregator::Feed
     , m_loader(nullptr)
     , m_articlesLoaded(false)
     , m_archive(nullptr)
-    , m_totalCount(-1)
 {
     Q_ASSERT(q);
     Q_ASSERT(m_storage);
 }
 
-void Akregator::FeedPrivate::setTotalCountDirty() const
+void Akregator::FeedPrivate::addToCounts(int unreadDelta, int totalDelta)
+{
+    if (unreadDelta == 0 && totalDelta == 0) {
+        return;
+    }
+    m_totalCount += totalDelta;
+    if (unreadDelta != 0 && m_archive) {
+        m_archive->setUnread(m_archive->unread() + unreadDelta);
+    }
+    if (Folder *const parent = q->parent()) {
+        parent->addToCounts(unreadDelta, totalDelta);
+    }
+    q->nodeModified();
+}
+
+Article Akregator::FeedPrivate::articleAt(qsizetype index)
+{
+    HeaderEntry &entry = m_headers[index];
+    const auto it = articles.constFind(entry.guid);
+    if (it != articles.cend()) {
+        return it.value();
+    }
+    Backend::ArticleHeader header;
+    header.guid = entry.guid;
+    header.hash = entry.hash;
+    header.title = m_archive->title(entry.guid, &entry.row);
+    header.status = entry.status;
+    header.pubDate = QDateTime::fromSecsSinceEpoch(entry.pubDate);
+    header.row = entry.row;
+    const Article article(header, q, m_archive);
+    articles.insert(entry.guid, article);
+    return article;
+}
+
+Article Akregator::FeedPrivate::article(const QString &guid)
+{
+    const qsizetype index = m_headerIndex.value(guid, -1);
+    return index != -1 ? articleAt(index) : Article();
+}
+
+void Akregator::FeedPrivate::insertArticle(const Article &article)
+{
+    const QString guid = article.guid();
+    HeaderEntry entry;
+    entry.guid = guid;
+    entry.pubDate = article.pubDate().toSecsSinceEpoch();
+    entry.hash = article.hash();
+    entry.status = m_archive->status(guid, &entry.row);
+    addLatestPubDate(entry.pubDate);
+    m_headerIndex.insert(guid, m_headers.size());
+    m_headers.append(entry);
+    articles.insert(guid, article);
+    addToCounts(unreadWeight(entry.status), totalWeight(entry.status));
+}
+
+void Akregator::FeedPrivate::removeArticle(const QString &guid)
+{
+    articles.remove(guid);
+    const auto it = m_headerIndex.constFind(guid);
+    if (it == m_headerIndex.cend()) {
+        return;
+    }
+    const qsizetype index = it.value();
+    m_headerIndex.erase(it);
+    const int status = m_headers.at(index).status;
+    removeLatestPubDate(m_headers.at(index).pubDate);
+    // keep the table contiguous by moving the last entry into the gap
+    const qsizetype last = m_headers.size() - 1;
+    if (index != last) {
+        m_headers[index] = std::move(m_headers[last]);
+        m_headerIndex[m_headers.at(index).guid] = index;
+    }
+    m_headers.removeLast();
+    addToCounts(-unreadWeight(status), -totalWeight(status));
+}
+
+void Akregator::FeedPrivate::addLatestPubDate(qint64 pubDate)
+{
+    if (!m_latestPubDatesValid) {
+        return;
+    }
+    // an older date belongs to the list only if it holds all headers; called before the header is added
+    const bool complete = m_latestPubDates.size() == m_headers.size();
+    if (!complete && (m_latestPubDates.isEmpty() || pubDate < m_latestPubDates.constLast())) {
+        return;
+    }
+    m_latestPubDates.insert(std::upper_bound(m_latestPubDates.begin(), m_latestPubDates.end(), pubDate, std::greater<>()), pubDate);
+    if (m_latestPubDates.size() > publishingSamples) {
+        m_latestPubDates.removeLast();
+    }
+}
+
+void Akregator::FeedPrivate::removeLatestPubDate(qint64 pubDate)
+{
+    // the remaining dates are still the newest ones, only fewer of them
+    const auto it = std::find(m_latestPubDates.begin(), m_latestPubDates.end(), pubDate);
+    if (it != m_latestPubDates.end()) {
+        m_latestPubDates.erase(it);
+    }
+}
+
+void Akregator::FeedPrivate::syncHeader(const QString &guid)
+{
+    const qsizetype index = m_headerIndex.value(guid, -1);
+    if (index != -1) {
+        HeaderEntry &entry = m_headers[index];
+        const int oldStatus = entry.status;
+        entry.status = m_archive->status(guid, &entry.row);
+        addToCounts(unreadWeight(entry.status) - unreadWeight(oldStatus), totalWeight(entry.status) - totalWeight(oldStatus));
+    }
+}
+
+void Akregator::FeedPrivate::setFetchFailures(int failures)
+{
+    if (m_fetchFailures == failures) {
+        return;
+    }
+    m_fetchFailures = failures;
+    if (m_archive) {
+        m_archive->setFetchFailures(failures);
+    }
+}
+
+void Akregator::FeedPrivate::addRetrieverTimings(const FeedRetriever *retriever)
+{
+    if (!retriever) {
+        return;
+    }
+    m_timings.response += retriever->responseTime();
+    m_timings.transfer += retriever->transferTime();
+    m_timings.bytes += retriever->bytesReceived();
+    m_timings.failure = retriever->failure();
+}
+
+void Akregator::FeedPrivate::finishTimings(FetchTimings::Outcome outcome)
+{
+    m_timings.outcome = outcome;
+    if (outcome == FetchTimings::Failed && m_timings.failure == FetchTimings::NoFailure) {
+        // retrieved fine, but not usable
+        m_timings.failure = FetchTimings::FeedFailure;
+    }
+    m_timings.total = std::chrono::duration_cast<std::chrono::microseconds>(m_fetchTimer.durationElapsed());
+    m_timings.newArticles = m_newArticles;
+    m_timings.finished = QDateTime::currentDateTime();
+}
+
+void Akregator::FeedPrivate::resetStreaming()
+{
+    if (m_streamRetriever) {
+        m_streamRetriever->disconnect(q);
+        m_streamRetriever->abort();
+        m_streamRetriever->deleteLater();
+        m_streamRetriever = nullptr;
+    }
+    m_streamParser.reset();
+}
+
+void Akregator::FeedPrivate::resetMerge()
 {
-    m_totalCount = -1;
+    if (m_prepareWatcher) {
+        m_prepareWatcher->disconnect(q);
+        m_prepareWatcher->cancel();
+        m_prepareWatcher->deleteLater();
+        m_prepareWatcher = nullptr;
+    }
+    m_pendingDocuments.clear();
+    m_knownHashes.clear();
+    m_preparedItems.clear();
+    m_preparedPos = 0;
+    m_mergeDeletedGuids.clear();
+    m_nudge = 0;
+    m_merging = false;
+    m_mergeComplete = false;
 }
 
 Feed::Feed(Backend::Storage *storage)
@@ -383,7 +668,11 @@ bool Feed::useCustomFetchInterval() const
 
 void Feed::setCustomFetchIntervalEnabled(bool enabled)
 {
+    if (d->m_autoFetch == enabled) {
+        return;
+    }
     d->m_autoFetch = enabled;
+    Q_EMIT fetchIntervalChanged(this);
 }
 
 int Feed::fetchInterval() const
@@ -393,7 +682,71 @@ int Feed::fetchInterval() const
 
 void Feed::setFetchInterval(int interval)
 {
+    if (d->m_fetchInterval == interval) {
+        return;
+    }
     d->m_fetchInterval = interval;
+    Q_EMIT fetchIntervalChanged(this);
+}
+
+int Feed::adaptiveFetchInterval() const
+{
+    return d->m_archive ? d->m_archive->pollInterval() : 0;
+}
+
+void Feed::setAdaptiveFetchInterval(int seconds)
+{
+    if (d->m_archive) {
+        d->m_archive->setPollInterval(seconds);
+    }
+}
+
+int Feed::publishingInterval() const
+{
+    // rebuilt after removals left fewer dates than there are headers to pick from
+    QList<qint64> &dates = d->m_latestPubDates;
+    if (!d->m_latestPubDatesValid || dates.size() < std::min(publishingSamples, d->m_headers.size())) {
+        dates.clear();
+        dates.reserve(d->m_headers.size());
+        for (const FeedPrivate::HeaderEntry &entry : std::as_const(d->m_headers)) {
+            dates.append(entry.pubDate);
+        }
+        const qsizetype count = std::min(publishingSamples, dates.size());
+        std::partial_sort(dates.begin(), dates.begin() + count, dates.end(), std::greater<>());
+        dates.resize(count);
+        dates.squeeze();
+        d->m_latestPubDatesValid = true;
+    }
+    if (dates.size() < 2) {
+        return 0;
+    }
+    return static_cast<int>((dates.constFirst() - dates.constLast()) / (dates.size() - 1));
+}
+
+int Feed::fetchFailures() const
+{
+    return d->m_fetchFailures;
+}
+
+bool Feed::isParked() const
+{
+    const int limit = Settings::fetchFailuresBeforeParking();
+    return limit > 0 && d->m_fetchFailures >= limit;
+}
+
+int Feed::newArticlesOnLastFetch() const
+{
+    return d->m_newArticles;
+}
+
+FetchTimings Feed::fetchTimings() const
+{
+    return d->m_timings;
+}
+
+QDateTime Feed::lastFetch() const
+{
+    return d->m_archive ? d->m_archive->lastFetch() : QDateTime();
 }
 
 int Feed::maxArticleAge() const
@@ -423,7 +776,7 @@ bool Feed::markImmediatelyAsRead() const
 
 bool Feed::isFetching() const
 {
-    return d->m_loader != nullptr;
+    return d->m_loader != nullptr || d->m_streamRetriever != nullptr || d->m_merging;
 }
 
 void Feed::setMarkImmediatelyAsRead(bool enabled)
@@ -552,6 +905,18 @@ Syndication::ErrorCode Feed::fetchErrorCode() const
     return d->m_fetchErrorCode;
 }
 
+bool Feed::fetchSkipped() const
+{
+    return d->m_fetchSkipped;
+}
+
+void Feed::setFetchSkipped()
+{
+    d->m_fetchSkipped = true;
+    d->m_fetchErrorCode = Syndication::OtherRetrieverError;
+    nodeModified();
+}
+
 bool Feed::isArticlesLoaded() const
 {
     return d->m_articlesLoaded;
@@ -617,35 +982,43 @@ QDomElement Feed::toOPML(QDomElement parent, QDomDocument document) const
 KJob *Feed::createMarkAsReadJob()
 {
     auto job = new ArticleModifyJob;
-    const auto arts = articles();
-    for (const Article &i : arts) {
-        const ArticleId aid = {xmlUrl(), i.guid()};
+    loadArticles();
+    for (const FeedPrivate::HeaderEntry &entry : std::as_const(d->m_headers)) {
+        const ArticleId aid = {xmlUrl(), entry.guid};
         job->setStatus(aid, Read);
     }
     return job;
 }
 
-void Feed::slotAddToFetchQueue(FetchQueue *queue, bool intervalFetchOnly)
+void Feed::slotAddToFetchQueue(FetchQueue *queue, bool intervalFetchOnly, FetchPriority priority)
+{
+    if (wantsFetch(intervalFetchOnly)) {
+        queue->addFeed(this, priority);
+    }
+}
+
+bool Feed::wantsFetch(bool intervalFetchOnly) const
 {
+    // parked feeds are only retried by FetchScheduler, or when fetched on their own
+    if (isParked()) {
+        return false;
+    }
     if (!intervalFetchOnly) {
-        queue->addFeed(this);
-    } else {
-        int interval = -1;
+        return true;
+    }
+    int interval = -1;
 
-        if (useCustomFetchInterval()) {
-            interval = fetchInterval() * 60;
-        } else if (Settings::useIntervalFetch()) {
-            interval = Settings::autoFetchInterval() * 60;
-        }
+    if (useCustomFetchInterval()) {
+        interval = fetchInterval() * 60;
+    } else if (Settings::useIntervalFetch()) {
+        interval = Settings::autoFetchInterval() * 60;
+    }
 
-        const uint lastFetch = d->m_archive->lastFetch().toSecsSinceEpoch();
+    const uint lastFetch = d->m_archive->lastFetch().toSecsSinceEpoch();
 
-        const uint now = QDateTime::currentSecsSinceEpoch();
+    const uint now = QDateTime::currentSecsSinceEpoch();
 
-        if (interval > 0 && (now - lastFetch) >= static_cast<uint>(interval)) {
-            queue->addFeed(this);
-        }
-    }
+    return interval > 0 && (now - lastFetch) >= static_cast<uint>(interval);
 }
 
 void Feed::slotAddFeedIconListener()
@@ -659,25 +1032,108 @@ void Feed::slotAddFeedIconListener()
 
 void Feed::appendArticles(const Syndication::FeedPtr &feed)
 {
-    d->setTotalCountDirty();
-    bool changed = false;
-    const bool notify = useNotification() || Settings::useNotifications();
+    beginMerge();
+    prepareItems(feed);
+    endMerge();
+}
+
+void Feed::beginMerge()
+{
+    // Article objects are not thread-safe, so the worker only gets the guids and hashes
+    d->m_knownHashes.clear();
+    d->m_knownHashes.reserve(d->m_headers.size());
+    for (const FeedPrivate::HeaderEntry &entry : std::as_const(d->m_headers)) {
+        d->m_knownHashes.insert(entry.guid, entry.hash);
+    }
+
+    d->m_merging = true;
+    d->m_mergeComplete = false;
+    d->m_mergeDeletedGuids = d->m_deletedGuids;
+}
+
+void Feed::prepareItems(const Syndication::FeedPtr &feed)
+{
+    d->m_pendingDocuments.append(feed);
+    if (!d->m_prepareWatcher) {
+        startPrepare();
+    }
+}
+
+void Feed::endMerge()
+{
+    d->m_mergeComplete = true;
+    if (!d->m_prepareWatcher) {
+        appendPreparedArticles();
+    }
+}
+
+void Feed::startPrepare()
+{
+    const Syndication::FeedPtr feed = d->m_pendingDocuments.takeFirst();
+    auto promise = std::make_shared<QPromise<QList<FeedPrivate::PreparedItem>>>();
+    d->m_prepareWatcher = new QFutureWatcher<QList<FeedPrivate::PreparedItem>>(this);
+    connect(d->m_prepareWatcher, &QFutureWatcherBase::finished, this, &Feed::slotArticlesPrepared);
+    d->m_prepareWatcher->setFuture(promise->future());
+
+    QThreadPool::globalInstance()->start([promise, feed, knownHashes = d->m_knownHashes]() {
+        promise->start();
+        const QList<ItemPtr> items = feed->items();
+        QList<FeedPrivate::PreparedItem> prepared;
+        prepared.reserve(items.size());
+        for (const ItemPtr &item : items) {
+            if (promise->isCanceled()) {
+                break;
+            }
+            FeedPrivate::PreparedItem preparedItem;
+            preparedItem.data = Article::prepareItem(item);
+            const auto known = knownHashes.constFind(preparedItem.data.guid);
+            if (known != knownHashes.cend()) {
+                preparedItem.known = true;
+                preparedItem.changed = !preparedItem.data.guidIsHash && known.value() != preparedItem.data.hash;
+            }
+            prepared.append(std::move(preparedItem));
+        }
+        promise->addResult(prepared);
+        promise->finish();
+    });
+}
+
+void Feed::slotArticlesPrepared()
+{
+    QFutureWatcher<QList<FeedPrivate::PreparedItem>> *watcher = d->m_prepareWatcher;
+    d->m_prepareWatcher = nullptr;
+    watcher->deleteLater();
+    if (watcher->future().resultCount() > 0) {
+        d->m_preparedItems.append(watcher->future().result());
+    }
+    if (!d->m_pendingDocuments.isEmpty()) {
+        startPrepare();
+    }
+    appendPreparedArticles();
+}
 
-    QList<ItemPtr> items = feed->items();
-    QList<ItemPtr>::ConstIterator it = items.constBegin();
-    QList<ItemPtr>::ConstIterator en = items.constEnd();
+void Feed::appendPreparedArticles()
+{
+    if (!d->m_merging) { // aborted meanwhile
+        return;
+    }
 
-    int nudge = 0;
+    bool changed = false;
+    const bool notify = useNotification() || Settings::useNotifications();
 
-    QList<Article> deletedArticles = d->m_deletedArticles;
+    QElapsedTimer timer;
+    timer.start();
 
-    for (; it != en; ++it) {
-        if (!d->articles.contains((*it)->id())) { // article not in list
-            Article mya(*it, this);
-            mya.offsetPubDate(nudge);
-            nudge--;
+    while (d->m_preparedPos < d->m_preparedItems.size()) {
+        const FeedPrivate::PreparedItem item = d->m_preparedItems.at(d->m_preparedPos++);
+        const qsizetype index = d->m_headerIndex.value(item.data.guid, -1);
+        if (index == -1) { // article not in list
+            Article mya(item.data, this);
+            mya.offsetPubDate(d->m_nudge);
+            d->m_nudge--;
             appendArticle(mya);
             d->m_addedArticlesNotify.append(mya);
+            ++d->m_newArticles;
 
             if (!mya.isDeleted() && !markImmediatelyAsRead()) {
                 mya.setStatus(New);
@@ -690,44 +1146,91 @@ void Feed::appendArticles(const Syndication::FeedPtr &feed)
             changed = true;
         } else { // article is in list
             // if the article's guid is no hash but an ID, we have to check if the article was updated. That's done by comparing the hash values.
-            Article old = d->articles[(*it)->id()];
-            Article mya(*it, this);
-            if (!mya.guidIsHash() && mya.hash() != old.hash() && !old.isDeleted()) {
+            // Items seen twice in the same document were not known to the worker, compare here.
+            const FeedPrivate::HeaderEntry &entry = d->m_headers.at(index);
+            const bool oldDeleted = entry.status & ArchivedDeleted;
+            const bool hashChanged = item.known ? item.changed : (!item.data.guidIsHash && item.data.hash != entry.hash);
+            if (hashChanged && !oldDeleted) {
+                Article old = d->articleAt(index);
+                Article mya(item.data, this);
                 mya.setKeep(old.keep());
                 int oldstatus = old.status();
                 old.setStatus(Read);
 
-                d->articles.remove(old.guid());
+                d->removeArticle(old.guid());
                 appendArticle(mya);
 
                 mya.setStatus(oldstatus);
 
                 d->m_updatedArticlesNotify.append(mya);
                 changed = true;
-            } else if (old.isDeleted()) {
-                deletedArticles.removeAll(mya);
+            } else if (oldDeleted) {
+                d->m_mergeDeletedGuids.remove(item.data.guid);
+            } else if (item.data.hasEnclosure) {
+                // the enclosure is not part of the hash, keep it up to date
+                d->m_archive->setEnclosure(item.data.guid,
+                                           item.data.enclosureUrl,
+                                           item.data.enclosureType,
+                                           item.data.enclosureLength,
+                                           &d->m_headers[index].row);
+            }
+        }
+
+        if (timer.durationElapsed() >= mergeSliceBudget && d->m_preparedPos < d->m_preparedItems.size()) {
+            if (changed) {
+                articlesModified();
             }
+            d->m_timings.merge += std::chrono::duration_cast<std::chrono::microseconds>(timer.durationElapsed());
+            QTimer::singleShot(0, this, &Feed::appendPreparedArticles);
+            return;
         }
     }
 
-    QList<Article>::ConstIterator dit = deletedArticles.constBegin();
-    QList<Article>::ConstIterator dtmp;
-    QList<Article>::ConstIterator den = deletedArticles.constEnd();
+    if (changed) {
+        articlesModified();
+    }
+    // a streaming fetch keeps adding items, don't hold on to the merged ones
+    d->m_preparedItems.clear();
+    d->m_preparedPos = 0;
+    d->m_timings.merge += std::chrono::duration_cast<std::chrono::microseconds>(timer.durationElapsed());
+    if (d->m_mergeComplete && !d->m_prepareWatcher) {
+        finishAppendArticles();
+    }
+}
 
+void Feed::finishAppendArticles()
+{
+    QElapsedTimer timer;
+    timer.start();
+    bool changed = false;
     // delete articles with delete flag set completely from archive, which aren't in the current feed source anymore
-    while (dit != den) {
-        dtmp = dit;
-        ++dit;
-        d->articles.remove((*dtmp).guid());
-        d->m_archive->deleteArticle((*dtmp).guid());
-        d->m_removedArticlesNotify.append(*dtmp);
+    for (const QString &guid : std::as_const(d->m_mergeDeletedGuids)) {
+        const Article article = d->article(guid);
+        if (article.isNull()) {
+            continue;
+        }
+        d->removeArticle(guid);
+        d->m_archive->deleteArticle(guid);
+        d->m_removedArticlesNotify.append(article);
         changed = true;
-        d->m_deletedArticles.removeAll(*dtmp);
+        d->m_deletedGuids.remove(guid);
     }
 
+    d->resetMerge();
+
     if (changed) {
         articlesModified();
     }
+
+    // only now a 304 answer means that all items of the document are merged
+    if (d->m_archive) {
+        d->m_archive->setValidators(d->m_fetchedEtag, d->m_fetchedLastModified);
+    }
+    markAsFetchedNow();
+    d->setFetchFailures(0);
+    d->m_timings.merge += std::chrono::duration_cast<std::chrono::microseconds>(timer.durationElapsed());
+    d->finishTimings(FetchTimings::Fetched);
+    Q_EMIT fetched(this);
 }
 
 bool Feed::usesExpiryByAge() const
@@ -735,7 +1238,7 @@ bool Feed::usesExpiryByAge() const
     return (d->m_archiveMode == globalDefault && Settings::archiveMode() == Settings::EnumArchiveMode::limitArticleAge) || d->m_archiveMode == limitArticleAge;
 }
 
-bool Feed::isExpired(const Article &a) const
+bool Feed::isExpired(const QDateTime &pubDate) const
 {
     const QDateTime now = QDateTime::currentDateTime();
     int expiryAge = -1;
@@ -749,30 +1252,33 @@ bool Feed::isExpired(const Article &a) const
         }
     }
 
-    return expiryAge != -1 && a.pubDate().secsTo(now) > expiryAge;
+    return expiryAge != -1 && pubDate.secsTo(now) > expiryAge;
 }
 
 void Feed::appendArticle(const Article &a)
 {
-    if ((a.keep() && Settings::doNotExpireImportantArticles()) || (!usesExpiryByAge() || !isExpired(a))) { // if not expired
-        if (!d->articles.contains(a.guid())) {
-            d->articles[a.guid()] = a;
-            if (!a.isDeleted() && a.status() != Read) {
-                setUnread(unread() + 1);
-            }
+    if ((a.keep() && Settings::doNotExpireImportantArticles()) || (!usesExpiryByAge() || !isExpired(a.pubDate()))) { // if not expired
+        if (!d->m_headerIndex.contains(a.guid())) {
+            d->insertArticle(a);
         }
     }
 }
 
-void Feed::fetch(bool followDiscovery)
+void Feed::fetch(bool followDiscovery, std::chrono::microseconds queueWait)
 {
     d->m_followDiscovery = followDiscovery;
     d->m_fetchTries = 0;
+    d->m_fetchSkipped = false;
+    d->m_streamFallback = false;
+    d->m_newArticles = 0;
+    d->m_timings = {};
+    d->m_timings.queueWait = queueWait;
+    d->m_fetchTimer.start();
 
     // mark all new as unread
-    for (auto it = d->articles.begin(), end = d->articles.end(); it != end; ++it) {
-        if ((*it).status() == New) {
-            (*it).setStatus(Unread);
+    for (qsizetype i = 0; i < d->m_headers.size(); ++i) {
+        if ((d->m_headers.at(i).status & (ArchivedNew | ArchivedRead)) == ArchivedNew) {
+            d->articleAt(i).setStatus(Unread);
         }
     }
 
@@ -783,28 +1289,86 @@ void Feed::fetch(bool followDiscovery)
 
 void Feed::slotAbortFetch()
 {
-    if (d->m_loader) {
+    if (d->m_streamRetriever) {
+        // articles merged so far stay, as when aborting the merge
+        d->resetStreaming();
+        d->resetMerge();
+        d->m_fetchErrorCode = Syndication::Success;
+        markAsFetchedNow();
+        d->finishTimings(FetchTimings::Aborted);
+        Q_EMIT fetchAborted(this);
+    } else if (d->m_loader) {
         d->m_loader->abort();
+    } else if (d->m_merging) {
+        // articles merged so far stay, the remaining ones are dropped
+        d->resetMerge();
+        d->m_fetchErrorCode = Syndication::Success;
+        markAsFetchedNow();
+        d->finishTimings(FetchTimings::Aborted);
+        Q_EMIT fetchAborted(this);
     }
 }
 
 void Feed::tryFetch()
 {
     d->m_fetchErrorCode = Syndication::Success;
+    d->m_tryStarted = d->m_fetchTimer.durationElapsed();
+
+    if (!d->m_archive && d->m_storage) {
+        d->m_archive = d->m_storage->archiveFor(xmlUrl());
+    }
 
+    auto retriever = new FeedRetriever();
+    // validators belong to the stored url, not to one found by discovery
+    if (d->m_archive && d->m_fetchTries == 0) {
+        retriever->setValidators(d->m_archive->etag(), d->m_archive->lastModified());
+    }
+    // a feed being added may turn out to be a web page linking to it, which the loader handles
+    if (Settings::streamingFetch() && !d->m_followDiscovery && d->m_fetchTries == 0 && !d->m_streamFallback) {
+        retriever->setStreaming(true);
+        d->m_timings.streamed = true;
+        d->m_streamRetriever = retriever;
+        d->m_streamParser = std::make_unique<FeedStreamParser>(d->m_xmlUrl);
+        connect(retriever, &FeedRetriever::mimeTypeFound, this, &Feed::slotStreamMimeType);
+        connect(retriever, &FeedRetriever::dataChunk, this, &Feed::slotStreamData);
+        connect(retriever, &Syndication::DataRetriever::dataRetrieved, this, &Feed::slotStreamFinished);
+        retriever->retrieveData(QUrl(d->m_xmlUrl));
+        return;
+    }
+    d->m_retriever = retriever;
     d->m_loader = Syndication::Loader::create(this, SLOT(fetchCompleted(Syndication::Loader *, Syndication::FeedPtr, Syndication::ErrorCode)));
-    d->m_loader->loadFrom(QUrl(d->m_xmlUrl), new FeedRetriever());
+    d->m_loader->loadFrom(QUrl(d->m_xmlUrl), retriever);
 }
 
 void Feed::fetchCompleted(Syndication::Loader *l, Syndication::FeedPtr doc, Syndication::ErrorCode status)
 {
     // Note that loader instances delete themselves
     d->m_loader = nullptr;
+    const QPointer<FeedRetriever> retriever = d->m_retriever;
+    d->m_retriever = nullptr;
+    if (retriever) {
+        d->addRetrieverTimings(retriever);
+        // the loader parses the document right after it was retrieved
+        const auto attempt = d->m_fetchTimer.durationElapsed() - d->m_tryStarted;
+        d->m_timings.parse += std::max(std::chrono::microseconds(0),
+                                       std::chrono::duration_cast<std::chrono::microseconds>(attempt) - retriever->responseTime() - retriever->transferTime());
+    }
+
+    // nothing changed since the last fetch: skip parsing and merging
+    if (retriever && retriever->notModified()) {
+        d->m_fetchErrorCode = Syndication::Success;
+        markAsFetchedNow();
+        d->setFetchFailures(0);
+        d->finishTimings(FetchTimings::NotModified);
+        Q_EMIT fetched(this);
+        return;
+    }
 
     // fetching wasn't successful:
     if (status != Syndication::Success) {
         if (status == Syndication::Aborted) {
             d->m_fetchErrorCode = Syndication::Success;
+            d->finishTimings(FetchTimings::Aborted);
             Q_EMIT fetchAborted(this);
         } else if (d->m_followDiscovery && (status == Syndication::InvalidXml) && (d->m_fetchTries < 3) && (l->discoveredFeedURL().isValid())) {
             d->m_fetchTries++;
@@ -813,6 +1377,8 @@ void Feed::fetchCompleted(Syndication::Loader *l, Syndication::FeedPtr doc, Synd
             tryFetch();
         } else {
             d->m_fetchErrorCode = status;
+            d->setFetchFailures(d->m_fetchFailures + 1);
+            d->finishTimings(FetchTimings::Failed);
             Q_EMIT fetchError(this);
         }
         markAsFetchedNow();
@@ -821,6 +1387,106 @@ void Feed::fetchCompleted(Syndication::Loader *l, Syndication::FeedPtr doc, Synd
 
     loadArticles(); // TODO: make me fly: make this delayed
 
+    updateFromDocument(doc);
+
+    const bool keepValidators = retriever && d->m_fetchTries == 0;
+    d->m_fetchedEtag = keepValidators ? retriever->etag() : QString();
+    d->m_fetchedLastModified = keepValidators ? retriever->lastModified() : QString();
+
+    // markAsFetchedNow() and fetched() follow once the merge is done
+    appendArticles(doc);
+}
+
+void Feed::slotStreamMimeType(const QString &mimeType)
+{
+    // the loader looks for links to feeds in HTML pages, see fetchCompleted()
+    if (!FeedStreamParser::canStream(mimeType)) {
+        streamFallback();
+    }
+}
+
+void Feed::slotStreamData(const QByteArray &data)
+{
+    QElapsedTimer timer;
+    timer.start();
+    Syndication::FeedPtr items;
+    if (d->m_streamParser->addData(data)) {
+        items = d->m_streamParser->takeItems();
+    }
+    d->m_timings.parse += std::chrono::duration_cast<std::chrono::microseconds>(timer.durationElapsed());
+    if (d->m_streamParser->hasFailed()) {
+        streamFallback();
+        return;
+    }
+    if (!items) {
+        return;
+    }
+    if (!d->m_merging) {
+        loadArticles();
+        beginMerge();
+    }
+    prepareItems(items);
+}
+
+void Feed::slotStreamFinished(const QByteArray &, bool success)
+{
+    FeedRetriever *const retriever = d->m_streamRetriever;
+    d->m_streamRetriever = nullptr;
+    retriever->deleteLater();
+    const std::unique_ptr<FeedStreamParser> parser = std::move(d->m_streamParser);
+    d->addRetrieverTimings(retriever);
+
+    if (retriever->notModified()) {
+        d->resetMerge();
+        d->m_fetchErrorCode = Syndication::Success;
+        markAsFetchedNow();
+        d->setFetchFailures(0);
+        d->finishTimings(FetchTimings::NotModified);
+        Q_EMIT fetched(this);
+        return;
+    }
+
+    if (!success) {
+        d->resetMerge();
+        d->m_fetchErrorCode = Syndication::OtherRetrieverError;
+        d->setFetchFailures(d->m_fetchFailures + 1);
+        d->finishTimings(FetchTimings::Failed);
+        Q_EMIT fetchError(this);
+        markAsFetchedNow();
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const Syndication::FeedPtr doc = parser->finish();
+    d->m_timings.parse += std::chrono::duration_cast<std::chrono::microseconds>(timer.durationElapsed());
+    if (!doc) {
+        streamFallback();
+        return;
+    }
+
+    if (!d->m_merging) { // a feed without items
+        loadArticles();
+        beginMerge();
+    }
+    updateFromDocument(doc);
+    d->m_fetchedEtag = retriever->etag();
+    d->m_fetchedLastModified = retriever->lastModified();
+    endMerge();
+}
+
+void Feed::streamFallback()
+{
+    qCDebug(AKREGATOR_LOG) << "Feed" << d->m_xmlUrl << "can't be parsed while downloading, fetching it as a whole";
+    // articles merged so far stay, the full document is merged on top of them
+    d->resetStreaming();
+    d->resetMerge();
+    d->m_streamFallback = true;
+    tryFetch();
+}
+
+void Feed::updateFromDocument(const Syndication::FeedPtr &doc)
+{
     if (!doc->icon().isNull() && !doc->icon()->url().isEmpty()) {
         loadFavicon(doc->icon()->url(), false);
         d->m_faviconInfo.width = doc->icon()->width();
@@ -843,11 +1509,6 @@ void Feed::fetchCompleted(Syndication::Loader *l, Syndication::FeedPtr doc, Synd
     d->m_description = doc->description();
     d->m_copyright = doc->copyright();
     d->m_htmlUrl = doc->link();
-
-    appendArticles(doc);
-
-    markAsFetchedNow();
-    Q_EMIT fetched(this);
 }
 
 void Feed::markAsFetchedNow()
@@ -878,9 +1539,9 @@ void Feed::deleteExpiredArticles(ArticleDeleteJob *deleteJob)
     const QString feedUrl = xmlUrl();
     const bool useKeep = Settings::doNotExpireImportantArticles();
 
-    for (const Article &i : std::as_const(d->articles)) {
-        if ((!useKeep || !i.keep()) && isExpired(i)) {
-            const ArticleId aid = {feedUrl, i.guid()};
+    for (const FeedPrivate::HeaderEntry &entry : std::as_const(d->m_headers)) {
+        if ((!useKeep || !(entry.status & ArchivedKeep)) && isExpired(QDateTime::fromSecsSinceEpoch(entry.pubDate))) {
+            const ArticleId aid = {feedUrl, entry.guid};
             toDelete.append(aid);
         }
     }
@@ -928,35 +1589,19 @@ int Feed::unread() const
     return d->m_archive ? d->m_archive->unread() : 0;
 }
 
-void Feed::setUnread(int unread)
-{
-    if (d->m_archive && unread != d->m_archive->unread()) {
-        d->m_archive->setUnread(unread);
-        nodeModified();
-    }
-}
-
 void Feed::setArticleDeleted(Article &a)
 {
-    d->setTotalCountDirty();
-    if (!d->m_deletedArticles.contains(a)) {
-        d->m_deletedArticles.append(a);
-    }
+    d->m_deletedGuids.insert(a.guid());
+    d->syncHeader(a.guid());
 
     d->m_updatedArticlesNotify.append(a);
     articlesModified();
 }
 
-void Feed::setArticleChanged(Article &a, int oldStatus, bool process)
+void Feed::setArticleChanged(Article &a, int /*oldStatus*/, bool process)
 {
-    int newStatus = a.status();
-    if (oldStatus != -1) {
-        if (oldStatus == Read && newStatus != Read) {
-            setUnread(unread() + 1);
-        } else if (oldStatus != Read && newStatus == Read) {
-            setUnread(unread() - 1);
-        }
-    }
+    // the counts follow the status bits of the header table
+    d->syncHeader(a.guid());
     d->m_updatedArticlesNotify.append(a);
     if (process) {
         articlesModified();
@@ -965,11 +1610,6 @@ void Feed::setArticleChanged(Article &a, int oldStatus, bool process)
 
 int Feed::totalCount() const
 {
-    if (d->m_totalCount == -1) {
-        d->m_totalCount = std::count_if(d->articles.constBegin(), d->articles.constEnd(), [](const Article &art) -> bool {
-            return !art.isDeleted();
-        });
-    }
     return d->m_totalCount;
 }
 
@@ -1042,23 +1682,32 @@ void Feed::enforceLimitArticleNumber()
         limit = maxArticleNumber();
     }
 
-    if (limit == -1 || limit >= d->articles.count() - d->m_deletedArticles.count()) {
+    if (limit == -1 || limit >= d->m_headers.count() - d->m_deletedGuids.count()) {
         return;
     }
 
-    QList<Article> articles = valuesToVector(d->articles);
-    std::sort(articles.begin(), articles.end());
+    // newest first, the same order as Article::operator<
+    QList<qsizetype> order(d->m_headers.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](qsizetype lhs, qsizetype rhs) {
+        const FeedPrivate::HeaderEntry &l = d->m_headers.at(lhs);
+        const FeedPrivate::HeaderEntry &r = d->m_headers.at(rhs);
+        return l.pubDate > r.pubDate || (l.pubDate == r.pubDate && l.guid < r.guid);
+    });
 
     int c = 0;
     const bool useKeep = Settings::doNotExpireImportantArticles();
 
-    for (Article i : std::as_const(articles)) {
+    for (const qsizetype i : std::as_const(order)) {
+        const int status = d->m_headers.at(i).status;
+        const bool keep = status & ArchivedKeep;
+        const bool deleted = status & ArchivedDeleted;
         if (c < limit) {
-            if (!i.isDeleted() && (!useKeep || !i.keep())) {
+            if (!deleted && (!useKeep || !keep)) {
                 ++c;
             }
-        } else if (!useKeep || !i.keep()) {
-            i.setDeleted();
+        } else if (!deleted && (!useKeep || !keep)) {
+            d->articleAt(i).setDeleted();
         }
     }
 }
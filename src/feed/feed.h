@@ -10,6 +10,7 @@
 #pragma once
 
 #include "akregator_export.h"
+#include "fetchtimings.h"
 #include "treenode.h"
 
 #include <Syndication/Syndication>
@@ -18,6 +19,7 @@
 
 #include <memory>
 
+class QDateTime;
 class QDomElement;
 class QString;
 
@@ -40,6 +42,7 @@ class AKREGATOR_EXPORT Feed : public TreeNode
 {
     friend class ::Akregator::Article;
     friend class ::Akregator::Folder;
+    friend class ::Akregator::FeedPrivate;
     Q_OBJECT
 public:
     /** the archiving modes */
@@ -173,6 +176,11 @@ public:
 
     [[nodiscard]] Syndication::ErrorCode fetchErrorCode() const;
 
+    /** returns whether the last fetch was skipped because the host of the feed kept failing */
+    [[nodiscard]] bool fetchSkipped() const;
+    /** marks the feed as skipped by the fetch queue, it then shows a fetch error until it is fetched again */
+    void setFetchSkipped();
+
     /** returns the unread count for this feed */
     [[nodiscard]] int unread() const override;
 
@@ -227,14 +235,40 @@ public:
 
     [[nodiscard]] bool activityEnabled() const;
     void setActivityEnabled(bool b);
+
+    /** the fetch interval learned from the update frequency of this feed, in seconds, or 0 if none was learned yet */
+    [[nodiscard]] int adaptiveFetchInterval() const;
+    void setAdaptiveFetchInterval(int seconds);
+
+    /** estimated time between two articles from the publication dates of the latest ones, in seconds, or 0 if unknown */
+    [[nodiscard]] int publishingInterval() const;
+
+    /** returns how many fetches in a row failed */
+    [[nodiscard]] int fetchFailures() const;
+
+    /** returns @c true if the feed failed so often that it is only retried once a day.
+        Fetching folders or all feeds skips parked feeds. */
+    [[nodiscard]] bool isParked() const;
+
+    /** returns whether slotAddToFetchQueue() would queue this feed */
+    [[nodiscard]] bool wantsFetch(bool intervalFetchOnly = false) const;
+
+    /** returns the number of new articles the last fetch brought in */
+    [[nodiscard]] int newArticlesOnLastFetch() const;
+
+    /** returns when the feed was fetched last */
+    [[nodiscard]] QDateTime lastFetch() const;
+
+    /** returns where the time of the running or the last fetch went */
+    [[nodiscard]] FetchTimings fetchTimings() const;
 public Q_SLOTS:
-    /** starts fetching */
-    void fetch(bool followDiscovery = false);
+    /** starts fetching. @p queueWait is the time the feed waited in the fetch queue, it is kept in fetchTimings(). */
+    void fetch(bool followDiscovery = false, std::chrono::microseconds queueWait = {});
 
     void slotAbortFetch();
 
     /** add this feed to the fetch queue @c queue */
-    void slotAddToFetchQueue(Akregator::FetchQueue *queue, bool intervalFetchOnly = false) override;
+    void slotAddToFetchQueue(Akregator::FetchQueue *queue, bool intervalFetchOnly = false, Akregator::FetchPriority priority = BackgroundFetch) override;
 
     void slotAddFeedIconListener();
 
@@ -249,6 +283,8 @@ Q_SIGNALS:
     void fetchDiscovery(Akregator::Feed *);
     /** emitted when a fetch is aborted */
     void fetchAborted(Akregator::Feed *);
+    /** emitted when the custom fetch interval was changed or toggled */
+    void fetchIntervalChanged(Akregator::Feed *);
 
 private:
     Akregator::Backend::Storage *storage();
@@ -260,13 +296,11 @@ private:
     void loadArticles();
     void enforceLimitArticleNumber();
 
-    void recalcUnreadCount();
+    /** recounts unread and total articles from the header table, e.g. after loading it */
+    void recalcCounts();
 
     void doArticleNotification() override;
 
-    /** sets the unread count for this feed */
-    void setUnread(int unread);
-
     /** notifies that article @c mya was set to "deleted".
         To be called by @ref Article
         */
@@ -281,13 +315,40 @@ private:
         */
     void setArticleChanged(Article &a, int oldStatus = -1, bool process = true);
 
+    /** merges all items of @p feed, see beginMerge() */
     void appendArticles(const Syndication::FeedPtr &feed);
 
+    /** starts merging fetched items. Items are passed in batches via prepareItems(), endMerge() marks the last one. */
+    void beginMerge();
+
+    /** prepares the items of @p feed (field extraction, hashing, diffing against
+        the known articles) in a worker thread, then merges them via appendPreparedArticles() */
+    void prepareItems(const Syndication::FeedPtr &feed);
+
+    /** no more items follow, the merge completes once the queued ones are merged */
+    void endMerge();
+
+    /** hands the next queued batch to the worker */
+    void startPrepare();
+
+    /** merges the next slice of prepared articles into the archive and the article list.
+        Yields to the event loop when the slice exceeds its time budget, to keep the UI responsive. */
+    void appendPreparedArticles();
+
+    /** completes the merge started by beginMerge() and emits fetched() */
+    void finishAppendArticles();
+
+    /** takes title, description, icons etc. from a fetched document */
+    void updateFromDocument(const Syndication::FeedPtr &doc);
+
+    /** gives up parsing the current document while downloading it and fetches it again as a whole */
+    void streamFallback();
+
     /** appends article @c a to the article list */
     void appendArticle(const Article &a);
 
-    /** checks whether article @c a is expired (considering custom and global archive mode settings) */
-    [[nodiscard]] bool isExpired(const Article &a) const;
+    /** checks whether an article published at @p pubDate is expired (considering custom and global archive mode settings) */
+    [[nodiscard]] bool isExpired(const QDateTime &pubDate) const;
 
     /** returns @c true if either this article uses @c limitArticleAge as custom setting or uses the global default, which is @c limitArticleAge */
     [[nodiscard]] bool usesExpiryByAge() const;
@@ -300,6 +361,10 @@ private:
 private Q_SLOTS:
 
     void fetchCompleted(Syndication::Loader *loader, Syndication::FeedPtr doc, Syndication::ErrorCode errorCode);
+    void slotArticlesPrepared();
+    void slotStreamMimeType(const QString &mimeType);
+    void slotStreamData(const QByteArray &data);
+    void slotStreamFinished(const QByteArray &data, bool success);
 
 private:
     std::unique_ptr<FeedPrivate> const d;
@@ -478,10 +478,10 @@ int FeedList::unread() const
     return d->unreadCache;
 }
 
-void FeedList::addToFetchQueue(FetchQueue *qu, bool intervalOnly)
+void FeedList::addToFetchQueue(FetchQueue *qu, bool intervalOnly, FetchPriority priority)
 {
     if (d->rootNode) {
-        d->rootNode->slotAddToFetchQueue(qu, intervalOnly);
+        d->rootNode->slotAddToFetchQueue(qu, intervalOnly, priority);
     }
 }
 
@@ -11,6 +11,7 @@
 #include "akregator_export.h"
 
 #include "feedlistmanagementinterface.h"
+#include "types.h"
 
 #include <QObject>
 
@@ -126,7 +127,7 @@ public:
 
     [[nodiscard]] int unread() const;
 
-    void addToFetchQueue(FetchQueue *queue, bool intervalOnly = false);
+    void addToFetchQueue(FetchQueue *queue, bool intervalOnly = false, Akregator::FetchPriority priority = BackgroundFetch);
     KJob *createMarkAsReadJob();
 
 Q_SIGNALS:
@@ -9,12 +9,36 @@
 #include "feedretriever.h"
 #include "akregator-version.h"
 #include "akregatorconfig.h"
+#include <KIO/Global>
 #include <KIO/StoredTransferJob>
+#include <KIO/TransferJob>
 
 #include <QUrl>
 
 using namespace Akregator;
 
+namespace
+{
+[[nodiscard]] FetchTimings::Failure classifyError(int error, int responseCode)
+{
+    if (responseCode >= 500) {
+        return FetchTimings::HostOverloaded;
+    }
+    switch (error) {
+    case KIO::ERR_UNKNOWN_HOST:
+    case KIO::ERR_CANNOT_CONNECT:
+        return FetchTimings::HostUnreachable;
+    case KIO::ERR_SERVER_TIMEOUT:
+    case KIO::ERR_CONNECTION_BROKEN:
+    case KIO::ERR_INTERNAL_SERVER:
+    case KIO::ERR_SERVICE_NOT_AVAILABLE:
+        return FetchTimings::HostOverloaded;
+    default:
+        return FetchTimings::FeedFailure;
+    }
+}
+}
+
 FeedRetriever::FeedRetriever()
     : Syndication::DataRetriever()
 {
@@ -28,12 +52,39 @@ void FeedRetriever::retrieveData(const QUrl &url)
     }
     bool useCache = Settings::useHTMLCache();
 
-    auto job = KIO::storedGet(url, KIO::NoReload, KIO::HideProgressInfo);
+    KIO::TransferJob *job = mStreaming ? KIO::get(url, KIO::NoReload, KIO::HideProgressInfo) : KIO::storedGet(url, KIO::NoReload, KIO::HideProgressInfo);
     job->addMetaData(QStringLiteral("UserAgent"), userAgent);
     job->addMetaData(QStringLiteral("accept"), QStringLiteral("application/rss+xml;q=0.9, application/atom+xml;q=0.9, text/*;q=0.8, */*;q=0.7"));
     job->addMetaData(QStringLiteral("cache"), useCache ? QStringLiteral("refresh") : QStringLiteral("reload"));
+    job->addMetaData(QStringLiteral("PropagateHttpHeader"), QStringLiteral("true"));
+    QStringList conditions;
+    if (!mEtag.isEmpty()) {
+        conditions.append(QStringLiteral("If-None-Match: ") + mEtag);
+    }
+    if (!mLastModified.isEmpty()) {
+        conditions.append(QStringLiteral("If-Modified-Since: ") + mLastModified);
+    }
+    if (!conditions.isEmpty()) {
+        job->addMetaData(QStringLiteral("customHTTPHeader"), conditions.join(QLatin1StringView("\r\n")));
+    }
+    if (mStreaming) {
+        connect(job, &KIO::TransferJob::data, this, [this](KIO::Job *, const QByteArray &data) {
+            if (!data.isEmpty()) {
+                Q_EMIT dataChunk(data);
+            }
+        });
+    }
+    connect(job, &KIO::TransferJob::mimeTypeFound, this, [this](KIO::Job *, const QString &mimeType) {
+        if (mResponseTime.count() < 0) {
+            mResponseTime = mTimer.durationElapsed();
+        }
+        if (mStreaming) {
+            Q_EMIT mimeTypeFound(mimeType);
+        }
+    });
     connect(job, &KJob::result, this, &FeedRetriever::getFinished);
     mJob = job;
+    mTimer.start();
     mJob->start();
 }
 
@@ -50,15 +101,92 @@ void FeedRetriever::abort()
     }
 }
 
+void FeedRetriever::setValidators(const QString &etag, const QString &lastModified)
+{
+    mEtag = etag;
+    mLastModified = lastModified;
+}
+
+bool FeedRetriever::notModified() const
+{
+    return mNotModified;
+}
+
+QString FeedRetriever::etag() const
+{
+    return mEtag;
+}
+
+QString FeedRetriever::lastModified() const
+{
+    return mLastModified;
+}
+
+void FeedRetriever::setStreaming(bool streaming)
+{
+    mStreaming = streaming;
+}
+
+std::chrono::microseconds FeedRetriever::responseTime() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(mResponseTime.count() < 0 ? mTotalTime : mResponseTime);
+}
+
+std::chrono::microseconds FeedRetriever::transferTime() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(mTotalTime) - responseTime();
+}
+
+qint64 FeedRetriever::bytesReceived() const
+{
+    return mBytesReceived;
+}
+
+FetchTimings::Failure FeedRetriever::failure() const
+{
+    return mFailure;
+}
+
 void FeedRetriever::getFinished(KJob *job)
 {
+    mJob = nullptr;
+    mTotalTime = mTimer.durationElapsed();
+    mBytesReceived = static_cast<qint64>(job->processedAmount(KJob::Bytes));
+    auto transferJob = static_cast<KIO::TransferJob *>(job);
+    if (transferJob->queryMetaData(QStringLiteral("responsecode")) == QLatin1StringView("304")) {
+        mNotModified = true;
+        Q_EMIT dataRetrieved({}, false);
+        return;
+    }
+
     if (job->error()) {
         mError = job->error();
+        if (mError != KJob::KilledJobError) {
+            mFailure = classifyError(mError, transferJob->queryMetaData(QStringLiteral("responsecode")).toInt());
+        }
         Q_EMIT dataRetrieved({}, false);
         return;
     }
 
-    Q_EMIT dataRetrieved(static_cast<KIO::StoredTransferJob *>(job)->data(), true);
+    // remember the validators of this response; without any, the next request is unconditional
+    mEtag.clear();
+    mLastModified.clear();
+    const QStringList headers = transferJob->queryMetaData(QStringLiteral("HTTP-Headers")).split(QLatin1Char('\n'));
+    for (const QString &header : headers) {
+        const qsizetype colon = header.indexOf(QLatin1Char(':'));
+        if (colon <= 0) {
+            continue;
+        }
+        const auto name = QStringView(header).left(colon).trimmed();
+        const QString value = header.mid(colon + 1).trimmed();
+        if (name.compare(QLatin1StringView("ETag"), Qt::CaseInsensitive) == 0) {
+            mEtag = value;
+        } else if (name.compare(QLatin1StringView("Last-Modified"), Qt::CaseInsensitive) == 0) {
+            mLastModified = value;
+        }
+    }
+
+    Q_EMIT dataRetrieved(mStreaming ? QByteArray() : static_cast<KIO::StoredTransferJob *>(job)->data(), true);
 }
 
 #include "moc_feedretriever.cpp"
@@ -8,8 +8,14 @@
 
 #pragma once
 
+#include "fetchtimings.h"
+
 #include <Syndication/DataRetriever>
 
+#include <QElapsedTimer>
+
+#include <chrono>
+
 class KJob;
 
 namespace Akregator
@@ -24,11 +30,48 @@ public:
     void abort() override;
     [[nodiscard]] int errorCode() const override;
 
+    /** makes the request conditional on the validators of the previous response */
+    void setValidators(const QString &etag, const QString &lastModified);
+
+    /** returns @c true if the server answered 304 Not Modified. The retrieval is then reported as failed, without data. */
+    [[nodiscard]] bool notModified() const;
+
+    /** validators of the response */
+    [[nodiscard]] QString etag() const;
+    [[nodiscard]] QString lastModified() const;
+
+    /** delivers the body through dataChunk() while it is downloaded instead of buffering it.
+        dataRetrieved() then carries no data. */
+    void setStreaming(bool streaming);
+
+    /** time from sending the request until the response headers arrived */
+    [[nodiscard]] std::chrono::microseconds responseTime() const;
+    /** time for receiving the body, after the headers */
+    [[nodiscard]] std::chrono::microseconds transferTime() const;
+    [[nodiscard]] qint64 bytesReceived() const;
+    /** classifies the error of a failed retrieval, NoFailure otherwise */
+    [[nodiscard]] FetchTimings::Failure failure() const;
+
+Q_SIGNALS:
+    /** emitted for each block of the body received in streaming mode */
+    void dataChunk(const QByteArray &data);
+    /** emitted in streaming mode once the type of the body is known, before its first block */
+    void mimeTypeFound(const QString &mimeType);
+
 private Q_SLOTS:
     void getFinished(KJob *job);
 
 private:
     KJob *mJob = nullptr;
     int mError = 0;
+    FetchTimings::Failure mFailure = FetchTimings::NoFailure;
+    QString mEtag;
+    QString mLastModified;
+    bool mNotModified = false;
+    bool mStreaming = false;
+    QElapsedTimer mTimer;
+    std::chrono::nanoseconds mResponseTime{-1};
+    std::chrono::nanoseconds mTotalTime{0};
+    qint64 mBytesReceived = 0;
 };
 }
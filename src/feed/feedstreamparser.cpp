@@ -0,0 +1,162 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#include "feedstreamparser.h"
+
+#include <Syndication/Syndication>
+
+using namespace Akregator;
+
+static constexpr QLatin1StringView atomNamespace("http://www.w3.org/2005/Atom");
+
+FeedStreamParser::FeedStreamParser(const QString &url)
+    : mUrl(url)
+    , mSkeletonWriter(&mSkeleton)
+{
+}
+
+FeedStreamParser::~FeedStreamParser() = default;
+
+bool FeedStreamParser::canStream(const QString &mimeType)
+{
+    return mimeType != QLatin1StringView("text/html") && mimeType != QLatin1StringView("application/xhtml+xml");
+}
+
+bool FeedStreamParser::addData(const QByteArray &data)
+{
+    if (mFailed) {
+        return false;
+    }
+    mReader.addData(data);
+    readTokens();
+    return !mFailed;
+}
+
+Syndication::FeedPtr FeedStreamParser::takeItems()
+{
+    if (mFailed || mItems.isEmpty()) {
+        return {};
+    }
+    QByteArray document;
+    document.reserve(mEnvelopeHead.size() + mItems.size() + mEnvelopeTail.size());
+    document += mEnvelopeHead;
+    document += mItems;
+    document += mEnvelopeTail;
+    mItems.clear();
+
+    const Syndication::FeedPtr feed = Syndication::parse(Syndication::DocumentSource(document, mUrl));
+    if (!feed) {
+        mFailed = true;
+    }
+    return feed;
+}
+
+Syndication::FeedPtr FeedStreamParser::finish()
+{
+    if (mFailed || mFormat == Unknown || mReader.tokenType() != QXmlStreamReader::EndDocument) {
+        mFailed = true;
+        return {};
+    }
+    const Syndication::FeedPtr feed = Syndication::parse(Syndication::DocumentSource(mSkeleton, mUrl));
+    if (!feed) {
+        mFailed = true;
+    }
+    return feed;
+}
+
+bool FeedStreamParser::hasFailed() const
+{
+    return mFailed;
+}
+
+void FeedStreamParser::readTokens()
+{
+    while (!mReader.atEnd()) {
+        const QXmlStreamReader::TokenType token = mReader.readNext();
+        switch (token) {
+        case QXmlStreamReader::Invalid:
+            // running out of data is expected, the next block continues the document
+            if (mReader.error() != QXmlStreamReader::PrematureEndOfDocumentError) {
+                mFailed = true;
+            }
+            return;
+        case QXmlStreamReader::DTD:
+            // entities are resolved by the reader already
+            continue;
+        case QXmlStreamReader::StartElement:
+            ++mDepth;
+            if (mDepth == 1) {
+                startDocument();
+                if (mFailed) {
+                    return;
+                }
+            } else if (!mItemWriter && isItemStart()) {
+                mItem.clear();
+                mItemWriter = std::make_unique<QXmlStreamWriter>(&mItem);
+            }
+            break;
+        default:
+            break;
+        }
+
+        QXmlStreamWriter &writer = mItemWriter ? *mItemWriter : mSkeletonWriter;
+        writer.writeCurrentToken(mReader);
+
+        if (token == QXmlStreamReader::EndElement) {
+            if (mItemWriter && mDepth == (mFormat == Rss2 ? 3 : 2)) {
+                mItemWriter.reset();
+                mItems += mItem;
+                mItem.clear();
+            }
+            --mDepth;
+        }
+    }
+}
+
+void FeedStreamParser::startDocument()
+{
+    const QStringView name = mReader.name();
+    const QStringView namespaceUri = mReader.namespaceUri();
+    if (namespaceUri.isEmpty() && name == QLatin1StringView("rss")) {
+        mFormat = Rss2;
+    } else if (namespaceUri == atomNamespace && name == QLatin1StringView("feed")) {
+        mFormat = Atom;
+    } else {
+        mFailed = true;
+        return;
+    }
+
+    // the items are wrapped into a copy of the root element, so that they keep its namespaces and xml:base
+    QXmlStreamWriter head(&mEnvelopeHead);
+    head.writeStartDocument();
+    head.writeStartElement(name.toString());
+    if (!namespaceUri.isEmpty()) {
+        head.writeDefaultNamespace(namespaceUri.toString());
+    }
+    const QXmlStreamNamespaceDeclarations declarations = mReader.namespaceDeclarations();
+    for (const QXmlStreamNamespaceDeclaration &declaration : declarations) {
+        if (!declaration.prefix().isEmpty()) {
+            head.writeNamespace(declaration.namespaceUri().toString(), declaration.prefix().toString());
+        }
+    }
+    head.writeAttributes(mReader.attributes());
+    if (mFormat == Rss2) {
+        head.writeStartElement(QStringLiteral("channel"));
+        mEnvelopeTail = QByteArrayLiteral("</channel></rss>");
+    } else {
+        mEnvelopeTail = QByteArrayLiteral("</feed>");
+    }
+    // closes the start tag
+    head.writeCharacters(QString());
+}
+
+bool FeedStreamParser::isItemStart() const
+{
+    if (mFormat == Rss2) {
+        return mDepth == 3 && mReader.namespaceUri().isEmpty() && mReader.name() == QLatin1StringView("item");
+    }
+    return mDepth == 2 && mReader.namespaceUri() == atomNamespace && mReader.name() == QLatin1StringView("entry");
+}
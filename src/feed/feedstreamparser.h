@@ -0,0 +1,81 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#pragma once
+
+#include "akregator_export.h"
+
+#include <Syndication/Feed>
+
+#include <QByteArray>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include <memory>
+
+namespace Akregator
+{
+/**
+ * Splits an RSS 2.0 or Atom document into its items while it is downloaded.
+ *
+ * Completed items are wrapped into a minimal document of the same format, which
+ * Syndication parses as usual. Everything outside of the items is collected into
+ * a skeleton document that provides the feed's own metadata at the end.
+ * Other formats make the parser fail, the caller then has to parse the whole document.
+ */
+class AKREGATOR_EXPORT FeedStreamParser
+{
+public:
+    explicit FeedStreamParser(const QString &url);
+    ~FeedStreamParser();
+
+    /** whether a response of type @p mimeType may be a feed. HTML pages are not: they have to be
+        parsed as a whole, so that the feeds they link to can be discovered. */
+    [[nodiscard]] static bool canStream(const QString &mimeType);
+
+    /** feeds the next block of the document. Returns @c false if the document can't be streamed. */
+    [[nodiscard]] bool addData(const QByteArray &data);
+
+    /** returns a document containing the items completed since the last call, or a null pointer if there are none */
+    [[nodiscard]] Syndication::FeedPtr takeItems();
+
+    /** to be called once the document is complete. Returns the document without its items,
+        or a null pointer if it was incomplete or invalid. */
+    [[nodiscard]] Syndication::FeedPtr finish();
+
+    [[nodiscard]] bool hasFailed() const;
+
+private:
+    enum Format {
+        Unknown,
+        Rss2,
+        Atom
+    };
+
+    void readTokens();
+    void startDocument();
+    [[nodiscard]] bool isItemStart() const;
+
+    const QString mUrl;
+    QXmlStreamReader mReader;
+    Format mFormat = Unknown;
+    int mDepth = 0;
+    bool mFailed = false;
+
+    /** the document without its items */
+    QByteArray mSkeleton;
+    QXmlStreamWriter mSkeletonWriter;
+
+    /** the root element(s) enclosing the items, written once the root element is known */
+    QByteArray mEnvelopeHead;
+    QByteArray mEnvelopeTail;
+
+    /** the item currently read, and the items completed since the last takeItems() */
+    QByteArray mItem;
+    std::unique_ptr<QXmlStreamWriter> mItemWriter;
+    QByteArray mItems;
+};
+}
@@ -0,0 +1,61 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#pragma once
+
+#include <QDateTime>
+
+#include <chrono>
+
+namespace Akregator
+{
+/** where the time of a single fetch of a feed went, see Feed::fetchTimings() */
+struct FetchTimings {
+    enum Outcome {
+        Running,
+        Fetched,
+        NotModified,
+        Failed,
+        Aborted
+    };
+
+    /** why a failed fetch failed, see FeedRetriever::failure() */
+    enum Failure {
+        NoFailure,
+        /** the feed itself is broken: a client error like 404, or a document which can't be parsed */
+        FeedFailure,
+        /** the host could not be reached: name lookup or connecting failed */
+        HostUnreachable,
+        /** the host answered too late or not properly: timeouts, dropped connections and 5xx errors */
+        HostOverloaded
+    };
+
+    /** time the feed waited in the fetch queue */
+    std::chrono::microseconds queueWait{0};
+    /** from sending the request until the response headers arrived. This covers the name lookup,
+        connecting and the server itself, KIO does not report them separately. */
+    std::chrono::microseconds response{0};
+    /** receiving the body */
+    std::chrono::microseconds transfer{0};
+    /** parsing the document. When streaming, this overlaps the transfer. */
+    std::chrono::microseconds parse{0};
+    /** loading the article headers of the feed from the archive */
+    std::chrono::microseconds loadArticles{0};
+    /** merging the fetched items into the article list, on the GUI thread */
+    std::chrono::microseconds merge{0};
+    /** writing the archive, filled in by FetchStatistics once the changes are committed */
+    std::chrono::microseconds storage{0};
+    /** from the start of the fetch until it finished, without queue wait and storage */
+    std::chrono::microseconds total{0};
+
+    qint64 bytes = 0;
+    int newArticles = 0;
+    Outcome outcome = Running;
+    Failure failure = NoFailure;
+    bool streamed = false;
+    QDateTime finished;
+};
+}
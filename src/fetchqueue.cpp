@@ -8,12 +8,32 @@
 */
 
 #include "fetchqueue.h"
+#include "akregator_debug.h"
 #include "akregatorconfig.h"
 #include "feed.h"
 #include "treenode.h"
 
+#include <QUrl>
+
+#include <algorithm>
+#include <chrono>
+
 using namespace Akregator;
 
+namespace
+{
+/** weight of the latest sample in the moving averages */
+constexpr double sampleWeight = 0.2;
+/** fetches are considered congested when the average latency exceeds the baseline by this factor */
+constexpr double congestionFactor = 3.0;
+/** how fast the baseline follows a higher average latency, so that congestion is relative to the recent past */
+constexpr double baselineDrift = 0.05;
+/** rate of timeouts and server errors above which the limit is halved */
+constexpr double maxErrorRate = 0.5;
+/** failed fetches in a row after which a host is considered down */
+constexpr int maxHostFailures = 3;
+}
+
 FetchQueue::FetchQueue(QObject *parent)
     : QObject(parent)
 {
@@ -26,50 +46,237 @@ FetchQueue::~FetchQueue()
 
 void FetchQueue::slotAbort()
 {
-    for (Feed *const i : std::as_const(m_fetchingFeeds)) {
+    const auto fetching = m_fetchingFeeds.keys();
+    m_fetchingFeeds.clear();
+    for (Feed *const i : fetching) {
         disconnectFromFeed(i);
         i->slotAbortFetch();
     }
-    m_fetchingFeeds.clear();
 
-    for (Feed *const i : std::as_const(m_queuedFeeds)) {
-        disconnectFromFeed(i);
+    for (auto it = m_queuedFeeds.cbegin(), end = m_queuedFeeds.cend(); it != end; ++it) {
+        disconnectFromFeed(it.key());
     }
     m_queuedFeeds.clear();
+    m_hosts.clear();
+    for (Lane &lane : m_lanes) {
+        lane.queued.clear();
+        lane.hostOrder.clear();
+    }
 
     Q_EMIT signalStopped();
 }
 
-void FetchQueue::addFeed(Feed *f)
+QString FetchQueue::hostOf(const Feed *feed)
 {
-    if (!m_queuedFeeds.contains(f) && !m_fetchingFeeds.contains(f)) {
-        connectToFeed(f);
-        m_queuedFeeds.append(f);
-        fetchNextFeed();
+    const QUrl url(feed->xmlUrl());
+    const QString host = url.host().toLower();
+    return host.isEmpty() ? feed->xmlUrl() : host;
+}
+
+void FetchQueue::addFeed(Feed *f, FetchPriority priority)
+{
+    addFeeds({f}, priority);
+}
+
+void FetchQueue::addFeeds(const QList<Feed *> &feeds, FetchPriority priority)
+{
+    const bool wasEmpty = isEmpty();
+    bool added = false;
+    for (Feed *const f : feeds) {
+        if (enqueue(f, priority)) {
+            added = true;
+        }
+    }
+    if (!added) {
+        return;
+    }
+    if (wasEmpty) {
+        // every run probes the network anew
+        m_limit = 0;
+        m_avgLatency = 0.0;
+        m_baseLatency = 0.0;
+        m_errorRate = 0.0;
+        Q_EMIT signalStarted();
+    }
+    fetchNextFeed();
+}
+
+bool FetchQueue::enqueue(Feed *feed, FetchPriority priority)
+{
+    if (m_fetchingFeeds.contains(feed)) {
+        return false;
+    }
+    QElapsedTimer since;
+    const auto it = m_queuedFeeds.constFind(feed);
+    if (it != m_queuedFeeds.cend()) {
+        if (it->priority <= priority) {
+            return false;
+        }
+        // move up to the higher lane
+        since = it->since;
+        removeQueued(feed);
+    } else {
+        connectToFeed(feed);
+        since.start();
+    }
+
+    const QString host = hostOf(feed);
+    Lane &lane = m_lanes[priority];
+    QList<Feed *> &queued = lane.queued[host];
+    if (queued.isEmpty()) {
+        lane.hostOrder.append(host);
     }
+    queued.append(feed);
+    m_queuedFeeds.insert(feed, {host, priority, since});
+    return true;
+}
+
+int FetchQueue::concurrencyLimit() const
+{
+    const int ceiling = std::max(1, Settings::concurrentFetches());
+    return m_limit > 0 ? std::min(m_limit, ceiling) : ceiling;
 }
 
 void FetchQueue::fetchNextFeed()
 {
-    if (!m_queuedFeeds.isEmpty() && m_fetchingFeeds.count() < Settings::concurrentFetches()) {
-        if (m_fetchingFeeds.isEmpty() && m_queuedFeeds.count() == 1) {
-            Q_EMIT signalStarted();
+    for (int priority = InteractiveFetch; priority < FetchPriorityCount; ++priority) {
+        if (m_fetchingFeeds.size() >= concurrencyLimit()) {
+            return;
+        }
+        fetchFromLane(m_lanes[priority], priority == InteractiveFetch);
+    }
+}
+
+void FetchQueue::fetchFromLane(Lane &lane, bool ignoreHostLimit)
+{
+    const int perHost = std::max(1, Settings::concurrentFetchesPerHost());
+    // hosts take turns; a host at its own limit is skipped until one of its fetches is done
+    qsizetype skipped = 0;
+    while (m_fetchingFeeds.size() < concurrencyLimit() && skipped < lane.hostOrder.size()) {
+        const QString host = lane.hostOrder.takeFirst();
+        HostState &state = m_hosts[host];
+        if (!ignoreHostLimit && state.fetching >= perHost) {
+            lane.hostOrder.append(host);
+            ++skipped;
+            continue;
+        }
+        skipped = 0;
+        const auto queuedIt = lane.queued.find(host);
+        Feed *const f = queuedIt->takeFirst();
+        ++state.fetching;
+        if (queuedIt->isEmpty()) {
+            lane.queued.erase(queuedIt);
+        } else {
+            lane.hostOrder.append(host);
+        }
+        const auto queueWait = std::chrono::duration_cast<std::chrono::microseconds>(m_queuedFeeds.take(f).since.durationElapsed());
+
+        m_fetchingFeeds[f].host = host;
+        startFetch(f, queueWait);
+    }
+}
+
+void FetchQueue::startFetch(Feed *feed, std::chrono::microseconds queueWait)
+{
+    feed->fetch(false, queueWait);
+}
+
+FetchTimings FetchQueue::fetchTimings(const Feed *feed) const
+{
+    return feed->fetchTimings();
+}
+
+void FetchQueue::adaptConcurrency(Feed *feed, bool success)
+{
+    if (!m_fetchingFeeds.contains(feed)) {
+        return;
+    }
+    const FetchTimings timings = fetchTimings(feed);
+    // a missing feed or an unknown host says nothing about the load of the network
+    const bool overloaded = !success && timings.failure == FetchTimings::HostOverloaded;
+    m_errorRate = (1.0 - sampleWeight) * m_errorRate + (overloaded ? sampleWeight : 0.0);
+
+    // only the time on the network: parsing and merging grow with the size of the feed
+    const double latency = std::chrono::duration<double, std::milli>(timings.response + timings.transfer).count();
+    if (latency > 0.0) {
+        m_avgLatency = m_avgLatency == 0.0 ? latency : (1.0 - sampleWeight) * m_avgLatency + sampleWeight * latency;
+        if (m_baseLatency == 0.0 || m_avgLatency < m_baseLatency) {
+            m_baseLatency = m_avgLatency;
+        } else {
+            m_baseLatency += baselineDrift * (m_avgLatency - m_baseLatency);
+        }
+    }
+
+    // additive increase, multiplicative decrease on overload
+    const int limit = concurrencyLimit();
+    if (m_errorRate > maxErrorRate) {
+        m_limit = std::max(1, limit / 2);
+    } else if (success && m_avgLatency <= congestionFactor * m_baseLatency) {
+        m_limit = std::min(limit + 1, std::max(1, Settings::concurrentFetches()));
+    } else if (overloaded || m_avgLatency > congestionFactor * m_baseLatency) {
+        m_limit = std::max(1, limit - 1);
+    }
+}
+
+void FetchQueue::countHostResult(Feed *feed, bool success)
+{
+    const auto it = m_fetchingFeeds.constFind(feed);
+    if (it == m_fetchingFeeds.cend()) {
+        return;
+    }
+    const QString host = it->host;
+    const auto hostIt = m_hosts.find(host);
+    if (hostIt == m_hosts.end()) {
+        return;
+    }
+    // a missing or broken feed still proves that the host answers
+    const FetchTimings::Failure failure = success ? FetchTimings::NoFailure : fetchTimings(feed).failure;
+    if (failure != FetchTimings::HostUnreachable && failure != FetchTimings::HostOverloaded) {
+        hostIt->failures = 0;
+        return;
+    }
+    if (++hostIt->failures < maxHostFailures) {
+        return;
+    }
+
+    // don't let the remaining feeds of a dead host take up slots until they time out.
+    // Feeds the user asked for explicitly are tried anyway.
+    QList<Feed *> skipped;
+    for (int priority = InteractiveFetch + 1; priority < FetchPriorityCount; ++priority) {
+        Lane &lane = m_lanes[priority];
+        const auto queuedIt = lane.queued.find(host);
+        if (queuedIt != lane.queued.end()) {
+            skipped += *queuedIt;
+            lane.queued.erase(queuedIt);
+            lane.hostOrder.removeOne(host);
         }
-        Feed *f = *(m_queuedFeeds.begin());
-        m_queuedFeeds.pop_front();
-        m_fetchingFeeds.append(f);
-        f->fetch(false);
+    }
+    if (skipped.isEmpty()) {
+        return;
+    }
+    for (Feed *const f : skipped) {
+        m_queuedFeeds.remove(f);
+        disconnectFromFeed(f);
+    }
+    qCDebug(AKREGATOR_LOG) << "Host" << host << "failed" << hostIt->failures << "times in a row, skipping" << skipped.size() << "feeds";
+    for (Feed *const f : skipped) {
+        f->setFetchSkipped();
+        Q_EMIT fetchSkipped(f);
     }
 }
 
 void FetchQueue::slotFeedFetched(Feed *f)
 {
+    adaptConcurrency(f, true);
+    countHostResult(f, true);
     Q_EMIT fetched(f);
     feedDone(f);
 }
 
 void FetchQueue::slotFetchError(Feed *f)
 {
+    adaptConcurrency(f, false);
+    countHostResult(f, false);
     Q_EMIT fetchError(f);
     feedDone(f);
 }
@@ -85,10 +292,59 @@ bool FetchQueue::isEmpty() const
     return m_queuedFeeds.isEmpty() && m_fetchingFeeds.isEmpty();
 }
 
+void FetchQueue::removeFetching(Feed *feed)
+{
+    const auto it = m_fetchingFeeds.constFind(feed);
+    if (it == m_fetchingFeeds.cend()) {
+        return;
+    }
+    const QString host = it->host;
+    m_fetchingFeeds.erase(it);
+    const auto hostIt = m_hosts.find(host);
+    if (hostIt != m_hosts.end()) {
+        --hostIt->fetching;
+    }
+    releaseHost(host);
+}
+
+void FetchQueue::releaseHost(const QString &host)
+{
+    const auto hostIt = m_hosts.find(host);
+    if (hostIt == m_hosts.end() || hostIt->fetching > 0) {
+        return;
+    }
+    for (const Lane &lane : m_lanes) {
+        if (lane.queued.contains(host)) {
+            return;
+        }
+    }
+    m_hosts.erase(hostIt);
+}
+
+void FetchQueue::removeQueued(Feed *feed)
+{
+    const auto it = m_queuedFeeds.constFind(feed);
+    if (it == m_queuedFeeds.cend()) {
+        return;
+    }
+    const Queued queued = it.value();
+    m_queuedFeeds.erase(it);
+    Lane &lane = m_lanes[queued.priority];
+    const auto queuedIt = lane.queued.find(queued.host);
+    if (queuedIt != lane.queued.end()) {
+        queuedIt->removeOne(feed);
+        if (queuedIt->isEmpty()) {
+            lane.queued.erase(queuedIt);
+            lane.hostOrder.removeOne(queued.host);
+        }
+    }
+    releaseHost(queued.host);
+}
+
 void FetchQueue::feedDone(Feed *f)
 {
     disconnectFromFeed(f);
-    m_fetchingFeeds.removeAll(f);
+    removeFetching(f);
     if (isEmpty()) {
         Q_EMIT signalStopped();
     } else {
@@ -114,8 +370,16 @@ void FetchQueue::slotNodeDestroyed(TreeNode *node)
     Feed *const feed = qobject_cast<Feed *>(node);
     Q_ASSERT(feed);
 
-    m_fetchingFeeds.removeAll(feed);
-    m_queuedFeeds.removeAll(feed);
+    const bool wasEmpty = isEmpty();
+    removeFetching(feed);
+    removeQueued(feed);
+    if (isEmpty()) {
+        if (!wasEmpty) {
+            Q_EMIT signalStopped();
+        }
+    } else {
+        fetchNextFeed();
+    }
 }
 
 #include "moc_fetchqueue.cpp"
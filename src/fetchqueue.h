@@ -10,13 +10,34 @@
 #pragma once
 
 #include "akregator_export.h"
+#include "fetchtimings.h"
+#include "types.h"
+#include <QElapsedTimer>
+#include <QHash>
 #include <QObject>
 
+#include <array>
+#include <chrono>
+
 namespace Akregator
 {
 class Feed;
 class TreeNode;
 
+/** Fetches queued feeds with a limited number of concurrent connections.
+
+    Feeds are queued in priority lanes, see FetchPriority. A free slot always goes to the
+    highest lane with a startable feed; queuing a feed again with a higher priority moves it up.
+    Interactive fetches are only bound by the global limit, so an explicit request starts as
+    soon as one running fetch completes.
+
+    Within a lane, queued feeds are grouped by host. Hosts take turns, and each host gets at most
+    Settings::concurrentFetchesPerHost() parallel fetches, so a slow host does not hold up
+    the feeds of other hosts. The global limit starts at Settings::concurrentFetches()
+    with every run and backs off while the network time of fetches grows or hosts time out.
+    When the host of several fetches in a row can't be reached or doesn't answer, its remaining
+    queued feeds are dropped instead of waiting for their timeouts, except for interactive fetches.
+ */
 class AKREGATOR_EXPORT FetchQueue : public QObject
 {
     Q_OBJECT
@@ -29,7 +50,14 @@ public:
     [[nodiscard]] bool isEmpty() const;
 
     /** adds a feed to the queue */
-    void addFeed(Feed *f);
+    void addFeed(Feed *f, Akregator::FetchPriority priority = BackgroundFetch);
+
+    /** adds several feeds at once. Feeds already fetching or queued with the same or a higher
+        priority are skipped; signalStarted() is emitted at most once for the whole batch. */
+    void addFeeds(const QList<Feed *> &feeds, Akregator::FetchPriority priority = BackgroundFetch);
+
+    /** returns the current global limit of concurrent fetches */
+    [[nodiscard]] int concurrencyLimit() const;
 
 public Q_SLOTS:
 
@@ -42,15 +70,23 @@ Q_SIGNALS:
     void signalStopped();
     void fetched(Akregator::Feed *);
     void fetchError(Akregator::Feed *);
+    /** emitted for queued feeds which were dropped because their host keeps failing, see Feed::fetchSkipped().
+        Interactive fetches are never dropped. */
+    void fetchSkipped(Akregator::Feed *);
 
 protected:
-    /** fetches the next feed in the queue, unless the maximum of concurrent fetches is reached */
+    /** starts queued feeds until the global limit is reached or no host may take another fetch */
     void fetchNextFeed();
 
     void feedDone(Feed *f);
     void connectToFeed(Feed *feed);
     void disconnectFromFeed(Feed *feed);
 
+    /** starts fetching @p feed, which waited @p queueWait in the queue. Overridden by the autotests. */
+    virtual void startFetch(Feed *feed, std::chrono::microseconds queueWait);
+    /** returns the timings of the fetch of @p feed. Overridden by the autotests. */
+    [[nodiscard]] virtual FetchTimings fetchTimings(const Feed *feed) const;
+
 protected Q_SLOTS:
 
     void slotNodeDestroyed(Akregator::TreeNode *node);
@@ -59,7 +95,55 @@ protected Q_SLOTS:
     void slotFetchAborted(Akregator::Feed *);
 
 private:
-    QList<Feed *> m_queuedFeeds;
-    QList<Feed *> m_fetchingFeeds;
+    struct HostState {
+        int fetching = 0;
+        int failures = 0; // failed fetches in a row
+    };
+
+    struct Lane {
+        /** queued feeds per host */
+        QHash<QString, QList<Feed *>> queued;
+        /** hosts with queued feeds, in the order they take turns */
+        QList<QString> hostOrder;
+    };
+
+    struct Queued {
+        QString host;
+        FetchPriority priority = BackgroundFetch;
+        QElapsedTimer since;
+    };
+
+    struct Fetching {
+        QString host;
+    };
+
+    [[nodiscard]] static QString hostOf(const Feed *feed);
+    /** queues @p feed without starting fetches. Returns @c false if it is fetching or already queued with at least @p priority. */
+    bool enqueue(Feed *feed, FetchPriority priority);
+    /** starts feeds of @p lane until the global limit is reached or no host of the lane may take another fetch */
+    void fetchFromLane(Lane &lane, bool ignoreHostLimit);
+    /** forgets the state of @p host once it has neither queued nor running fetches */
+    void releaseHost(const QString &host);
+    /** adapts the global limit to the latency and outcome of the fetch of @p feed, which just finished */
+    void adaptConcurrency(Feed *feed, bool success);
+    /** counts the outcome of the fetch of @p feed for its host, dropping the host's queued feeds if it keeps
+        failing to connect or answer. Failures of the feed itself, like 404 or a broken document, don't count. */
+    void countHostResult(Feed *feed, bool success);
+    void removeQueued(Feed *feed);
+    void removeFetching(Feed *feed);
+
+    /** hosts with queued or running fetches */
+    QHash<QString, HostState> m_hosts;
+    std::array<Lane, FetchPriorityCount> m_lanes;
+    /** host and lane of every queued feed */
+    QHash<Feed *, Queued> m_queuedFeeds;
+    QHash<Feed *, Fetching> m_fetchingFeeds;
+
+    int m_limit = 0;
+    /** moving averages of the network time of fetches (ms) and of the rate of overloaded hosts,
+        and the baseline latency: the lowest average of the run, slowly following higher ones */
+    double m_avgLatency = 0.0;
+    double m_baseLatency = 0.0;
+    double m_errorRate = 0.0;
 };
 } // namespace Akregator
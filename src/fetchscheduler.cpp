@@ -0,0 +1,315 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#include "fetchscheduler.h"
+#include "akregatorconfig.h"
+#include "feed.h"
+#include "feedlist.h"
+#include "fetchqueue.h"
+#include "treenode.h"
+
+#include <QDateTime>
+#include <QRandomGenerator>
+
+#include <algorithm>
+#include <chrono>
+
+using namespace Akregator;
+using namespace std::chrono_literals;
+
+namespace
+{
+/** adaptive intervals stay below this multiple of the configured one... */
+constexpr qint64 maxStretch = 16;
+/** ...and below one day, unless the configured interval is longer */
+constexpr qint64 maxAdaptiveInterval = std::chrono::seconds(24h).count();
+/** growth of the interval after a fetch without new articles */
+constexpr double backoffFactor = 1.5;
+/** due times are spread by up to this fraction of the interval */
+constexpr double jitter = 0.1;
+/** feeds overdue at startup are spread over this time (ms) */
+constexpr qint64 startupSpread = 60 * 1000;
+/** the timer wakes up at least this often, to catch up after suspend and clock changes */
+constexpr auto maxSleep = 1min;
+}
+
+FetchScheduler::FetchScheduler(FetchQueue *queue, QObject *parent)
+    : QObject(parent)
+    , m_queue(queue)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &FetchScheduler::slotTimeout);
+    if (queue) {
+        // the host of a skipped feed is down, retry as if the feed had failed itself
+        connect(queue, &FetchQueue::fetchSkipped, this, &FetchScheduler::slotFetchError);
+    }
+}
+
+FetchScheduler::~FetchScheduler() = default;
+
+void FetchScheduler::setFeedList(const QSharedPointer<FeedList> &list)
+{
+    if (m_feedList == list) {
+        return;
+    }
+    if (m_feedList) {
+        m_feedList->disconnect(this);
+    }
+    m_feedList = list;
+    if (m_feedList) {
+        connect(m_feedList.data(), &FeedList::signalNodeAdded, this, &FetchScheduler::slotNodeAdded);
+        connect(m_feedList.data(), &FeedList::signalNodeRemoved, this, &FetchScheduler::slotNodeRemoved);
+        connect(m_feedList.data(), &FeedList::fetched, this, &FetchScheduler::slotFeedFetched);
+        connect(m_feedList.data(), &FeedList::fetchError, this, &FetchScheduler::slotFetchError);
+        connect(m_feedList.data(), &FeedList::fetchAborted, this, &FetchScheduler::slotFetchAborted);
+    }
+    rescheduleAll();
+}
+
+void FetchScheduler::rescheduleAll()
+{
+    for (auto it = m_scheduled.cbegin(), end = m_scheduled.cend(); it != end; ++it) {
+        it.key()->disconnect(this);
+    }
+    m_scheduled.clear();
+    m_heap = decltype(m_heap)();
+    if (m_feedList) {
+        const QList<Feed *> feeds = m_feedList->feeds();
+        for (Feed *const feed : feeds) {
+            scheduleFromLastFetch(feed);
+        }
+    }
+    restartTimer();
+}
+
+qint64 FetchScheduler::nextFetch(const Feed *feed) const
+{
+    const auto it = m_scheduled.constFind(feed);
+    return it != m_scheduled.cend() ? it->due : -1;
+}
+
+qint64 FetchScheduler::configuredInterval(const Feed *feed)
+{
+    int minutes = -1;
+    if (feed->useCustomFetchInterval()) {
+        minutes = feed->fetchInterval();
+    } else if (Settings::useIntervalFetch()) {
+        minutes = Settings::autoFetchInterval();
+    }
+    return minutes > 0 ? qint64(minutes) * 60 : 0;
+}
+
+qint64 FetchScheduler::boundAdaptiveInterval(qint64 interval, qint64 configured)
+{
+    const qint64 maxInterval = std::max(configured, std::min(configured * maxStretch, maxAdaptiveInterval));
+    return std::clamp(interval, configured, maxInterval);
+}
+
+qint64 FetchScheduler::learnInterval(qint64 configured, qint64 previous, int newArticles, qint64 publishing)
+{
+    qint64 interval = previous > 0 ? previous : configured;
+    if (newArticles > 0) {
+        // fetching twice per publishing interval catches most articles soon after they appear
+        interval = publishing > 0 ? publishing / 2 : configured;
+    } else {
+        // nothing new, or 304 Not Modified
+        interval = static_cast<qint64>(interval * backoffFactor);
+    }
+    return boundAdaptiveInterval(interval, configured);
+}
+
+qint64 FetchScheduler::retryInterval(qint64 configured, int failures, bool parked)
+{
+    const qint64 maxInterval = std::max(configured, maxAdaptiveInterval);
+    if (parked) {
+        return maxInterval;
+    }
+    // double the interval with every failure in a row
+    const int doublings = std::clamp(failures - 1, 0, 16);
+    return std::min(configured << doublings, maxInterval);
+}
+
+qint64 FetchScheduler::firstDue(qint64 lastFetch, qint64 interval, qint64 now, double spread)
+{
+    const qint64 due = lastFetch >= 0 ? lastFetch + interval * 1000 : now;
+    if (due > now) {
+        return due;
+    }
+    return now + std::min(static_cast<qint64>(spread * startupSpread), startupSpread - 1);
+}
+
+void FetchScheduler::scheduleFromLastFetch(Feed *feed)
+{
+    const qint64 configured = configuredInterval(feed);
+    connect(feed, &Feed::fetchIntervalChanged, this, &FetchScheduler::slotFetchIntervalChanged, Qt::UniqueConnection);
+    connect(feed, &TreeNode::signalDestroyed, this, &FetchScheduler::slotNodeRemoved, Qt::UniqueConnection);
+    if (configured <= 0) {
+        return;
+    }
+    qint64 interval = configured;
+    if (feed->fetchFailures() > 0) {
+        interval = retryInterval(configured, feed->fetchFailures(), feed->isParked());
+    } else if (Settings::adaptiveFetchInterval() && feed->adaptiveFetchInterval() > 0) {
+        interval = boundAdaptiveInterval(feed->adaptiveFetchInterval(), configured);
+    }
+
+    const QDateTime lastFetch = feed->lastFetch();
+    schedule(feed,
+             firstDue(lastFetch.isValid() ? lastFetch.toMSecsSinceEpoch() : -1,
+                      interval,
+                      QDateTime::currentMSecsSinceEpoch(),
+                      QRandomGenerator::global()->generateDouble()));
+}
+
+void FetchScheduler::scheduleIn(Feed *feed, qint64 interval)
+{
+    qint64 delay = interval * 1000;
+    if (Settings::adaptiveFetchInterval()) {
+        const auto spread = static_cast<qint64>(delay * jitter);
+        if (spread > 0) {
+            delay += QRandomGenerator::global()->bounded(2 * spread + 1) - spread;
+        }
+    }
+    schedule(feed, QDateTime::currentMSecsSinceEpoch() + delay);
+}
+
+void FetchScheduler::schedule(Feed *feed, qint64 due)
+{
+    Entry entry;
+    entry.due = due;
+    entry.sequence = ++m_sequence;
+    entry.feed = feed;
+    m_scheduled.insert(feed, entry);
+    m_heap.push(entry);
+
+    // drop outdated entries once they make up most of the heap
+    if (m_heap.size() > 2 * size_t(m_scheduled.size()) + 64) {
+        std::vector<Entry> entries;
+        entries.reserve(m_scheduled.size());
+        for (auto it = m_scheduled.cbegin(), end = m_scheduled.cend(); it != end; ++it) {
+            entries.push_back(it.value());
+        }
+        m_heap = decltype(m_heap)(std::greater<>(), std::move(entries));
+    }
+    if (!m_heap.empty() && m_heap.top().sequence == entry.sequence) {
+        restartTimer();
+    }
+}
+
+void FetchScheduler::unschedule(Feed *feed)
+{
+    m_scheduled.remove(feed);
+}
+
+void FetchScheduler::restartTimer()
+{
+    while (!m_heap.empty()) {
+        const Entry &top = m_heap.top();
+        const auto it = m_scheduled.constFind(top.feed);
+        if (it != m_scheduled.cend() && it->sequence == top.sequence) {
+            break;
+        }
+        m_heap.pop();
+    }
+    if (m_heap.empty()) {
+        m_timer.stop();
+        return;
+    }
+    const qint64 delay = std::max<qint64>(0, m_heap.top().due - QDateTime::currentMSecsSinceEpoch());
+    m_timer.start(std::min(std::chrono::milliseconds(delay), std::chrono::milliseconds(maxSleep)));
+}
+
+void FetchScheduler::slotTimeout()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QList<Feed *> due;
+    while (!m_heap.empty() && m_heap.top().due <= now) {
+        const Entry entry = m_heap.top();
+        m_heap.pop();
+        const auto it = m_scheduled.constFind(entry.feed);
+        if (it == m_scheduled.cend() || it->sequence != entry.sequence) {
+            continue;
+        }
+        due.append(entry.feed);
+    }
+    for (Feed *const feed : std::as_const(due)) {
+        const qint64 configured = configuredInterval(feed);
+        if (configured <= 0) {
+            unschedule(feed);
+            continue;
+        }
+        // rescheduled once the fetch is done. Until then the configured interval stands in, for fetches
+        // which end without a result, e.g. when the queue is aborted before the feed got its turn.
+        scheduleIn(feed, configured);
+        if (m_queue) {
+            // parked feeds are queued as well: this is their daily retry
+            m_queue->addFeed(feed, BackgroundFetch);
+        }
+    }
+    restartTimer();
+}
+
+void FetchScheduler::slotNodeAdded(TreeNode *node)
+{
+    auto feed = qobject_cast<Feed *>(node);
+    if (feed && !m_scheduled.contains(feed)) {
+        scheduleFromLastFetch(feed);
+    }
+}
+
+void FetchScheduler::slotNodeRemoved(TreeNode *node)
+{
+    if (auto feed = qobject_cast<Feed *>(node)) {
+        feed->disconnect(this);
+        unschedule(feed);
+    }
+}
+
+void FetchScheduler::slotFeedFetched(Feed *feed)
+{
+    const qint64 configured = configuredInterval(feed);
+    if (configured <= 0) {
+        unschedule(feed);
+        return;
+    }
+    qint64 interval = configured;
+    if (Settings::adaptiveFetchInterval()) {
+        const int newArticles = feed->newArticlesOnLastFetch();
+        interval = learnInterval(configured, feed->adaptiveFetchInterval(), newArticles, newArticles > 0 ? feed->publishingInterval() : 0);
+        feed->setAdaptiveFetchInterval(static_cast<int>(interval));
+    }
+    scheduleIn(feed, interval);
+}
+
+void FetchScheduler::slotFetchError(Feed *feed)
+{
+    const qint64 configured = configuredInterval(feed);
+    if (configured <= 0) {
+        unschedule(feed);
+        return;
+    }
+    scheduleIn(feed, retryInterval(configured, feed->fetchFailures(), feed->isParked()));
+}
+
+void FetchScheduler::slotFetchAborted(Feed *feed)
+{
+    const qint64 configured = configuredInterval(feed);
+    if (configured <= 0) {
+        unschedule(feed);
+        return;
+    }
+    const qint64 learned = Settings::adaptiveFetchInterval() ? feed->adaptiveFetchInterval() : 0;
+    scheduleIn(feed, std::max(configured, learned));
+}
+
+void FetchScheduler::slotFetchIntervalChanged(Feed *feed)
+{
+    unschedule(feed);
+    scheduleFromLastFetch(feed);
+    restartTimer();
+}
+
+#include "moc_fetchscheduler.cpp"
@@ -0,0 +1,108 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#pragma once
+
+#include "akregator_export.h"
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QTimer>
+
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace Akregator
+{
+class Feed;
+class FeedList;
+class FetchQueue;
+class TreeNode;
+
+/** Queues feeds for interval fetching when they are due.
+
+    The feeds are kept in a priority queue ordered by the time of their next fetch, so a tick
+    only looks at the feeds which are actually due. With Settings::adaptiveFetchInterval(),
+    the interval of each feed is learned from its update frequency: fetches which bring nothing
+    new stretch it, new articles pull it back towards half their publishing interval. It never
+    drops below the configured interval. Some jitter keeps feeds from being fetched in lockstep.
+
+    Failing feeds back off exponentially. Parked feeds, see Feed::isParked(), are retried once a day.
+ */
+class AKREGATOR_EXPORT FetchScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FetchScheduler(FetchQueue *queue, QObject *parent = nullptr);
+    ~FetchScheduler() override;
+
+    void setFeedList(const QSharedPointer<FeedList> &list);
+
+    /** recomputes the next fetch of all feeds, e.g. after the global interval was changed */
+    void rescheduleAll();
+
+    /** returns the time of the next interval fetch of @p feed in ms since epoch, or -1 if it is not scheduled */
+    [[nodiscard]] qint64 nextFetch(const Feed *feed) const;
+
+    /** returns the configured fetch interval of @p feed in seconds, or 0 if it is not fetched periodically */
+    [[nodiscard]] static qint64 configuredInterval(const Feed *feed);
+
+    /** returns @p interval within the bounds of adaptive intervals for a feed configured to be
+        fetched every @p configured seconds */
+    [[nodiscard]] static qint64 boundAdaptiveInterval(qint64 interval, qint64 configured);
+    /** returns the interval to use after a successful fetch, in seconds. @p previous is the
+        interval learned so far, 0 if none, @p publishing the one of Feed::publishingInterval(). */
+    [[nodiscard]] static qint64 learnInterval(qint64 configured, qint64 previous, int newArticles, qint64 publishing);
+    /** returns the interval to use after @p failures failed fetches in a row, in seconds */
+    [[nodiscard]] static qint64 retryInterval(qint64 configured, int failures, bool parked);
+    /** returns when a feed is due, in ms since epoch, given its last fetch in ms since epoch, or -1
+        if it was never fetched. Overdue feeds are spread over the first minute from @p now by
+        @p spread, from 0 to 1. */
+    [[nodiscard]] static qint64 firstDue(qint64 lastFetch, qint64 interval, qint64 now, double spread);
+
+private Q_SLOTS:
+    void slotNodeAdded(Akregator::TreeNode *node);
+    void slotNodeRemoved(Akregator::TreeNode *node);
+    void slotFeedFetched(Akregator::Feed *feed);
+    void slotFetchError(Akregator::Feed *feed);
+    void slotFetchAborted(Akregator::Feed *feed);
+    void slotFetchIntervalChanged(Akregator::Feed *feed);
+    void slotTimeout();
+
+private:
+    struct Entry {
+        qint64 due = 0; // ms since epoch
+        quint64 sequence = 0;
+        Feed *feed = nullptr;
+
+        bool operator>(const Entry &other) const
+        {
+            return due > other.due;
+        }
+    };
+
+    /** schedules @p feed from its last fetch, for feeds which were not fetched in this session yet */
+    void scheduleFromLastFetch(Feed *feed);
+    /** schedules @p feed to be fetched @p interval seconds from now */
+    void scheduleIn(Feed *feed, qint64 interval);
+    void schedule(Feed *feed, qint64 due);
+    void unschedule(Feed *feed);
+    void restartTimer();
+
+    QPointer<FetchQueue> m_queue;
+    QSharedPointer<FeedList> m_feedList;
+
+    /** due times; entries are not removed when a feed is rescheduled, but skipped when their sequence is outdated */
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> m_heap;
+    QHash<const Feed *, Entry> m_scheduled;
+    quint64 m_sequence = 0;
+    QTimer m_timer;
+};
+}
@@ -0,0 +1,332 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#include "fetchstatistics.h"
+#include "feed.h"
+#include "feedlist.h"
+#include "treenode.h"
+
+#include <KLocalizedString>
+
+#include <QJsonArray>
+#include <QLocale>
+
+using namespace Akregator;
+
+namespace
+{
+[[nodiscard]] double toMsecs(std::chrono::microseconds duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+/** the stage columns and their keys in the JSON dump */
+struct Stage {
+    FetchStatistics::Column column;
+    const char *key;
+    std::chrono::microseconds FetchTimings::*member;
+};
+
+constexpr Stage stages[] = {
+    {FetchStatistics::QueueWaitColumn, "queueWait", &FetchTimings::queueWait},
+    {FetchStatistics::ResponseColumn, "response", &FetchTimings::response},
+    {FetchStatistics::TransferColumn, "transfer", &FetchTimings::transfer},
+    {FetchStatistics::ParseColumn, "parse", &FetchTimings::parse},
+    {FetchStatistics::LoadArticlesColumn, "loadArticles", &FetchTimings::loadArticles},
+    {FetchStatistics::MergeColumn, "merge", &FetchTimings::merge},
+    {FetchStatistics::StorageColumn, "storage", &FetchTimings::storage},
+    {FetchStatistics::TotalColumn, "total", &FetchTimings::total},
+};
+}
+
+FetchStatistics::FetchStatistics(Backend::Storage *storage, QObject *parent)
+    : QAbstractTableModel(parent)
+{
+    if (storage) {
+        connect(storage, &Backend::Storage::commitFinished, this, &FetchStatistics::slotCommitFinished);
+    }
+}
+
+FetchStatistics::~FetchStatistics() = default;
+
+void FetchStatistics::setFeedList(const QSharedPointer<FeedList> &list)
+{
+    if (m_feedList == list) {
+        return;
+    }
+    if (m_feedList) {
+        m_feedList->disconnect(this);
+    }
+    clear();
+    m_feedList = list;
+    if (m_feedList) {
+        connect(m_feedList.data(), &FeedList::fetched, this, &FetchStatistics::slotFetchDone);
+        connect(m_feedList.data(), &FeedList::fetchError, this, &FetchStatistics::slotFetchDone);
+        connect(m_feedList.data(), &FeedList::fetchAborted, this, &FetchStatistics::slotFetchDone);
+        connect(m_feedList.data(), &FeedList::signalNodeRemoved, this, &FetchStatistics::slotNodeRemoved);
+    }
+}
+
+void FetchStatistics::clear()
+{
+    beginResetModel();
+    m_rows.clear();
+    m_rowIndex.clear();
+    m_awaitingCommit.clear();
+    endResetModel();
+}
+
+int FetchStatistics::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_rows.size());
+}
+
+int FetchStatistics::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QString FetchStatistics::outcomeName(FetchTimings::Outcome outcome)
+{
+    switch (outcome) {
+    case FetchTimings::Running:
+        return QStringLiteral("running");
+    case FetchTimings::Fetched:
+        return QStringLiteral("fetched");
+    case FetchTimings::NotModified:
+        return QStringLiteral("notModified");
+    case FetchTimings::Failed:
+        return QStringLiteral("failed");
+    case FetchTimings::Aborted:
+        return QStringLiteral("aborted");
+    }
+    return {};
+}
+
+QVariant FetchStatistics::value(const Row &row, int column) const
+{
+    for (const Stage &stage : stages) {
+        if (stage.column == column) {
+            return toMsecs(row.last.*stage.member);
+        }
+    }
+    switch (column) {
+    case FeedColumn:
+        return row.title;
+    case OutcomeColumn:
+        return static_cast<int>(row.last.outcome);
+    case AverageTotalColumn:
+        return row.fetches > 0 ? toMsecs(row.sumTotal) / row.fetches : 0.0;
+    case BytesColumn:
+        return row.last.bytes;
+    case NewArticlesColumn:
+        return row.last.newArticles;
+    case FetchesColumn:
+        return row.fetches;
+    }
+    return {};
+}
+
+QVariant FetchStatistics::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size()) {
+        return {};
+    }
+    const Row &row = m_rows.at(index.row());
+    const int column = index.column();
+
+    switch (role) {
+    case SortRole:
+        return value(row, column);
+    case Qt::ToolTipRole:
+        return column == FeedColumn ? row.url : QVariant();
+    case Qt::TextAlignmentRole:
+        return column > OutcomeColumn ? QVariant(Qt::AlignRight | Qt::AlignVCenter) : QVariant();
+    case Qt::DisplayRole:
+        break;
+    default:
+        return {};
+    }
+
+    switch (column) {
+    case FeedColumn:
+        return row.title;
+    case OutcomeColumn:
+        switch (row.last.outcome) {
+        case FetchTimings::Running:
+            return i18nc("fetch outcome", "Running");
+        case FetchTimings::Fetched:
+            return row.last.streamed ? i18nc("fetch outcome", "Fetched (streamed)") : i18nc("fetch outcome", "Fetched");
+        case FetchTimings::NotModified:
+            return i18nc("fetch outcome", "Not modified");
+        case FetchTimings::Failed:
+            return i18nc("fetch outcome", "Failed");
+        case FetchTimings::Aborted:
+            return i18nc("fetch outcome", "Aborted");
+        }
+        return {};
+    case BytesColumn:
+        return QLocale().formattedDataSize(row.last.bytes);
+    case NewArticlesColumn:
+    case FetchesColumn:
+        return value(row, column);
+    default:
+        return i18nc("duration in milliseconds", "%1 ms", QLocale().toString(value(row, column).toDouble(), 'f', 1));
+    }
+}
+
+QVariant FetchStatistics::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return {};
+    }
+
+    switch (section) {
+    case FeedColumn:
+        return i18nc("Fetch statistics column header", "Feed");
+    case OutcomeColumn:
+        return i18nc("Fetch statistics column header", "Result");
+    case QueueWaitColumn:
+        return i18nc("Fetch statistics column header", "Queued");
+    case ResponseColumn:
+        return i18nc("Fetch statistics column header", "Response");
+    case TransferColumn:
+        return i18nc("Fetch statistics column header", "Transfer");
+    case ParseColumn:
+        return i18nc("Fetch statistics column header", "Parse");
+    case LoadArticlesColumn:
+        return i18nc("Fetch statistics column header", "Load");
+    case MergeColumn:
+        return i18nc("Fetch statistics column header", "Merge");
+    case StorageColumn:
+        return i18nc("Fetch statistics column header", "Write");
+    case TotalColumn:
+        return i18nc("Fetch statistics column header", "Total");
+    case AverageTotalColumn:
+        return i18nc("Fetch statistics column header", "Average");
+    case BytesColumn:
+        return i18nc("Fetch statistics column header", "Size");
+    case NewArticlesColumn:
+        return i18nc("Fetch statistics column header", "New");
+    case FetchesColumn:
+        return i18nc("Fetch statistics column header", "Fetches");
+    }
+    return {};
+}
+
+void FetchStatistics::slotFetchDone(Feed *feed)
+{
+    addFetch(feed, feed->fetchTimings());
+}
+
+void FetchStatistics::addFetch(const Feed *feed, const FetchTimings &timings)
+{
+    qsizetype index = m_rowIndex.value(feed, -1);
+    if (index == -1) {
+        index = m_rows.size();
+        beginInsertRows(QModelIndex(), index, index);
+        Row row;
+        row.feed = feed;
+        m_rows.append(row);
+        m_rowIndex.insert(feed, index);
+        endInsertRows();
+    }
+
+    Row &row = m_rows[index];
+    row.title = feed->title();
+    row.url = feed->xmlUrl();
+    row.last = timings;
+    ++row.fetches;
+    row.sumTotal += row.last.total;
+    // a 304 answer, a failure or an abort before merging leaves nothing to write.
+    // The articles merged before an abort stay and are written with the next commit.
+    const bool merged = row.last.outcome == FetchTimings::Aborted && row.last.merge.count() > 0;
+    if (row.last.outcome == FetchTimings::Fetched || merged) {
+        m_awaitingCommit.insert(feed);
+    } else {
+        m_awaitingCommit.remove(feed);
+    }
+    rowChanged(index);
+}
+
+void FetchStatistics::slotCommitFinished(const Backend::Storage::CommitStats &stats)
+{
+    m_lastCommit = stats;
+    const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stats.duration);
+    for (const Feed *const feed : std::as_const(m_awaitingCommit)) {
+        const qsizetype index = m_rowIndex.value(feed, -1);
+        if (index != -1) {
+            m_rows[index].last.storage = duration;
+            rowChanged(index);
+        }
+    }
+    m_awaitingCommit.clear();
+}
+
+void FetchStatistics::slotNodeRemoved(TreeNode *node)
+{
+    auto feed = qobject_cast<const Feed *>(node);
+    const qsizetype index = m_rowIndex.value(feed, -1);
+    if (index == -1) {
+        return;
+    }
+    beginRemoveRows(QModelIndex(), index, index);
+    m_rows.removeAt(index);
+    m_rowIndex.remove(feed);
+    m_awaitingCommit.remove(feed);
+    for (qsizetype i = index; i < m_rows.size(); ++i) {
+        m_rowIndex[m_rows.at(i).feed] = i;
+    }
+    endRemoveRows();
+}
+
+void FetchStatistics::rowChanged(qsizetype row)
+{
+    Q_EMIT dataChanged(index(row, 0), index(row, ColumnCount - 1));
+}
+
+QJsonObject FetchStatistics::toJson() const
+{
+    QJsonArray feeds;
+    QJsonObject sums;
+    for (const Stage &stage : stages) {
+        sums.insert(QLatin1StringView(stage.key), 0.0);
+    }
+
+    for (const Row &row : m_rows) {
+        QJsonObject feed;
+        feed.insert(QLatin1StringView("url"), row.url);
+        feed.insert(QLatin1StringView("title"), row.title);
+        feed.insert(QLatin1StringView("outcome"), outcomeName(row.last.outcome));
+        feed.insert(QLatin1StringView("finished"), row.last.finished.toString(Qt::ISODateWithMs));
+        feed.insert(QLatin1StringView("streamed"), row.last.streamed);
+        feed.insert(QLatin1StringView("bytes"), row.last.bytes);
+        feed.insert(QLatin1StringView("newArticles"), row.last.newArticles);
+        feed.insert(QLatin1StringView("fetches"), row.fetches);
+        feed.insert(QLatin1StringView("averageTotal"), value(row, AverageTotalColumn).toDouble());
+        for (const Stage &stage : stages) {
+            const QLatin1StringView key(stage.key);
+            const double msecs = toMsecs(row.last.*stage.member);
+            feed.insert(key, msecs);
+            sums.insert(key, sums.value(key).toDouble() + msecs);
+        }
+        feeds.append(feed);
+    }
+
+    QJsonObject commit;
+    commit.insert(QLatin1StringView("feeds"), m_lastCommit.feeds);
+    commit.insert(QLatin1StringView("bytesWritten"), m_lastCommit.bytesWritten);
+    commit.insert(QLatin1StringView("duration"), toMsecs(std::chrono::duration_cast<std::chrono::microseconds>(m_lastCommit.duration)));
+    commit.insert(QLatin1StringView("ok"), m_lastCommit.ok);
+
+    QJsonObject result;
+    result.insert(QLatin1StringView("feeds"), feeds);
+    result.insert(QLatin1StringView("stages"), sums);
+    result.insert(QLatin1StringView("lastCommit"), commit);
+    return result;
+}
+
+#include "moc_fetchstatistics.cpp"
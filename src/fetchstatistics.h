@@ -0,0 +1,106 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#pragma once
+
+#include "akregatorpart_export.h"
+#include "fetchtimings.h"
+#include "storage/storage.h"
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QSet>
+#include <QSharedPointer>
+
+namespace Akregator
+{
+class Feed;
+class FeedList;
+class TreeNode;
+
+/**
+ * Collects the timings of the fetches of all feeds, one row per feed.
+ *
+ * Each row shows the stages of the last fetch of the feed, see FetchTimings, and
+ * the average total over all fetches of this session. Archive writes are shared
+ * by all feeds merged since the previous commit, each of them is charged the
+ * duration of the commit which wrote its articles.
+ */
+class AKREGATORPART_EXPORT FetchStatistics : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum Column {
+        FeedColumn = 0,
+        OutcomeColumn,
+        QueueWaitColumn,
+        ResponseColumn,
+        TransferColumn,
+        ParseColumn,
+        LoadArticlesColumn,
+        MergeColumn,
+        StorageColumn,
+        TotalColumn,
+        AverageTotalColumn,
+        BytesColumn,
+        NewArticlesColumn,
+        FetchesColumn,
+        ColumnCount
+    };
+
+    enum Role {
+        /** numeric value of a cell, for sorting */
+        SortRole = Qt::UserRole,
+    };
+
+    explicit FetchStatistics(Backend::Storage *storage, QObject *parent = nullptr);
+    ~FetchStatistics() override;
+
+    void setFeedList(const QSharedPointer<FeedList> &list);
+
+    /** forgets all collected timings */
+    void clear();
+
+    [[nodiscard]] int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    [[nodiscard]] int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    [[nodiscard]] QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    [[nodiscard]] QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    /** records a finished fetch of @p feed, which took @p timings. Called for every fetch of the feed list. */
+    void addFetch(const Akregator::Feed *feed, const Akregator::FetchTimings &timings);
+
+    /** returns all collected timings: per feed, summed up per stage, and the last archive commit. Durations are in milliseconds. */
+    [[nodiscard]] QJsonObject toJson() const;
+
+private Q_SLOTS:
+    void slotFetchDone(Akregator::Feed *feed);
+    void slotCommitFinished(const Akregator::Backend::Storage::CommitStats &stats);
+    void slotNodeRemoved(Akregator::TreeNode *node);
+
+private:
+    struct Row {
+        const Feed *feed = nullptr;
+        QString title;
+        QString url;
+        FetchTimings last;
+        int fetches = 0;
+        std::chrono::microseconds sumTotal{0};
+    };
+
+    [[nodiscard]] static QString outcomeName(FetchTimings::Outcome outcome);
+    [[nodiscard]] QVariant value(const Row &row, int column) const;
+    void rowChanged(qsizetype row);
+
+    QSharedPointer<FeedList> m_feedList;
+    QList<Row> m_rows;
+    QHash<const Feed *, qsizetype> m_rowIndex;
+    /** feeds whose merged articles were not committed yet */
+    QSet<const Feed *> m_awaitingCommit;
+    Backend::Storage::CommitStats m_lastCommit;
+};
+}
@@ -0,0 +1,79 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#include "fetchstatisticsdialog.h"
+#include "fetchstatistics.h"
+
+#include <KLocalizedString>
+#include <KMessageBox>
+#include <QDialogButtonBox>
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QJsonDocument>
+#include <QPushButton>
+#include <QSaveFile>
+#include <QSortFilterProxyModel>
+#include <QTreeView>
+#include <QVBoxLayout>
+
+using namespace Akregator;
+
+FetchStatisticsDialog::FetchStatisticsDialog(FetchStatistics *statistics, QWidget *parent)
+    : QDialog(parent)
+    , mStatistics(statistics)
+{
+    setWindowTitle(i18nc("@title:window", "Fetch Statistics"));
+    auto mainLayout = new QVBoxLayout(this);
+
+    auto proxy = new QSortFilterProxyModel(this);
+    proxy->setSourceModel(statistics);
+    proxy->setSortRole(FetchStatistics::SortRole);
+    proxy->setSortCaseSensitivity(Qt::CaseInsensitive);
+
+    auto view = new QTreeView(this);
+    view->setRootIsDecorated(false);
+    view->setUniformRowHeights(true);
+    view->setAlternatingRowColors(true);
+    view->setSortingEnabled(true);
+    view->setModel(proxy);
+    view->sortByColumn(FetchStatistics::TotalColumn, Qt::DescendingOrder);
+    view->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    view->header()->setSectionResizeMode(FetchStatistics::FeedColumn, QHeaderView::Stretch);
+    mainLayout->addWidget(view);
+
+    auto buttonBox = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    auto saveButton = buttonBox->addButton(i18nc("@action:button", "Save as JSON…"), QDialogButtonBox::ActionRole);
+    saveButton->setIcon(QIcon::fromTheme(QStringLiteral("document-save-as")));
+    connect(saveButton, &QPushButton::clicked, this, &FetchStatisticsDialog::saveAsJson);
+    auto resetButton = buttonBox->addButton(i18nc("@action:button", "Reset"), QDialogButtonBox::ResetRole);
+    connect(resetButton, &QPushButton::clicked, statistics, &FetchStatistics::clear);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &FetchStatisticsDialog::reject);
+    mainLayout->addWidget(buttonBox);
+}
+
+FetchStatisticsDialog::~FetchStatisticsDialog() = default;
+
+QSize FetchStatisticsDialog::sizeHint() const
+{
+    return QDialog::sizeHint().expandedTo(QSize(900, 500));
+}
+
+void FetchStatisticsDialog::saveAsJson()
+{
+    const QString fileName = QFileDialog::getSaveFileName(this,
+                                                          i18nc("@title:window", "Save Fetch Statistics"),
+                                                          QStringLiteral("akregator-fetch-statistics.json"),
+                                                          i18n("JSON Files (*.json)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(mStatistics->toJson()).toJson()) < 0 || !file.commit()) {
+        KMessageBox::error(this, i18n("Could not write the fetch statistics to %1.", fileName));
+    }
+}
+
+#include "moc_fetchstatisticsdialog.cpp"
@@ -0,0 +1,30 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#pragma once
+
+#include <QDialog>
+
+namespace Akregator
+{
+class FetchStatistics;
+
+/** shows the fetch timings collected by FetchStatistics, and saves them as JSON */
+class FetchStatisticsDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit FetchStatisticsDialog(FetchStatistics *statistics, QWidget *parent = nullptr);
+    ~FetchStatisticsDialog() override;
+
+    [[nodiscard]] QSize sizeHint() const override;
+
+private:
+    void saveAsJson();
+
+    FetchStatistics *const mStatistics;
+};
+} // namespace Akregator
@@ -109,28 +109,35 @@ QList<TreeNode *> Folder::children()
 
 QList<const Akregator::Feed *> Folder::feeds() const
 {
-    QHash<int, const Akregator::Feed *> feedsById;
-    for (const TreeNode *i : std::as_const(m_children)) {
-        const auto f = i->feeds();
-        for (const Akregator::Feed *j : f) {
-            feedsById.insert(j->id(), j);
-        }
+    if (!m_feedsValid) {
+        // the non-const overload fills both caches
+        const_cast<Folder *>(this)->feeds();
     }
-
-    return hashValuesToVector<const Akregator::Feed *>(feedsById);
+    return m_constFeeds;
 }
 
 QList<Akregator::Feed *> Folder::feeds()
 {
-    QHash<int, Akregator::Feed *> feedsById;
-    for (TreeNode *i : std::as_const(m_children)) {
-        const auto f = i->feeds();
-        for (Akregator::Feed *j : f) {
-            feedsById.insert(j->id(), j);
+    if (!m_feedsValid) {
+        m_feeds.clear();
+        for (TreeNode *i : std::as_const(m_children)) {
+            m_feeds += i->feeds();
+        }
+        m_constFeeds.clear();
+        m_constFeeds.reserve(m_feeds.size());
+        for (const Akregator::Feed *i : std::as_const(m_feeds)) {
+            m_constFeeds.append(i);
         }
+        m_feedsValid = true;
     }
+    return m_feeds;
+}
 
-    return hashValuesToVector<Akregator::Feed *>(feedsById);
+void Folder::invalidateFeeds()
+{
+    for (Folder *i = this; i && i->m_feedsValid; i = i->parent()) {
+        i->m_feedsValid = false;
+    }
 }
 
 QList<const Folder *> Folder::folders() const
@@ -192,7 +199,8 @@ void Folder::insertChild(int index, TreeNode *node)
         }
         node->setParent(this);
         connectToNode(node);
-        updateUnreadCount();
+        invalidateFeeds();
+        addToCounts(node->unread(), node->totalCount());
         Q_EMIT signalChildAdded(node);
         articlesModified();
         nodeModified();
@@ -207,7 +215,8 @@ void Folder::appendChild(TreeNode *node)
         m_children.append(node);
         node->setParent(this);
         connectToNode(node);
-        updateUnreadCount();
+        invalidateFeeds();
+        addToCounts(node->unread(), node->totalCount());
         Q_EMIT signalChildAdded(node);
         articlesModified();
         nodeModified();
@@ -222,7 +231,8 @@ void Folder::prependChild(TreeNode *node)
         m_children.prepend(node);
         node->setParent(this);
         connectToNode(node);
-        updateUnreadCount();
+        invalidateFeeds();
+        addToCounts(node->unread(), node->totalCount());
         Q_EMIT signalChildAdded(node);
         articlesModified();
         nodeModified();
@@ -240,7 +250,8 @@ void Folder::removeChild(TreeNode *node)
     node->setParent(nullptr);
     m_children.removeOne(node);
     disconnectFromNode(node);
-    updateUnreadCount();
+    invalidateFeeds();
+    addToCounts(-node->unread(), -node->totalCount());
     Q_EMIT signalChildRemoved(this, node);
     articlesModified(); // articles were removed, TODO: add guids to a list
     nodeModified();
@@ -283,22 +294,30 @@ int Folder::unread() const
 
 int Folder::totalCount() const
 {
-    int total = 0;
-    const auto f = feeds();
-    for (const Feed *const i : f) {
-        total += i->totalCount();
+    return m_totalCount;
+}
+
+void Folder::addToCounts(int unreadDelta, int totalDelta)
+{
+    if (unreadDelta == 0 && totalDelta == 0) {
+        return;
+    }
+    m_unread += unreadDelta;
+    m_totalCount += totalDelta;
+    if (Folder *const p = parent()) {
+        p->addToCounts(unreadDelta, totalDelta);
     }
-    return total;
 }
 
-void Folder::updateUnreadCount() const
+void Folder::recalcCounts()
 {
     int unread = 0;
-    const auto f = feeds();
-    for (const Feed *const i : f) {
+    int total = 0;
+    for (const TreeNode *i : std::as_const(m_children)) {
         unread += i->unread();
+        total += i->totalCount();
     }
-    m_unread = unread;
+    addToCounts(unread - m_unread, total - m_totalCount);
 }
 
 KJob *Folder::createMarkAsReadJob()
@@ -313,14 +332,15 @@ KJob *Folder::createMarkAsReadJob()
 
 void Folder::slotChildChanged(TreeNode * /*node*/)
 {
-    updateUnreadCount();
+    // counts were already passed up by addToCounts()
     nodeModified();
 }
 
 void Folder::slotChildDestroyed(TreeNode *node)
 {
     m_children.removeAll(node);
-    updateUnreadCount();
+    invalidateFeeds();
+    recalcCounts();
     nodeModified();
 }
 
@@ -340,20 +360,22 @@ bool Folder::subtreeContains(const TreeNode *node) const
     return false;
 }
 
-void Folder::slotAddToFetchQueue(FetchQueue *queue, bool intervalFetchOnly)
+void Folder::slotAddToFetchQueue(FetchQueue *queue, bool intervalFetchOnly, FetchPriority priority)
 {
     const auto f = feeds();
+    QList<Feed *> due;
+    due.reserve(f.size());
     for (Feed *const i : f) {
-        if (i->useCustomFetchInterval()) {
-            if (i->fetchInterval() != -1) {
-                i->slotAddToFetchQueue(queue, intervalFetchOnly);
-            } else {
-                // qCDebug(AKREGATOR_LOG) << " excluded feeds: " << i->description();
-            }
-        } else {
-            i->slotAddToFetchQueue(queue, intervalFetchOnly);
+        if (i->useCustomFetchInterval() && i->fetchInterval() == -1) {
+            // qCDebug(AKREGATOR_LOG) << " excluded feeds: " << i->description();
+            continue;
+        }
+        if (i->wantsFetch(intervalFetchOnly)) {
+            due.append(i);
         }
     }
+    // one batch: the queue starts once instead of once per feed
+    queue->addFeeds(due, priority);
 }
 
 void Folder::doArticleNotification()
@@ -20,6 +20,7 @@ class QList;
 namespace Akregator
 {
 class Article;
+class FeedPrivate;
 class FetchQueue;
 class TreeNodeVisitor;
 
@@ -27,6 +28,7 @@ class TreeNodeVisitor;
  */
 class AKREGATOR_EXPORT Folder : public TreeNode
 {
+    friend class ::Akregator::FeedPrivate;
     Q_OBJECT
 public:
     /** creates a feed group parsed from a XML dom element.
@@ -166,7 +168,7 @@ public Q_SLOTS:
     @param queue a fetch queue
     @param intervalFetchesOnly determines whether to allow only interval fetches
     */
-    void slotAddToFetchQueue(Akregator::FetchQueue *queue, bool intervalFetchesOnly = false) override;
+    void slotAddToFetchQueue(Akregator::FetchQueue *queue, bool intervalFetchesOnly = false, Akregator::FetchPriority priority = BackgroundFetch) override;
 
 protected:
     /** inserts @c node as child on position @c index
@@ -182,11 +184,23 @@ private:
     void connectToNode(TreeNode *child);
     void disconnectFromNode(TreeNode *child);
 
-    void updateUnreadCount() const;
+    /** adjusts the cached counts by the change of a descendant and passes it on to the parent, O(depth) */
+    void addToCounts(int unreadDelta, int totalDelta);
+    /** resums the counts of the direct children, for changes without a known delta */
+    void recalcCounts();
+    /** drops the cached descendant feeds of this folder and its ancestors */
+    void invalidateFeeds();
+
     /** List of children */
     QList<TreeNode *> m_children;
     /** caching unread count of children */
-    mutable int m_unread = 0;
+    int m_unread = 0;
+    /** caching article count of children */
+    int m_totalCount = 0;
+    /** cached flat list of descendant feeds in tree order, rebuilt on demand after invalidateFeeds() */
+    mutable QList<Feed *> m_feeds;
+    mutable QList<const Feed *> m_constFeeds;
+    mutable bool m_feedsValid = false;
     /** whether or not the folder is expanded */
     bool m_open = false;
 };
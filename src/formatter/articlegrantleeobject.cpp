@@ -94,11 +94,16 @@ QString ArticleGrantleeObject::imageFeed() const
 }
 
 QString ArticleGrantleeObject::actionToken() const
+{
+    return actionToken(mArticle);
+}
+
+QString ArticleGrantleeObject::actionToken(const Article &article)
 {
     QUrlQuery query;
-    query.addQueryItem(QStringLiteral("id"), mArticle.guid());
-    if (mArticle.feed()) {
-        query.addQueryItem(QStringLiteral("feed"), mArticle.feed()->xmlUrl());
+    query.addQueryItem(QStringLiteral("id"), article.guid());
+    if (article.feed()) {
+        query.addQueryItem(QStringLiteral("feed"), article.feed()->xmlUrl());
     }
     return u'?' + query.toString(QUrl::FullyEncoded);
 }
@@ -50,6 +50,8 @@ public:
 
     [[nodiscard]] bool important() const;
     [[nodiscard]] QString actionToken() const;
+    /** identifies @p article in article actions and in the elements of the combined view */
+    [[nodiscard]] static QString actionToken(const Article &article);
 
 private:
     const Article mArticle;
@@ -26,6 +26,11 @@ QString DefaultCombinedViewFormatter::formatArticles(const QList<Article> &artic
     return mGrantleeViewFormatter->formatArticles(articles, icon);
 }
 
+QString DefaultCombinedViewFormatter::formatArticleFragments(const QList<Article> &articles, IconOption icon) const
+{
+    return mGrantleeViewFormatter->formatArticleFragments(articles, icon);
+}
+
 QString DefaultCombinedViewFormatter::formatSummary(TreeNode *) const
 {
     return {};
@@ -19,6 +19,8 @@ public:
     ~DefaultCombinedViewFormatter() override;
 
     [[nodiscard]] QString formatArticles(const QList<Article> &articles, IconOption option) const override;
+    /** renders the elements of @p articles for appending them to the page, or replacing single ones */
+    [[nodiscard]] QString formatArticleFragments(const QList<Article> &articles, IconOption option) const;
 
     [[nodiscard]] QString formatSummary(TreeNode *node) const override;
 
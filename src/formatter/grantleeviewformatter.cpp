@@ -232,32 +232,55 @@ QString GrantleeViewFormatter::formatFolder(Akregator::Folder *node)
 
 QString GrantleeViewFormatter::formatArticles(const QList<Article> &article, ArticleFormatter::IconOption icon)
 {
-    mTemplate = mEngine.loadByName(QStringLiteral("formatter/html/normalview.html"));
-    if (mTemplate->error()) {
-        return mTemplate->errorString();
-    }
+    return renderArticles(mHtmlArticleFileName, article, icon, true);
+}
 
-    QVariantHash articleObject;
+QString GrantleeViewFormatter::formatArticleFragments(const QList<Article> &articles, ArticleFormatter::IconOption icon)
+{
+    return renderArticles(QStringLiteral("formatter/html/combinedviewarticles.html"), articles, icon, false);
+}
 
+void GrantleeViewFormatter::addArticleObject(QVariantHash &grantleeObject,
+                                             const QList<Article> &articles,
+                                             ArticleFormatter::IconOption icon,
+                                             QList<QObject *> &objects) const
+{
     QVariantList articlesList;
-    const int nbArticles(article.count());
+    const int nbArticles(articles.count());
     articlesList.reserve(nbArticles);
-    QList<ArticleGrantleeObject *> lstObj;
-    lstObj.reserve(nbArticles);
+    objects.reserve(nbArticles);
     for (int i = 0; i < nbArticles; ++i) {
-        auto articleObj = new ArticleGrantleeObject(article.at(i), icon);
+        auto articleObj = new ArticleGrantleeObject(articles.at(i), icon);
         articlesList << QVariant::fromValue(static_cast<QObject *>(articleObj));
-        lstObj.append(articleObj);
+        objects.append(articleObj);
+    }
+    grantleeObject.insert(QStringLiteral("articles"), articlesList);
+
+    grantleeObject.insert(QStringLiteral("applicationDir"), mDirectionString);
+    grantleeObject.insert(QStringLiteral("dateI18n"), i18n("Date"));
+    grantleeObject.insert(QStringLiteral("commentI18n"), i18n("Comment"));
+    grantleeObject.insert(QStringLiteral("completeStoryI18n"), i18n("Complete Story"));
+    grantleeObject.insert(QStringLiteral("authorI18n"), i18n("Author"));
+    grantleeObject.insert(QStringLiteral("enclosureI18n"), i18n("Enclosure"));
+}
+
+QString GrantleeViewFormatter::renderArticles(const QString &templateName,
+                                              const QList<Article> &articles,
+                                              ArticleFormatter::IconOption icon,
+                                              bool standardObject)
+{
+    mTemplate = mEngine.loadByName(templateName);
+    if (mTemplate->error()) {
+        return mTemplate->errorString();
+    }
+
+    QVariantHash articleObject;
+    QList<QObject *> lstObj;
+    addArticleObject(articleObject, articles, icon, lstObj);
+    if (standardObject) {
+        addStandardObject(articleObject);
+        articleObject.insert(QStringLiteral("loadExternalReference"), Settings::loadExternalReferences());
     }
-    articleObject.insert(QStringLiteral("articles"), articlesList);
-
-    addStandardObject(articleObject);
-    articleObject.insert(QStringLiteral("loadExternalReference"), Settings::loadExternalReferences());
-    articleObject.insert(QStringLiteral("dateI18n"), i18n("Date"));
-    articleObject.insert(QStringLiteral("commentI18n"), i18n("Comment"));
-    articleObject.insert(QStringLiteral("completeStoryI18n"), i18n("Complete Story"));
-    articleObject.insert(QStringLiteral("authorI18n"), i18n("Author"));
-    articleObject.insert(QStringLiteral("enclosureI18n"), i18n("Enclosure"));
 
     KTextTemplate::Context context(articleObject);
     context.setLocalizer(mEngine.localizer());
@@ -24,12 +24,16 @@ public:
     ~GrantleeViewFormatter();
 
     [[nodiscard]] QString formatArticles(const QList<Article> &article, ArticleFormatter::IconOption icon);
+    /** renders only the elements of @p articles, for adding them to a page rendered by formatArticles() */
+    [[nodiscard]] QString formatArticleFragments(const QList<Article> &articles, ArticleFormatter::IconOption icon);
     [[nodiscard]] QString formatFolder(Akregator::Folder *node);
     [[nodiscard]] QString formatFeed(Akregator::Feed *feed);
 
 private:
     Colors getAppColor() const;
     void addStandardObject(QVariantHash &grantleeObject) const;
+    void addArticleObject(QVariantHash &grantleeObject, const QList<Article> &articles, ArticleFormatter::IconOption icon, QList<QObject *> &objects) const;
+    [[nodiscard]] QString renderArticles(const QString &templateName, const QList<Article> &articles, ArticleFormatter::IconOption icon, bool standardObject);
     [[nodiscard]] QString sidebarCss(const Colors &colors) const;
     [[nodiscard]] int pointsToPixel(int pointSize) const;
     const QString mHtmlArticleFileName;
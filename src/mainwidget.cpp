@@ -29,6 +29,9 @@
 
 #include "feedlist.h"
 #include "fetchqueue.h"
+#include "fetchscheduler.h"
+#include "fetchstatistics.h"
+#include "fetchstatisticsdialog.h"
 #include "folder.h"
 #include "framemanager.h"
 #include "job/downloadarticlejob.h"
@@ -283,9 +286,8 @@ MainWidget::MainWidget(Part *part, QWidget *parent, ActionManagerImpl *actionMan
         m_displayingAboutPage = true;
     }
 
-    m_fetchTimer = new QTimer(this);
-    connect(m_fetchTimer, &QTimer::timeout, this, &MainWidget::slotDoIntervalFetches);
-    m_fetchTimer->start(1min);
+    m_fetchScheduler = new FetchScheduler(Kernel::self()->fetchQueue(), this);
+    m_fetchStatistics = new FetchStatistics(Kernel::self()->storage(), this);
 
     // delete expired articles once per hour
     m_expiryTimer = new QTimer(this);
@@ -326,6 +328,7 @@ void MainWidget::slotSettingsChanged()
 {
     m_tabWidget->slotSettingsChanged();
     m_articleViewer->updateAfterConfigChanged();
+    m_fetchScheduler->rescheduleAll();
 }
 
 void MainWidget::slotSetFocusToViewer()
@@ -483,6 +486,8 @@ void MainWidget::setFeedList(const QSharedPointer<FeedList> &list)
     Kernel::self()->setFeedList(m_feedList);
     ProgressManager::self()->setFeedList(m_feedList);
     m_selectionController->setFeedList(m_feedList);
+    m_fetchScheduler->setFeedList(m_feedList);
+    m_fetchStatistics->setFeedList(m_feedList);
 
     slotDeleteExpiredArticles();
 }
@@ -865,29 +870,18 @@ void MainWidget::slotSetTotalUnread()
     Q_EMIT signalUnreadCountChanged(m_feedList ? m_feedList->unread() : 0);
 }
 
-void MainWidget::slotDoIntervalFetches()
-{
-    if (!m_feedList) {
-        return;
-    }
-#if 0
-    // the following solid check apparently doesn't work reliably and causes
-    // interval fetching not working although the user is actually online (but solid reports he's not
-    const Networking::Status status = Solid::Networking::status();
-    if (status != Networking::Connected && status != Networking::Unknown) {
-        return;
-    }
-#endif
-    m_feedList->addToFetchQueue(Kernel::self()->fetchQueue(), true);
-}
-
 void MainWidget::slotFetchCurrentFeed()
 {
     if (!m_selectionController->selectedSubscription()) {
         return;
     }
     if (isNetworkAvailable()) {
-        m_selectionController->selectedSubscription()->slotAddToFetchQueue(Kernel::self()->fetchQueue());
+        // an explicit request also fetches a parked feed
+        if (auto feed = qobject_cast<Feed *>(m_selectionController->selectedSubscription())) {
+            Kernel::self()->fetchQueue()->addFeed(feed, InteractiveFetch);
+        } else {
+            m_selectionController->selectedSubscription()->slotAddToFetchQueue(Kernel::self()->fetchQueue(), false, InteractiveFetch);
+        }
     } else {
         m_mainFrame->slotSetStatusText(i18n("Networking is not available."));
     }
@@ -896,7 +890,7 @@ void MainWidget::slotFetchCurrentFeed()
 void MainWidget::slotFetchAllFeeds()
 {
     if (m_feedList && isNetworkAvailable()) {
-        m_feedList->addToFetchQueue(Kernel::self()->fetchQueue());
+        m_feedList->addToFetchQueue(Kernel::self()->fetchQueue(), false, StartupFetch);
     } else if (m_feedList) {
         m_mainFrame->slotSetStatusText(i18n("Networking is not available."));
     }
@@ -1324,6 +1318,17 @@ void MainWidget::slotFocusQuickSearch()
     m_searchBar->setFocusSearchLine();
 }
 
+FetchStatistics *MainWidget::fetchStatistics() const
+{
+    return m_fetchStatistics;
+}
+
+void MainWidget::slotShowFetchStatistics()
+{
+    FetchStatisticsDialog dlg(m_fetchStatistics, this);
+    dlg.exec();
+}
+
 void MainWidget::slotWhatsNew()
 {
     TextAddonsWidgets::WhatsNewNgDialog dlg(i18n("Akregator"), this);
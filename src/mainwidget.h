@@ -38,6 +38,8 @@ class ArticleViewerWidget;
 class Folder;
 class FeedList;
 class FeedListManagementImpl;
+class FetchScheduler;
+class FetchStatistics;
 class Frame;
 class Part;
 class SearchBar;
@@ -99,6 +101,9 @@ public:
     // Returns true if networking is available
     [[nodiscard]] bool isNetworkAvailable() const;
 
+    /** timings of the fetches of this session */
+    [[nodiscard]] FetchStatistics *fetchStatistics() const;
+
     enum ViewMode {
         NormalView = 0,
         WidescreenView,
@@ -211,6 +216,9 @@ public Q_SLOTS:
 
     void slotWhatsNew();
 
+    /** shows where the time of the fetches went */
+    void slotShowFetchStatistics();
+
 protected:
     void sendArticle(bool attach = false);
 
@@ -224,7 +232,6 @@ protected Q_SLOTS:
     /** opens the link of an article in the external browser */
     void slotOpenArticleInBrowser(const Akregator::Article &article);
 
-    void slotDoIntervalFetches();
     void slotDeleteExpiredArticles();
 
     void slotFetchingStarted();
@@ -270,7 +277,8 @@ private:
     Akregator::Part *m_part = nullptr;
     ViewMode m_viewMode = NormalView;
 
-    QTimer *m_fetchTimer = nullptr;
+    FetchScheduler *m_fetchScheduler = nullptr;
+    FetchStatistics *m_fetchStatistics = nullptr;
     QTimer *m_expiryTimer = nullptr;
     QTimer *m_markReadTimer = nullptr;
 
@@ -0,0 +1,300 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "searchindextest.h"
+#include "storage/searchindex.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+using Akregator::Backend::SearchIndex;
+
+QTEST_MAIN(SearchIndexTest)
+
+namespace
+{
+const QString feedA = QStringLiteral("https://a.example/feed");
+const QString feedB = QStringLiteral("https://b.example/feed");
+
+/** guid and text of the articles of feedA used by the lookup tests */
+const QList<std::pair<QString, QString>> articles = {
+    {QStringLiteral("g1"), QStringLiteral("The quick brown fox")},
+    {QStringLiteral("g2"), QStringLiteral("Jumps over the lazy dog")},
+    {QStringLiteral("g3"), QStringLiteral("Crème brûlée recipe")},
+    {QStringLiteral("g4"), QStringLiteral("abcxbcd")},
+};
+
+void addArticles(SearchIndex &index)
+{
+    for (const auto &[guid, text] : articles) {
+        index.addArticle(feedA, guid, text);
+    }
+    index.setIndexed(feedA);
+}
+
+[[nodiscard]] QSet<QString> search(SearchIndex &index, const QString &text, const QString &feed = feedA)
+{
+    const std::optional<SearchIndex::Matches> matches = index.search(text);
+    return matches ? matches->value(feed) : QSet<QString>();
+}
+
+/** writes an index with "alpha" in feedA and "alpha gamma" in feedB */
+void saveIndex(const QString &filePath)
+{
+    SearchIndex index;
+    index.setFile(filePath);
+    index.addArticle(feedA, QStringLiteral("g1"), QStringLiteral("alpha"));
+    index.addArticle(feedA, QStringLiteral("g2"), QStringLiteral("beta"));
+    index.addArticle(feedB, QStringLiteral("g3"), QStringLiteral("alpha gamma"));
+    index.setIndexed(feedA);
+    index.setIndexed(feedB);
+    index.removeArticle(feedA, QStringLiteral("g2"));
+    QVERIFY(index.save());
+}
+}
+
+SearchIndexTest::SearchIndexTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void SearchIndexTest::shouldFoldText_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("folded");
+    QTest::newRow("plain") << QStringLiteral("123 abc") << QStringLiteral("123 abc");
+    QTest::newRow("case") << QStringLiteral("ABC Def") << QStringLiteral("abc def");
+    QTest::newRow("diacritics") << QStringLiteral("Crème Brûlée") << QStringLiteral("creme brulee");
+    QTest::newRow("uppercase diacritics") << QStringLiteral("ÀÉÎÕÜ") << QStringLiteral("aeiou");
+    QTest::newRow("ligature") << QStringLiteral("ﬁne") << QStringLiteral("fine");
+    QTest::newRow("sharp s") << QStringLiteral("Straße") << QStringLiteral("straße");
+}
+
+void SearchIndexTest::shouldFoldText()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, folded);
+    QCOMPARE(SearchIndex::fold(text), folded);
+}
+
+void SearchIndexTest::shouldSplitWords_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QStringList>("words");
+    QTest::newRow("empty") << QString() << QStringList();
+    QTest::newRow("separators only") << QStringLiteral(" ,.! ") << QStringList();
+    QTest::newRow("distinct") << QStringLiteral("Hello, wörld! hello") << QStringList{QStringLiteral("hello"), QStringLiteral("world")};
+    QTest::newRow("punctuation") << QStringLiteral("e-mail foo_bar 3.14")
+                                 << QStringList{QStringLiteral("e"),
+                                                QStringLiteral("mail"),
+                                                QStringLiteral("foo"),
+                                                QStringLiteral("bar"),
+                                                QStringLiteral("3"),
+                                                QStringLiteral("14")};
+    QTest::newRow("diacritics") << QStringLiteral("Ünïcödé") << QStringList{QStringLiteral("unicode")};
+}
+
+void SearchIndexTest::shouldSplitWords()
+{
+    QFETCH(QString, text);
+    QFETCH(QStringList, words);
+    QCOMPARE(SearchIndex::words(text), words);
+}
+
+void SearchIndexTest::shouldFindSubstrings_data()
+{
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<QStringList>("guids");
+    QTest::newRow("word") << QStringLiteral("quick") << QStringList{QStringLiteral("g1")};
+    QTest::newRow("within a word") << QStringLiteral("uic") << QStringList{QStringLiteral("g1")};
+    QTest::newRow("across words") << QStringLiteral("ck bro") << QStringList{QStringLiteral("g1")};
+    QTest::newRow("several articles") << QStringLiteral("the") << QStringList{QStringLiteral("g1"), QStringLiteral("g2")};
+    QTest::newRow("single character") << QStringLiteral("x") << QStringList{QStringLiteral("g1"), QStringLiteral("g4")};
+    QTest::newRow("two characters") << QStringLiteral("Og") << QStringList{QStringLiteral("g2")};
+    QTest::newRow("case") << QStringLiteral("CREME") << QStringList{QStringLiteral("g3")};
+    QTest::newRow("diacritics") << QStringLiteral("brulée") << QStringList{QStringLiteral("g3")};
+    QTest::newRow("trigrams only") << QStringLiteral("abcd") << QStringList();
+    QTest::newRow("last trigram") << QStringLiteral("bcd") << QStringList{QStringLiteral("g4")};
+    QTest::newRow("one word missing") << QStringLiteral("lazy cat") << QStringList();
+}
+
+void SearchIndexTest::shouldFindSubstrings()
+{
+    QFETCH(QString, query);
+    QFETCH(QStringList, guids);
+    SearchIndex index;
+    addArticles(index);
+    QCOMPARE(search(index, query), QSet<QString>(guids.cbegin(), guids.cend()));
+}
+
+void SearchIndexTest::shouldMatchLikeContainsForSingleWords_data()
+{
+    QTest::addColumn<QString>("query");
+    QTest::newRow("word") << QStringLiteral("Lazy");
+    QTest::newRow("within a word") << QStringLiteral("rown");
+    QTest::newRow("diacritics") << QStringLiteral("crème");
+    QTest::newRow("single character") << QStringLiteral("e");
+    QTest::newRow("two characters") << QStringLiteral("bc");
+    QTest::newRow("no match") << QStringLiteral("zebra");
+}
+
+void SearchIndexTest::shouldMatchLikeContainsForSingleWords()
+{
+    // FullTextMatcher trusts the index for such queries, instead of checking with Criterion::Contains
+    QFETCH(QString, query);
+    QCOMPARE(SearchIndex::words(query), QStringList{SearchIndex::fold(query)});
+
+    SearchIndex index;
+    addArticles(index);
+    QSet<QString> expected;
+    for (const auto &[guid, text] : articles) {
+        if (SearchIndex::fold(text).contains(SearchIndex::fold(query))) {
+            expected.insert(guid);
+        }
+    }
+    QCOMPARE(search(index, query), expected);
+}
+
+void SearchIndexTest::shouldNotSearchWithoutWords()
+{
+    SearchIndex index;
+    addArticles(index);
+    QVERIFY(!index.search(QString()).has_value());
+    QVERIFY(!index.search(QStringLiteral(" !? ")).has_value());
+}
+
+void SearchIndexTest::shouldForgetRemovedArticles()
+{
+    SearchIndex index;
+    index.addArticle(feedA, QStringLiteral("g1"), QStringLiteral("alpha beta"));
+    index.addArticle(feedA, QStringLiteral("g2"), QStringLiteral("beta gamma"));
+    index.setIndexed(feedA);
+    QVERIFY(index.isIndexed(feedA));
+
+    index.removeArticle(feedA, QStringLiteral("g1"));
+    QCOMPARE(search(index, QStringLiteral("beta")), QSet<QString>{QStringLiteral("g2")});
+
+    // replaces the text
+    index.addArticle(feedA, QStringLiteral("g2"), QStringLiteral("delta"));
+    QVERIFY(search(index, QStringLiteral("gamma")).isEmpty());
+    QCOMPARE(search(index, QStringLiteral("delta")), QSet<QString>{QStringLiteral("g2")});
+
+    index.dropFeed(feedA);
+    QVERIFY(!index.isIndexed(feedA));
+    QVERIFY(!index.search(QStringLiteral("delta"))->contains(feedA));
+}
+
+void SearchIndexTest::shouldRenumberWhenCompacting()
+{
+    constexpr int count = 5000;
+    constexpr int removed = 4500;
+    SearchIndex index;
+    for (int i = 0; i < count; ++i) {
+        index.addArticle(feedA, QStringLiteral("g%1").arg(i), QStringLiteral("word%1 common").arg(i));
+    }
+    index.setIndexed(feedA);
+
+    // removing more than half of the articles compacts the index
+    for (int i = 0; i < removed; ++i) {
+        index.removeArticle(feedA, QStringLiteral("g%1").arg(i));
+    }
+    QSet<QString> expected;
+    for (int i = removed; i < count; ++i) {
+        expected.insert(QStringLiteral("g%1").arg(i));
+    }
+    QCOMPARE(search(index, QStringLiteral("common")), expected);
+    QCOMPARE(search(index, QStringLiteral("word4999")), QSet<QString>{QStringLiteral("g4999")});
+    QVERIFY(search(index, QStringLiteral("word12")).isEmpty());
+
+    // the renumbered articles can still be replaced and removed
+    index.addArticle(feedA, QStringLiteral("g4600"), QStringLiteral("other"));
+    index.removeArticle(feedA, QStringLiteral("g4500"));
+    index.addArticle(feedA, QStringLiteral("g%1").arg(count), QStringLiteral("word%1 common").arg(count));
+    expected.remove(QStringLiteral("g4600"));
+    expected.remove(QStringLiteral("g4500"));
+    expected.insert(QStringLiteral("g%1").arg(count));
+    QCOMPARE(search(index, QStringLiteral("common")), expected);
+    QCOMPARE(search(index, QStringLiteral("other")), QSet<QString>{QStringLiteral("g4600")});
+    QCOMPARE(search(index, QStringLiteral("word5000")), QSet<QString>{QStringLiteral("g5000")});
+}
+
+void SearchIndexTest::shouldAdoptSavedIndex()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filePath = dir.filePath(QStringLiteral("searchindex.dat"));
+    saveIndex(filePath);
+    QVERIFY(QFile::exists(filePath));
+
+    SearchIndex index;
+    index.setFile(filePath);
+    QVERIFY(!index.isLoaded());
+    // moved aside until saved again
+    QVERIFY(!QFile::exists(filePath));
+
+    QVERIFY(index.isIndexed(feedA));
+    QVERIFY(index.isIndexed(feedB));
+    QVERIFY(index.isLoaded());
+    QCOMPARE(search(index, QStringLiteral("alpha")), QSet<QString>{QStringLiteral("g1")});
+    QCOMPARE(search(index, QStringLiteral("alpha"), feedB), QSet<QString>{QStringLiteral("g3")});
+    QVERIFY(search(index, QStringLiteral("beta")).isEmpty());
+    QCOMPARE(search(index, QStringLiteral("amm"), feedB), QSet<QString>{QStringLiteral("g3")});
+
+    index.addArticle(feedA, QStringLiteral("g4"), QStringLiteral("beta"));
+    QCOMPARE(search(index, QStringLiteral("beta")), QSet<QString>{QStringLiteral("g4")});
+    QVERIFY(index.save());
+    QVERIFY(QFile::exists(filePath));
+}
+
+void SearchIndexTest::shouldDropStaleFeeds()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filePath = dir.filePath(QStringLiteral("searchindex.dat"));
+    saveIndex(filePath);
+
+    {
+        // a session changing feedB without searching
+        SearchIndex index;
+        index.setFile(filePath);
+        QVERIFY(!index.articleChanged(feedB));
+        QVERIFY(index.save());
+    }
+    QVERIFY(QFile::exists(filePath));
+
+    SearchIndex index;
+    index.setFile(filePath);
+    QVERIFY(index.isIndexed(feedA));
+    QVERIFY(!index.isIndexed(feedB));
+    const std::optional<SearchIndex::Matches> matches = index.search(QStringLiteral("alpha"));
+    QVERIFY(matches.has_value());
+    QCOMPARE(matches->value(feedA), QSet<QString>{QStringLiteral("g1")});
+    QVERIFY(!matches->contains(feedB));
+}
+
+void SearchIndexTest::shouldDropIndexOfCrashedSession()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filePath = dir.filePath(QStringLiteral("searchindex.dat"));
+    saveIndex(filePath);
+
+    {
+        // exits without saving
+        SearchIndex index;
+        index.setFile(filePath);
+    }
+    QVERIFY(!QFile::exists(filePath));
+
+    SearchIndex index;
+    index.setFile(filePath);
+    QVERIFY(index.isLoaded());
+    QVERIFY(!index.isIndexed(feedA));
+    QVERIFY(search(index, QStringLiteral("alpha")).isEmpty());
+}
+
+#include "moc_searchindextest.cpp"
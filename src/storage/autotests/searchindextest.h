@@ -0,0 +1,32 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class SearchIndexTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SearchIndexTest(QObject *parent = nullptr);
+    ~SearchIndexTest() override = default;
+private Q_SLOTS:
+    void shouldFoldText_data();
+    void shouldFoldText();
+    void shouldSplitWords_data();
+    void shouldSplitWords();
+    void shouldFindSubstrings_data();
+    void shouldFindSubstrings();
+    void shouldMatchLikeContainsForSingleWords_data();
+    void shouldMatchLikeContainsForSingleWords();
+    void shouldNotSearchWithoutWords();
+    void shouldForgetRemovedArticles();
+    void shouldRenumberWhenCompacting();
+    void shouldAdoptSavedIndex();
+    void shouldDropStaleFeeds();
+    void shouldDropIndexOfCrashedSession();
+};
@@ -0,0 +1,185 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "storagetest.h"
+#include "storage/storage.h"
+
+#include <QMutexLocker>
+#include <QRecursiveMutex>
+#include <QTest>
+
+using Akregator::Backend::FeedStorage;
+using Akregator::Backend::Storage;
+using namespace std::chrono_literals;
+
+QTEST_MAIN(StorageTest)
+
+StorageTest::StorageTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+StorageTest::~StorageTest() = default;
+
+void StorageTest::init()
+{
+    mArchiveDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(mArchiveDir->isValid());
+    mCommits = 0;
+}
+
+void StorageTest::cleanup()
+{
+    mStorage.reset();
+    mArchiveDir.reset();
+}
+
+void StorageTest::openStorage(bool shared)
+{
+    mStorage = std::make_unique<Storage>();
+    mStorage->setArchivePath(mArchiveDir->path());
+    mStorage->setSharedArchive(shared);
+    QVERIFY(mStorage->open(true));
+    connect(mStorage.get(), &Storage::commitFinished, this, [this]() {
+        ++mCommits;
+    });
+}
+
+void StorageTest::shouldCoalesceChanges()
+{
+    openStorage();
+    mStorage->setCommitDelays(100ms, 10s);
+
+    for (int i = 0; i < 5; ++i) {
+        mStorage->markDirty();
+        QTest::qWait(30);
+    }
+    QCOMPARE(mCommits, 0);
+
+    // one commit once the changes stopped coming in
+    QTRY_COMPARE(mCommits, 1);
+    QTest::qWait(200);
+    QCOMPARE(mCommits, 1);
+}
+
+void StorageTest::shouldCommitOverdueChanges()
+{
+    openStorage();
+    mStorage->setCommitDelays(100ms, 300ms);
+
+    // the changes never stop long enough for the minimum delay
+    for (int i = 0; i < 20; ++i) {
+        mStorage->markDirty();
+        QTest::qWait(30);
+    }
+    QVERIFY(mCommits >= 1);
+}
+
+void StorageTest::shouldHoldCommits()
+{
+    openStorage();
+    mStorage->setCommitDelays(20ms, 10s);
+    QObject holder;
+
+    mStorage->holdCommits(&holder);
+    mStorage->markDirty();
+    QTest::qWait(200);
+    QCOMPARE(mCommits, 0);
+
+    mStorage->releaseCommits(&holder);
+    QTRY_COMPARE(mCommits, 1);
+}
+
+void StorageTest::shouldFlushOnLastRelease()
+{
+    openStorage();
+    // longer than QTRY_COMPARE waits: only the release can start the commit
+    mStorage->setCommitDelays(10s, 60s);
+    QObject first;
+    QObject second;
+
+    // nothing to write
+    mStorage->holdCommits(&first);
+    mStorage->releaseCommits(&first);
+    QTest::qWait(50);
+    QCOMPARE(mCommits, 0);
+
+    mStorage->holdCommits(&first);
+    mStorage->holdCommits(&second);
+    mStorage->markDirty();
+    mStorage->releaseCommits(&first);
+    QTest::qWait(100);
+    QCOMPARE(mCommits, 0);
+
+    // releasing twice does not end the other hold
+    mStorage->releaseCommits(&first);
+    QTest::qWait(100);
+    QCOMPARE(mCommits, 0);
+
+    mStorage->releaseCommits(&second);
+    QTRY_COMPARE(mCommits, 1);
+}
+
+void StorageTest::shouldReleaseDestroyedHolder()
+{
+    openStorage();
+    mStorage->setCommitDelays(10s, 60s);
+    auto holder = std::make_unique<QObject>();
+
+    mStorage->holdCommits(holder.get());
+    mStorage->holdCommits(holder.get());
+    mStorage->markDirty();
+    QTest::qWait(100);
+    QCOMPARE(mCommits, 0);
+
+    holder.reset();
+    QTRY_COMPARE(mCommits, 1);
+}
+
+void StorageTest::shouldCommitOverdueChangesDespiteHold()
+{
+    openStorage();
+    mStorage->setCommitDelays(20ms, 300ms);
+    QObject holder;
+
+    // the hold is never released
+    mStorage->holdCommits(&holder);
+    mStorage->markDirty();
+    QTest::qWait(100);
+    QCOMPARE(mCommits, 0);
+    QTRY_COMPARE(mCommits, 1);
+
+    // everything was written already
+    mStorage->releaseCommits(&holder);
+    QTest::qWait(100);
+    QCOMPARE(mCommits, 1);
+}
+
+void StorageTest::shouldCommitAgainAfterOverlappingFlush()
+{
+    // the commit of the shared archive file waits for its mutex, which keeps the first commit running
+    openStorage(true);
+    mStorage->setCommitDelays(10s, 60s);
+    FeedStorage *const feed = mStorage->archiveFor(QStringLiteral("https://example.org/feed"));
+    QMutexLocker lock(mStorage->sharedStorageMutex());
+    mStorage->markDirty(feed);
+    mStorage->flush();
+
+    QObject holder;
+    mStorage->holdCommits(&holder);
+    mStorage->markDirty(feed);
+    mStorage->releaseCommits(&holder);
+    QTest::qWait(100);
+    QCOMPARE(mCommits, 0);
+
+    // the flush of the release is not lost, but follows the running commit
+    lock.unlock();
+    QTRY_COMPARE(mCommits, 2);
+    QTest::qWait(100);
+    QCOMPARE(mCommits, 2);
+}
+
+#include "moc_storagetest.cpp"
@@ -0,0 +1,45 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+#include <QTemporaryDir>
+
+#include <memory>
+
+namespace Akregator
+{
+namespace Backend
+{
+class Storage;
+}
+}
+
+class StorageTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StorageTest(QObject *parent = nullptr);
+    ~StorageTest() override;
+private Q_SLOTS:
+    void init();
+    void cleanup();
+    void shouldCoalesceChanges();
+    void shouldCommitOverdueChanges();
+    void shouldHoldCommits();
+    void shouldFlushOnLastRelease();
+    void shouldReleaseDestroyedHolder();
+    void shouldCommitOverdueChangesDespiteHold();
+    void shouldCommitAgainAfterOverlappingFlush();
+
+private:
+    void openStorage(bool shared = false);
+
+    std::unique_ptr<QTemporaryDir> mArchiveDir;
+    std::unique_ptr<Akregator::Backend::Storage> mStorage;
+    int mCommits = 0;
+};
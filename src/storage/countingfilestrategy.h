@@ -0,0 +1,41 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#pragma once
+
+#include "mk4.h"
+#include "mk4io.h"
+
+#include <QtGlobal>
+
+#include <atomic>
+
+namespace Akregator
+{
+namespace Backend
+{
+/** A metakit file strategy adding the size of every write to a counter owned by Storage,
+    so the bytes written by a commit can be reported.
+ */
+class CountingFileStrategy : public c4_FileStrategy
+{
+public:
+    explicit CountingFileStrategy(std::atomic<qint64> &bytesWritten)
+        : m_bytesWritten(bytesWritten)
+    {
+    }
+
+    void DataWrite(t4_i32 pos, const void *buffer, int length) override
+    {
+        c4_FileStrategy::DataWrite(pos, buffer, length);
+        m_bytesWritten += length;
+    }
+
+private:
+    std::atomic<qint64> &m_bytesWritten;
+};
+} // namespace Backend
+} // namespace Akregator
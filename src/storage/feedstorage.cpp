@@ -7,6 +7,7 @@
 */
 
 #include "feedstorage.h"
+#include "searchindex.h"
 #include "storage.h"
 
 #include <Syndication/DocumentSource>
@@ -17,6 +18,9 @@
 
 #include <QDateTime>
 #include <QDebug>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRecursiveMutex>
 #include <QStandardPaths>
 
 namespace
@@ -34,6 +38,26 @@ static uint calcHash(const QString &str)
     }
     return hash;
 }
+
+static const char articlesLayout[] =
+    "[guid:S,title:S,hash:I,guidIsHash:I,guidIsPermaLink:I,description:S,link:S,comments:I,commentsLink:S,status:I,pubDate:I,tags[tag:S],"
+    "hasEnclosure:I,enclosureUrl:S,enclosureType:S,enclosureLength:I,categories[catTerm:S,catScheme:S,catName:S],authorName:S,content:S,authorUri:S,"
+    "authorEMail:S]";
+
+/** the metakit file used for the articles of @p url when each feed has its own archive file */
+static QString perFeedArchiveFile(const QString &url, const QString &archivePath)
+{
+    QString url2 = url;
+
+    if (url.length() > 255) {
+        url2 = url.left(200) + QString::number(::calcHash(url), 16);
+    }
+
+    // qDebug() << url2;
+    QString t = url2;
+    const QString filePath = archivePath + QLatin1Char('/') + t.replace(QLatin1Char('/'), QLatin1Char('_')).replace(QLatin1Char(':'), u'_');
+    return filePath + QLatin1StringView(".mk4");
+}
 }
 
 namespace Akregator
@@ -73,16 +97,54 @@ public:
 
     QString url;
     c4_Storage *storage = nullptr;
+    /** true if storage is the archive file shared by all feeds, owned by mainStorage */
+    bool sharedStorage = false;
+    /** guards storage against the commits running on the I/O thread of mainStorage */
+    QRecursiveMutex *mutex = nullptr;
+    /** mutex of a per-feed storage; the shared one is owned by mainStorage */
+    QRecursiveMutex ownMutex;
     Storage *mainStorage = nullptr;
     c4_View archiveView;
 
     bool autoCommit = false;
     bool modified = false;
+    /** bumped whenever rows may have moved, invalidating cached ArticleRow handles */
+    uint generation = 0;
     c4_StringProp pguid, ptitle, pdescription, pcontent, plink, pcommentsLink, ptag, pEnclosureType, pEnclosureUrl, pcatTerm, pcatScheme, pcatName, pauthorName,
         pauthorUri, pauthorEMail;
     c4_IntProp phash, pguidIsHash, pguidIsPermaLink, pcomments, pstatus, ppubDate, pHasEnclosure, pEnclosureLength;
+
+    void writeArticleData(c4_Row &row, const ArticleData &data) const;
+    /** the text of @p row known to the search index */
+    [[nodiscard]] QString searchText(const c4_RowRef &row) const;
 };
 
+QString FeedStorage::FeedStoragePrivate::searchText(const c4_RowRef &row) const
+{
+    return QString::fromUtf8(QByteArray(ptitle(row))) + QLatin1Char('\n') + QString::fromUtf8(QByteArray(pdescription(row))) + QLatin1Char('\n')
+        + QString::fromUtf8(QByteArray(pauthorName(row)));
+}
+
+void FeedStorage::FeedStoragePrivate::writeArticleData(c4_Row &row, const ArticleData &data) const
+{
+    phash(row) = data.hash;
+    ptitle(row) = !data.title.isEmpty() ? data.title.toUtf8().data() : "";
+    pdescription(row) = !data.description.isEmpty() ? data.description.toUtf8().data() : "";
+    pcontent(row) = !data.content.isEmpty() ? data.content.toUtf8().data() : "";
+    plink(row) = !data.link.isEmpty() ? data.link.toUtf8().data() : "";
+    if (data.hasAuthor) {
+        pauthorName(row) = !data.authorName.isEmpty() ? data.authorName.toUtf8().data() : "";
+        pauthorUri(row) = !data.authorUri.isEmpty() ? data.authorUri.toUtf8().data() : "";
+        pauthorEMail(row) = !data.authorEMail.isEmpty() ? data.authorEMail.toUtf8().data() : "";
+    }
+    if (data.hasEnclosure) {
+        pHasEnclosure(row) = true;
+        pEnclosureUrl(row) = !data.enclosureUrl.isEmpty() ? data.enclosureUrl.toUtf8().data() : "";
+        pEnclosureType(row) = !data.enclosureType.isEmpty() ? data.enclosureType.toUtf8().data() : "";
+        pEnclosureLength(row) = data.enclosureLength;
+    }
+}
+
 FeedStorage::FeedStorage(const QString &url, Storage *main)
     : d(new FeedStoragePrivate)
 {
@@ -90,21 +152,30 @@ FeedStorage::FeedStorage(const QString &url, Storage *main)
     d->url = url;
     d->mainStorage = main;
 
-    QString url2 = url;
-
-    if (url.length() > 255) {
-        url2 = url.left(200) + QString::number(::calcHash(url), 16);
+    const QString filePath = perFeedArchiveFile(url, main->archivePath());
+
+    if (main->sharedArchive()) {
+        // all feeds live in one file, each in its own pair of views
+        bool created = false;
+        const QByteArray partition = "feed" + QByteArray::number(main->partitionFor(url, created));
+        d->storage = main->sharedStorage();
+        d->sharedStorage = true;
+        d->mutex = main->sharedStorageMutex();
+        const QMutexLocker lock(d->mutex);
+        d->archiveView = d->storage->GetAs(QByteArray(partition + articlesLayout).constData());
+        c4_View hash = d->storage->GetAs(QByteArray(partition + "Hash[_H:I,_R:I]").constData());
+        d->archiveView = d->archiveView.Hash(hash, 1); // hash on guid
+
+        if (created && QFileInfo::exists(filePath)) {
+            migrateFrom(filePath);
+        }
+        return;
     }
 
-    // qDebug() << url2;
-    QString t = url2;
-    const QString filePath = main->archivePath() + QLatin1Char('/') + t.replace(QLatin1Char('/'), QLatin1Char('_')).replace(QLatin1Char(':'), u'_');
-    d->storage = new c4_Storage(QString(filePath + QLatin1StringView(".mk4")).toLocal8Bit().constData(), static_cast<int>(true));
+    d->mutex = &d->ownMutex;
+    d->storage = main->openArchiveFile(filePath);
 
-    d->archiveView = d->storage->GetAs(
-        "articles[guid:S,title:S,hash:I,guidIsHash:I,guidIsPermaLink:I,description:S,link:S,comments:I,commentsLink:S,status:I,pubDate:I,tags[tag:S],"
-        "hasEnclosure:I,enclosureUrl:S,enclosureType:S,enclosureLength:I,categories[catTerm:S,catScheme:S,catName:S],authorName:S,content:S,authorUri:S,"
-        "authorEMail:S]");
+    d->archiveView = d->storage->GetAs(QByteArray(QByteArrayLiteral("articles") + articlesLayout).constData());
 
     c4_View hash = d->storage->GetAs("archiveHash[_H:I,_R:I]");
     d->archiveView = d->archiveView.Hash(hash, 1); // hash on guid
@@ -112,7 +183,26 @@ FeedStorage::FeedStorage(const QString &url, Storage *main)
 
 FeedStorage::~FeedStorage()
 {
-    delete d->storage;
+    if (!d->sharedStorage) {
+        delete d->storage;
+    }
+}
+
+void FeedStorage::migrateFrom(const QString &filePath)
+{
+    const QMutexLocker lock(d->mutex);
+    // The old file is left untouched, so that switching back to per-feed files keeps working
+    c4_Storage oldStorage(filePath.toLocal8Bit().constData(), 0);
+    const c4_View oldView = oldStorage.GetAs(QByteArray(QByteArrayLiteral("articles") + articlesLayout).constData());
+    const int size = oldView.GetSize();
+    for (int i = 0; i < size; ++i) {
+        d->archiveView.Add(oldView.GetAt(i));
+    }
+    if (size > 0) {
+        ++d->generation;
+        markDirty();
+        d->mainStorage->searchIndex()->dropFeed(d->url);
+    }
 }
 
 void FeedStorage::markDirty()
@@ -120,21 +210,65 @@ void FeedStorage::markDirty()
     if (!d->modified) {
         d->modified = true;
         // Tell this to mainStorage
-        d->mainStorage->markDirty();
+        d->mainStorage->markDirty(this);
     }
 }
 
 void FeedStorage::commit()
 {
-    if (d->modified) {
+    const QMutexLocker lock(d->mutex);
+    // a shared archive file is committed once for all feeds by Storage
+    if (d->modified && !d->sharedStorage) {
         d->storage->Commit();
     }
     d->modified = false;
 }
 
+std::function<bool()> FeedStorage::takeCommit()
+{
+    if (!d->modified) {
+        return {};
+    }
+    d->modified = false;
+    if (d->sharedStorage) {
+        return {};
+    }
+    return [storage = d->storage, mutex = d->mutex]() {
+        const QMutexLocker lock(mutex);
+        return storage->Commit();
+    };
+}
+
 void FeedStorage::rollback()
 {
-    d->storage->Rollback();
+    const QMutexLocker lock(d->mutex);
+    if (!d->sharedStorage) {
+        d->storage->Rollback();
+    }
+    d->modified = false;
+    ++d->generation;
+    d->mainStorage->searchIndex()->dropFeed(d->url);
+}
+
+void FeedStorage::buildSearchIndex()
+{
+    const QMutexLocker lock(d->mutex);
+    SearchIndex *index = d->mainStorage->searchIndex();
+    const int size = d->archiveView.GetSize();
+    for (int i = 0; i < size; ++i) {
+        const c4_RowRef row = d->archiveView.GetAt(i);
+        index->addArticle(d->url, QString::fromLatin1(QByteArray(d->pguid(row))), d->searchText(row));
+    }
+    index->setIndexed(d->url);
+}
+
+void FeedStorage::updateSearchIndex(int index)
+{
+    SearchIndex *searchIndex = d->mainStorage->searchIndex();
+    if (searchIndex->articleChanged(d->url)) {
+        const c4_RowRef row = d->archiveView.GetAt(index);
+        searchIndex->addArticle(d->url, QString::fromLatin1(QByteArray(d->pguid(row))), d->searchText(row));
+    }
 }
 
 void FeedStorage::close()
@@ -174,8 +308,44 @@ void FeedStorage::setLastFetch(const QDateTime &lastFetch)
     d->mainStorage->setLastFetchFor(d->url, lastFetch);
 }
 
+QString FeedStorage::etag() const
+{
+    return d->mainStorage->etagFor(d->url);
+}
+
+QString FeedStorage::lastModified() const
+{
+    return d->mainStorage->lastModifiedFor(d->url);
+}
+
+void FeedStorage::setValidators(const QString &etag, const QString &lastModified)
+{
+    d->mainStorage->setValidatorsFor(d->url, etag, lastModified);
+}
+
+int FeedStorage::pollInterval() const
+{
+    return d->mainStorage->pollIntervalFor(d->url);
+}
+
+void FeedStorage::setPollInterval(int seconds)
+{
+    d->mainStorage->setPollIntervalFor(d->url, seconds);
+}
+
+int FeedStorage::fetchFailures() const
+{
+    return d->mainStorage->fetchFailuresFor(d->url);
+}
+
+void FeedStorage::setFetchFailures(int failures)
+{
+    d->mainStorage->setFetchFailuresFor(d->url, failures);
+}
+
 QStringList FeedStorage::articles() const
 {
+    const QMutexLocker lock(d->mutex);
     QStringList list;
     const int size = d->archiveView.GetSize();
     list.reserve(size);
@@ -185,8 +355,31 @@ QStringList FeedStorage::articles() const
     return list;
 }
 
+void FeedStorage::forEachArticleHeader(const std::function<void(const ArticleHeader &)> &func, bool withTitle) const
+{
+    const QMutexLocker lock(d->mutex);
+    ArticleHeader header;
+    header.row.generation = d->generation;
+    const int size = d->archiveView.GetSize();
+    for (int i = 0; i < size; ++i) {
+        const c4_RowRef row = d->archiveView.GetAt(i);
+        header.guid = QString::fromLatin1(QByteArray(d->pguid(row)));
+        header.hash = d->phash(row);
+        if (withTitle) {
+            header.title = QString::fromUtf8(QByteArray(d->ptitle(row)));
+        }
+        header.status = d->pstatus(row);
+        header.pubDate = QDateTime::fromSecsSinceEpoch(d->ppubDate(row));
+        header.guidIsHash = d->pguidIsHash(row);
+        header.guidIsPermaLink = d->pguidIsPermaLink(row);
+        header.row.index = i;
+        func(header);
+    }
+}
+
 void FeedStorage::addEntry(const QString &guid)
 {
+    const QMutexLocker lock(d->mutex);
     c4_Row row;
     d->pguid(row) = guid.toLatin1().constData();
     if (!contains(guid)) {
@@ -196,49 +389,107 @@ void FeedStorage::addEntry(const QString &guid)
     }
 }
 
-bool FeedStorage::contains(const QString &guid) const
+void FeedStorage::addArticle(const ArticleData &data, ArticleRow *articleRow)
+{
+    const QMutexLocker lock(d->mutex);
+    if (findArticle(data.guid, articleRow) != -1) {
+        return;
+    }
+    c4_Row row;
+    d->pguid(row) = data.guid.toLatin1().constData();
+    d->writeArticleData(row, data);
+    d->pguidIsHash(row) = data.guidIsHash;
+    d->pguidIsPermaLink(row) = data.guidIsPermaLink;
+    d->ppubDate(row) = data.pubDate.toSecsSinceEpoch();
+    d->archiveView.Add(row);
+    // new rows are always appended to the hashed view
+    const int index = d->archiveView.GetSize() - 1;
+    if (articleRow) {
+        articleRow->index = index;
+        articleRow->generation = d->generation;
+    }
+    updateSearchIndex(index);
+    markDirty();
+    setTotalCount(totalCount() + 1);
+}
+
+void FeedStorage::updateArticle(const ArticleData &data, ArticleRow *articleRow)
+{
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(data.guid, articleRow);
+    if (findidx == -1) {
+        return;
+    }
+    c4_Row row;
+    row = d->archiveView.GetAt(findidx);
+    d->writeArticleData(row, data);
+    d->archiveView.SetAt(findidx, row);
+    updateSearchIndex(findidx);
+    markDirty();
+}
+
+bool FeedStorage::contains(const QString &guid, ArticleRow *row) const
 {
-    return findArticle(guid) != -1;
+    const QMutexLocker lock(d->mutex);
+    return findArticle(guid, row) != -1;
 }
 
-int FeedStorage::findArticle(const QString &guid) const
+int FeedStorage::findArticle(const QString &guid, ArticleRow *row) const
 {
+    const QMutexLocker lock(d->mutex);
+    if (row && row->index != -1 && row->generation == d->generation) {
+        return row->index;
+    }
     c4_Row findrow;
     d->pguid(findrow) = guid.toLatin1().constData();
-    return d->archiveView.Find(findrow);
+    const int findidx = d->archiveView.Find(findrow);
+    if (row) {
+        row->index = findidx;
+        row->generation = d->generation;
+    }
+    return findidx;
 }
 
 void FeedStorage::deleteArticle(const QString &guid)
 {
+    const QMutexLocker lock(d->mutex);
     const int findidx = findArticle(guid);
     if (findidx != -1) {
         setTotalCount(totalCount() - 1);
         d->archiveView.RemoveAt(findidx);
+        ++d->generation;
+        if (d->mainStorage->searchIndex()->articleChanged(d->url)) {
+            d->mainStorage->searchIndex()->removeArticle(d->url, guid);
+        }
         markDirty();
     }
 }
 
-bool FeedStorage::guidIsHash(const QString &guid) const
+bool FeedStorage::guidIsHash(const QString &guid, ArticleRow *row) const
 {
-    const int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(guid, row);
     return findidx != -1 ? d->pguidIsHash(d->archiveView.GetAt(findidx)) : false;
 }
 
-bool FeedStorage::guidIsPermaLink(const QString &guid) const
+bool FeedStorage::guidIsPermaLink(const QString &guid, ArticleRow *row) const
 {
-    const int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(guid, row);
     return findidx != -1 ? d->pguidIsPermaLink(d->archiveView.GetAt(findidx)) : false;
 }
 
-uint FeedStorage::hash(const QString &guid) const
+uint FeedStorage::hash(const QString &guid, ArticleRow *row) const
 {
-    const int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(guid, row);
     return findidx != -1 ? d->phash(d->archiveView.GetAt(findidx)) : 0;
 }
 
-void FeedStorage::setDeleted(const QString &guid)
+void FeedStorage::setDeleted(const QString &guid, ArticleRow *articleRow)
 {
-    const int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(guid, articleRow);
     if (findidx == -1) {
         return;
     }
@@ -254,30 +505,37 @@ void FeedStorage::setDeleted(const QString &guid)
     d->pauthorEMail(row) = "";
     d->pcommentsLink(row) = "";
     d->archiveView.SetAt(findidx, row);
+    if (d->mainStorage->searchIndex()->articleChanged(d->url)) {
+        d->mainStorage->searchIndex()->removeArticle(d->url, guid);
+    }
     markDirty();
 }
 
-QString FeedStorage::link(const QString &guid) const
+QString FeedStorage::link(const QString &guid, ArticleRow *row) const
 {
-    int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    int findidx = findArticle(guid, row);
     return findidx != -1 ? QString::fromUtf8(QByteArray(d->plink(d->archiveView.GetAt(findidx)))) : QLatin1StringView("");
 }
 
-QDateTime FeedStorage::pubDate(const QString &guid) const
+QDateTime FeedStorage::pubDate(const QString &guid, ArticleRow *row) const
 {
-    const int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(guid, row);
     return findidx != -1 ? QDateTime::fromSecsSinceEpoch(d->ppubDate(d->archiveView.GetAt(findidx))) : QDateTime();
 }
 
-int FeedStorage::status(const QString &guid) const
+int FeedStorage::status(const QString &guid, ArticleRow *row) const
 {
-    const int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(guid, row);
     return findidx != -1 ? d->pstatus(d->archiveView.GetAt(findidx)) : 0;
 }
 
-void FeedStorage::setStatus(const QString &guid, int status)
+void FeedStorage::setStatus(const QString &guid, int status, ArticleRow *articleRow)
 {
-    const int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(guid, articleRow);
     if (findidx == -1) {
         return;
     }
@@ -288,9 +546,10 @@ void FeedStorage::setStatus(const QString &guid, int status)
     markDirty();
 }
 
-void FeedStorage::article(const QString &guid, uint &hash, QString &title, int &status, QDateTime &pubDate) const
+void FeedStorage::article(const QString &guid, uint &hash, QString &title, int &status, QDateTime &pubDate, ArticleRow *row) const
 {
-    const int idx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int idx = findArticle(guid, row);
     if (idx != -1) {
         auto view = d->archiveView.GetAt(idx);
         hash = d->phash(view);
@@ -300,27 +559,31 @@ void FeedStorage::article(const QString &guid, uint &hash, QString &title, int &
     }
 }
 
-QString FeedStorage::title(const QString &guid) const
+QString FeedStorage::title(const QString &guid, ArticleRow *row) const
 {
-    const int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(guid, row);
     return findidx != -1 ? QString::fromUtf8(QByteArray(d->ptitle(d->archiveView.GetAt(findidx)))) : QLatin1StringView("");
 }
 
-QString FeedStorage::description(const QString &guid) const
+QString FeedStorage::description(const QString &guid, ArticleRow *row) const
 {
-    const int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(guid, row);
     return findidx != -1 ? QString::fromUtf8(QByteArray(d->pdescription(d->archiveView.GetAt(findidx)))) : QLatin1StringView("");
 }
 
-QString FeedStorage::content(const QString &guid) const
+QString FeedStorage::content(const QString &guid, ArticleRow *row) const
 {
-    const int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(guid, row);
     return findidx != -1 ? QString::fromUtf8(QByteArray(d->pcontent(d->archiveView.GetAt(findidx)))) : QLatin1StringView("");
 }
 
-void FeedStorage::setPubDate(const QString &guid, const QDateTime &pubdate)
+void FeedStorage::setPubDate(const QString &guid, const QDateTime &pubdate, ArticleRow *articleRow)
 {
-    const int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(guid, articleRow);
     if (findidx == -1) {
         return;
     }
@@ -333,6 +596,7 @@ void FeedStorage::setPubDate(const QString &guid, const QDateTime &pubdate)
 
 void FeedStorage::setGuidIsHash(const QString &guid, bool isHash)
 {
+    const QMutexLocker lock(d->mutex);
     const int findidx = findArticle(guid);
     if (findidx == -1) {
         return;
@@ -346,6 +610,7 @@ void FeedStorage::setGuidIsHash(const QString &guid, bool isHash)
 
 void FeedStorage::setLink(const QString &guid, const QString &link)
 {
+    const QMutexLocker lock(d->mutex);
     const int findidx = findArticle(guid);
     if (findidx == -1) {
         return;
@@ -359,6 +624,7 @@ void FeedStorage::setLink(const QString &guid, const QString &link)
 
 void FeedStorage::setHash(const QString &guid, uint hash)
 {
+    const QMutexLocker lock(d->mutex);
     const int findidx = findArticle(guid);
     if (findidx == -1) {
         return;
@@ -372,6 +638,7 @@ void FeedStorage::setHash(const QString &guid, uint hash)
 
 void FeedStorage::setTitle(const QString &guid, const QString &title)
 {
+    const QMutexLocker lock(d->mutex);
     const int findidx = findArticle(guid);
     if (findidx == -1) {
         return;
@@ -380,11 +647,13 @@ void FeedStorage::setTitle(const QString &guid, const QString &title)
     row = d->archiveView.GetAt(findidx);
     d->ptitle(row) = !title.isEmpty() ? title.toUtf8().data() : "";
     d->archiveView.SetAt(findidx, row);
+    updateSearchIndex(findidx);
     markDirty();
 }
 
 void FeedStorage::setDescription(const QString &guid, const QString &description)
 {
+    const QMutexLocker lock(d->mutex);
     const int findidx = findArticle(guid);
     if (findidx == -1) {
         return;
@@ -393,11 +662,13 @@ void FeedStorage::setDescription(const QString &guid, const QString &description
     row = d->archiveView.GetAt(findidx);
     d->pdescription(row) = !description.isEmpty() ? description.toUtf8().data() : "";
     d->archiveView.SetAt(findidx, row);
+    updateSearchIndex(findidx);
     markDirty();
 }
 
 void FeedStorage::setContent(const QString &guid, const QString &content)
 {
+    const QMutexLocker lock(d->mutex);
     const int findidx = findArticle(guid);
     if (findidx == -1) {
         return;
@@ -411,6 +682,7 @@ void FeedStorage::setContent(const QString &guid, const QString &content)
 
 void FeedStorage::setAuthorName(const QString &guid, const QString &author)
 {
+    const QMutexLocker lock(d->mutex);
     const int findidx = findArticle(guid);
     if (findidx == -1) {
         return;
@@ -419,11 +691,13 @@ void FeedStorage::setAuthorName(const QString &guid, const QString &author)
     row = d->archiveView.GetAt(findidx);
     d->pauthorName(row) = !author.isEmpty() ? author.toUtf8().data() : "";
     d->archiveView.SetAt(findidx, row);
+    updateSearchIndex(findidx);
     markDirty();
 }
 
 void FeedStorage::setAuthorUri(const QString &guid, const QString &author)
 {
+    const QMutexLocker lock(d->mutex);
     const int findidx = findArticle(guid);
     if (findidx == -1) {
         return;
@@ -437,6 +711,7 @@ void FeedStorage::setAuthorUri(const QString &guid, const QString &author)
 
 void FeedStorage::setAuthorEMail(const QString &guid, const QString &author)
 {
+    const QMutexLocker lock(d->mutex);
     const int findidx = findArticle(guid);
     if (findidx == -1) {
         return;
@@ -448,26 +723,30 @@ void FeedStorage::setAuthorEMail(const QString &guid, const QString &author)
     markDirty();
 }
 
-QString FeedStorage::authorName(const QString &guid) const
+QString FeedStorage::authorName(const QString &guid, ArticleRow *row) const
 {
-    const int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(guid, row);
     return findidx != -1 ? QString::fromUtf8(QByteArray(d->pauthorName(d->archiveView.GetAt(findidx)))) : QString();
 }
 
-QString FeedStorage::authorUri(const QString &guid) const
+QString FeedStorage::authorUri(const QString &guid, ArticleRow *row) const
 {
-    const int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(guid, row);
     return findidx != -1 ? QString::fromUtf8(QByteArray(d->pauthorUri(d->archiveView.GetAt(findidx)))) : QString();
 }
 
-QString FeedStorage::authorEMail(const QString &guid) const
+QString FeedStorage::authorEMail(const QString &guid, ArticleRow *row) const
 {
-    const int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(guid, row);
     return findidx != -1 ? QString::fromUtf8(QByteArray(d->pauthorEMail(d->archiveView.GetAt(findidx)))) : QString();
 }
 
 void FeedStorage::setGuidIsPermaLink(const QString &guid, bool isPermaLink)
 {
+    const QMutexLocker lock(d->mutex);
     const int findidx = findArticle(guid);
     if (findidx == -1) {
         return;
@@ -479,9 +758,10 @@ void FeedStorage::setGuidIsPermaLink(const QString &guid, bool isPermaLink)
     markDirty();
 }
 
-void FeedStorage::setEnclosure(const QString &guid, const QString &url, const QString &type, int length)
+void FeedStorage::setEnclosure(const QString &guid, const QString &url, const QString &type, int length, ArticleRow *articleRow)
 {
-    const int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(guid, articleRow);
     if (findidx == -1) {
         return;
     }
@@ -498,6 +778,7 @@ void FeedStorage::setEnclosure(const QString &guid, const QString &url, const QS
 
 void FeedStorage::removeEnclosure(const QString &guid)
 {
+    const QMutexLocker lock(d->mutex);
     const int findidx = findArticle(guid);
     if (findidx == -1) {
         return;
@@ -513,9 +794,10 @@ void FeedStorage::removeEnclosure(const QString &guid)
     markDirty();
 }
 
-void FeedStorage::enclosure(const QString &guid, bool &hasEnclosure, QString &url, QString &type, int &length) const
+void FeedStorage::enclosure(const QString &guid, bool &hasEnclosure, QString &url, QString &type, int &length, ArticleRow *articleRow) const
 {
-    const int findidx = findArticle(guid);
+    const QMutexLocker lock(d->mutex);
+    const int findidx = findArticle(guid, articleRow);
     if (findidx == -1) {
         hasEnclosure = false;
         url.clear();
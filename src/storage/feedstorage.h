@@ -7,16 +7,60 @@
 */
 #pragma once
 
+#include <QDateTime>
 #include <QObject>
 
 #include "akregator_export.h"
 
+#include <functional>
 #include <memory>
 
 namespace Akregator
 {
 namespace Backend
 {
+/** Cached position of an article in the archive view. Rows only move when
+    articles are removed, so a handle stays valid until the next deletion
+    (or rollback) and is transparently re-resolved by guid afterwards. */
+struct ArticleRow {
+    int index = -1;
+    uint generation = 0;
+};
+
+/** The columns needed to show an article in the article list */
+struct ArticleHeader {
+    QString guid;
+    uint hash = 0;
+    QString title;
+    int status = 0;
+    QDateTime pubDate;
+    bool guidIsHash = false;
+    bool guidIsPermaLink = false;
+    ArticleRow row;
+};
+
+/** The columns written when a fetched item is stored, so that an article can be
+    inserted or updated with a single lookup and a single row write */
+struct ArticleData {
+    QString guid;
+    uint hash = 0;
+    QString title;
+    QString description;
+    QString content;
+    QString link;
+    QDateTime pubDate;
+    bool guidIsHash = false;
+    bool guidIsPermaLink = false;
+    bool hasAuthor = false;
+    QString authorName;
+    QString authorUri;
+    QString authorEMail;
+    bool hasEnclosure = false;
+    QString enclosureUrl;
+    QString enclosureType;
+    int enclosureLength = -1;
+};
+
 class Storage;
 class AKREGATOR_EXPORT FeedStorage : public QObject
 {
@@ -29,57 +73,93 @@ public:
     [[nodiscard]] int totalCount() const;
     [[nodiscard]] QDateTime lastFetch() const;
     void setLastFetch(const QDateTime &lastFetch);
+    /** HTTP validators of the last successful fetch, sent back to make the next fetch conditional */
+    [[nodiscard]] QString etag() const;
+    [[nodiscard]] QString lastModified() const;
+    void setValidators(const QString &etag, const QString &lastModified);
+    /** fetch interval learned from the update frequency of the feed, in seconds; 0 if none */
+    [[nodiscard]] int pollInterval() const;
+    void setPollInterval(int seconds);
+    /** number of fetches in a row which failed */
+    [[nodiscard]] int fetchFailures() const;
+    void setFetchFailures(int failures);
 
     [[nodiscard]] QStringList articles() const;
 
-    void article(const QString &guid, uint &hash, QString &title, int &status, QDateTime &pubDate) const;
-    bool contains(const QString &guid) const;
+    /** walks the whole archive once, calling @p func with the header columns of every article.
+        Much cheaper than articles() followed by one article() lookup per guid.
+        @param withTitle if @c false, the title column is skipped and ArticleHeader::title left empty */
+    void forEachArticleHeader(const std::function<void(const ArticleHeader &)> &func, bool withTitle = true) const;
+
+    void article(const QString &guid, uint &hash, QString &title, int &status, QDateTime &pubDate, ArticleRow *row = nullptr) const;
+    bool contains(const QString &guid, ArticleRow *row = nullptr) const;
     void addEntry(const QString &guid);
+
+    /** adds a complete article row to the archive. Does nothing if an article with the same guid exists. */
+    void addArticle(const ArticleData &data, ArticleRow *row = nullptr);
+
+    /** overwrites hash, title, description, content and link of an existing article,
+        plus author and enclosure if set in @p data. Status, pubDate and guid flags are kept. */
+    void updateArticle(const ArticleData &data, ArticleRow *row = nullptr);
+
     void deleteArticle(const QString &guid);
-    [[nodiscard]] bool guidIsHash(const QString &guid) const;
+    [[nodiscard]] bool guidIsHash(const QString &guid, ArticleRow *row = nullptr) const;
     void setGuidIsHash(const QString &guid, bool isHash);
-    bool guidIsPermaLink(const QString &guid) const;
+    bool guidIsPermaLink(const QString &guid, ArticleRow *row = nullptr) const;
     void setGuidIsPermaLink(const QString &guid, bool isPermaLink);
-    [[nodiscard]] uint hash(const QString &guid) const;
+    [[nodiscard]] uint hash(const QString &guid, ArticleRow *row = nullptr) const;
     void setHash(const QString &guid, uint hash);
-    void setDeleted(const QString &guid);
-    [[nodiscard]] QString link(const QString &guid) const;
+    void setDeleted(const QString &guid, ArticleRow *row = nullptr);
+    [[nodiscard]] QString link(const QString &guid, ArticleRow *row = nullptr) const;
     void setLink(const QString &guid, const QString &link);
-    [[nodiscard]] QDateTime pubDate(const QString &guid) const;
-    void setPubDate(const QString &guid, const QDateTime &pubdate);
-    [[nodiscard]] int status(const QString &guid) const;
-    void setStatus(const QString &guid, int status);
-    [[nodiscard]] QString title(const QString &guid) const;
+    [[nodiscard]] QDateTime pubDate(const QString &guid, ArticleRow *row = nullptr) const;
+    void setPubDate(const QString &guid, const QDateTime &pubdate, ArticleRow *row = nullptr);
+    [[nodiscard]] int status(const QString &guid, ArticleRow *row = nullptr) const;
+    void setStatus(const QString &guid, int status, ArticleRow *row = nullptr);
+    [[nodiscard]] QString title(const QString &guid, ArticleRow *row = nullptr) const;
     void setTitle(const QString &guid, const QString &title);
-    [[nodiscard]] QString description(const QString &guid) const;
+    [[nodiscard]] QString description(const QString &guid, ArticleRow *row = nullptr) const;
     void setDescription(const QString &guid, const QString &description);
-    [[nodiscard]] QString content(const QString &guid) const;
+    [[nodiscard]] QString content(const QString &guid, ArticleRow *row = nullptr) const;
     void setContent(const QString &guid, const QString &content);
 
-    void setEnclosure(const QString &guid, const QString &url, const QString &type, int length);
+    void setEnclosure(const QString &guid, const QString &url, const QString &type, int length, ArticleRow *row = nullptr);
     void removeEnclosure(const QString &guid);
-    void enclosure(const QString &guid, bool &hasEnclosure, QString &url, QString &type, int &length) const;
+    void enclosure(const QString &guid, bool &hasEnclosure, QString &url, QString &type, int &length, ArticleRow *row = nullptr) const;
 
     void setAuthorName(const QString &guid, const QString &name);
     void setAuthorUri(const QString &guid, const QString &uri);
     void setAuthorEMail(const QString &guid, const QString &email);
 
-    [[nodiscard]] QString authorName(const QString &guid) const;
-    [[nodiscard]] QString authorUri(const QString &guid) const;
-    [[nodiscard]] QString authorEMail(const QString &guid) const;
+    [[nodiscard]] QString authorName(const QString &guid, ArticleRow *row = nullptr) const;
+    [[nodiscard]] QString authorUri(const QString &guid, ArticleRow *row = nullptr) const;
+    [[nodiscard]] QString authorEMail(const QString &guid, ArticleRow *row = nullptr) const;
 
     void setCategories(const QString &, const QStringList &categories);
     [[nodiscard]] QStringList categories(const QString &guid) const;
 
+    /** adds all articles of this feed to the search index of the storage, see Storage::searchArticles().
+        Called from a worker thread. */
+    void buildSearchIndex();
+
     void close();
+    /** writes pending changes synchronously */
     void commit();
+    /** returns a function writing the pending changes, to be run on the I/O thread of Storage,
+        or an empty function if there is nothing to write. Clears the modified flag. */
+    [[nodiscard]] std::function<bool()> takeCommit();
     void rollback();
 
 private:
     void markDirty();
-    /** finds article by guid, returns -1 if not in archive **/
-    int findArticle(const QString &guid) const;
+    /** copies the articles of a per-feed archive file into this feed's partition of the shared archive */
+    void migrateFrom(const QString &filePath);
+    /** finds article by guid, returns -1 if not in archive.
+        If @p row holds a still valid position, the hash lookup is skipped; otherwise it is updated. **/
+    int findArticle(const QString &guid, ArticleRow *row = nullptr) const;
     void setTotalCount(int total);
+    /** passes the text of the article at @p index to the search index, if the feed is indexed */
+    void updateSearchIndex(int index);
 
 private:
     class FeedStoragePrivate;
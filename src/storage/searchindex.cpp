@@ -0,0 +1,568 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#include "searchindex.h"
+#include "akregator_debug.h"
+
+#include <QBitArray>
+#include <QDataStream>
+#include <QFile>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include <algorithm>
+#include <limits>
+
+using namespace Akregator::Backend;
+
+namespace
+{
+constexpr quint32 fileMagic = 0x414b5349; // "AKSI"
+constexpr quint32 fileVersion = 1;
+/** removed documents are dropped from the posting lists once there are more of them than this, and than live ones */
+constexpr int maxRemovedDocuments = 4096;
+
+[[nodiscard]] QString pendingFile(const QString &filePath)
+{
+    return filePath + QLatin1StringView(".loading");
+}
+
+/** lists the feeds changed in a session which did not load the index */
+[[nodiscard]] QString staleFile(const QString &filePath)
+{
+    return filePath + QLatin1StringView(".stale");
+}
+
+constexpr qsizetype trigramSize = 3;
+
+/** returns the trigram starting at @p chars as a key of SearchIndex::m_trigrams */
+[[nodiscard]] quint64 trigram(const QChar *chars)
+{
+    return quint64(chars[0].unicode()) << 32 | quint64(chars[1].unicode()) << 16 | chars[2].unicode();
+}
+}
+
+SearchIndex::SearchIndex() = default;
+
+SearchIndex::~SearchIndex() = default;
+
+QString SearchIndex::fold(QStringView text)
+{
+    // same as TextUtils::ConvertText::normalize(), which is not available to the storage backend
+    QString result;
+    result.reserve(text.size());
+    for (const QChar chr : text) {
+        const QChar c = chr.toCaseFolded();
+        if (c.decompositionTag() == QChar::Canonical) {
+            result.append(c.decomposition().at(0));
+        } else if (c.decompositionTag() == QChar::Compat && c.isLetter() && c.script() == QChar::Script_Latin) {
+            result.append(c.decomposition());
+        } else {
+            result.append(c);
+        }
+    }
+    return result;
+}
+
+QStringList SearchIndex::words(QStringView text)
+{
+    const QString folded = fold(text);
+    QStringList result;
+    QSet<QStringView> seen;
+    qsizetype start = -1;
+    const qsizetype size = folded.size();
+    for (qsizetype i = 0; i <= size; ++i) {
+        const bool inWord = i < size && folded.at(i).isLetterOrNumber();
+        if (inWord && start == -1) {
+            start = i;
+        } else if (!inWord && start != -1) {
+            const QStringView word = QStringView(folded).mid(start, i - start);
+            if (!seen.contains(word)) {
+                seen.insert(word);
+                result.append(word.toString());
+            }
+            start = -1;
+        }
+    }
+    return result;
+}
+
+void SearchIndex::setFile(const QString &filePath)
+{
+    const QMutexLocker lock(&m_mutex);
+    m_filePath = filePath;
+    m_pendingLoad = false;
+    m_stale.clear();
+
+    // left behind by a session which did not exit cleanly
+    QFile::remove(pendingFile(filePath));
+
+    QFile stale(staleFile(filePath));
+    if (stale.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream stream(&stale);
+        QString url;
+        while (stream.readLineInto(&url)) {
+            m_stale.insert(url);
+        }
+        stale.close();
+        stale.remove();
+    }
+
+    if (QFile::exists(filePath) && QFile::rename(filePath, pendingFile(filePath))) {
+        m_pendingLoad = true;
+    } else {
+        m_stale.clear();
+    }
+}
+
+void SearchIndex::load()
+{
+    QString filePath;
+    {
+        const QMutexLocker lock(&m_mutex);
+        if (!m_pendingLoad) {
+            return;
+        }
+        filePath = m_filePath;
+    }
+
+    // read without holding the lock, so that articles can be changed meanwhile
+    SearchIndex loaded;
+    const bool ok = loaded.read(pendingFile(filePath));
+
+    const QMutexLocker lock(&m_mutex);
+    // cleared or saved meanwhile
+    if (!m_pendingLoad || m_filePath != filePath) {
+        return;
+    }
+    m_pendingLoad = false;
+    QFile::remove(pendingFile(filePath));
+    // feeds may have been indexed already if the index was cleared in between
+    if (ok && m_indexedFeeds.isEmpty() && m_documents.isEmpty()) {
+        m_feedUrls = std::move(loaded.m_feedUrls);
+        m_feedIds = std::move(loaded.m_feedIds);
+        m_indexedFeeds = std::move(loaded.m_indexedFeeds);
+        m_documents = std::move(loaded.m_documents);
+        m_documentIds = std::move(loaded.m_documentIds);
+        m_removedDocuments = 0;
+        m_words = std::move(loaded.m_words);
+        m_wordIds = std::move(loaded.m_wordIds);
+        m_postings = std::move(loaded.m_postings);
+        m_trigrams = std::move(loaded.m_trigrams);
+        for (const QString &url : std::as_const(m_stale)) {
+            dropFeed(url);
+        }
+    }
+    m_stale.clear();
+    // lets searches notice that the feeds can be indexed now
+    ++m_generation;
+}
+
+bool SearchIndex::read(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (magic != fileMagic || version != fileVersion) {
+        return false;
+    }
+
+    QStringList feeds;
+    stream >> feeds;
+    for (const QString &url : std::as_const(feeds)) {
+        m_indexedFeeds.insert(feedId(url));
+    }
+
+    quint32 documents = 0;
+    stream >> documents;
+    m_documents.reserve(documents);
+    for (quint32 i = 0; i < documents && stream.status() == QDataStream::Ok; ++i) {
+        Document document;
+        qint32 feed = -1;
+        stream >> feed >> document.guid;
+        document.feed = feedId(feeds.value(feed));
+        document.alive = true;
+        m_documentIds[document.feed].insert(document.guid, static_cast<quint32>(m_documents.size()));
+        m_documents.append(document);
+    }
+
+    quint32 words = 0;
+    stream >> words;
+    m_words.reserve(words);
+    m_postings.reserve(words);
+    for (quint32 i = 0; i < words && stream.status() == QDataStream::Ok; ++i) {
+        QString word;
+        QList<quint32> postings;
+        stream >> word >> postings;
+        const auto id = static_cast<quint32>(m_words.size());
+        m_wordIds.insert(word, id);
+        m_words.append(word);
+        m_postings.append(postings);
+        indexWord(id);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qCWarning(AKREGATOR_LOG) << "Could not read the search index" << filePath;
+        return false;
+    }
+    return true;
+}
+
+bool SearchIndex::isLoaded() const
+{
+    const QMutexLocker lock(&m_mutex);
+    return !m_pendingLoad;
+}
+
+bool SearchIndex::save()
+{
+    const QMutexLocker lock(&m_mutex);
+    if (m_filePath.isEmpty()) {
+        return false;
+    }
+
+    if (m_pendingLoad) {
+        // not used in this session: put the file back and remember which feeds it is outdated for
+        m_pendingLoad = false;
+        if (!m_stale.isEmpty()) {
+            QSaveFile stale(staleFile(m_filePath));
+            if (!stale.open(QIODevice::WriteOnly | QIODevice::Text)) {
+                return false;
+            }
+            QTextStream stream(&stale);
+            for (const QString &url : std::as_const(m_stale)) {
+                stream << url << '\n';
+            }
+            stream.flush();
+            if (!stale.commit()) {
+                return false;
+            }
+        }
+        return QFile::rename(pendingFile(m_filePath), m_filePath);
+    }
+
+    if (m_indexedFeeds.isEmpty()) {
+        return true;
+    }
+    compact();
+
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(AKREGATOR_LOG) << "Could not write the search index" << m_filePath << file.errorString();
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << fileMagic << fileVersion;
+
+    // only indexed feeds are written, renumbered
+    QStringList feeds;
+    QHash<int, qint32> feedIndex;
+    for (const int feed : std::as_const(m_indexedFeeds)) {
+        feedIndex.insert(feed, feeds.size());
+        feeds.append(m_feedUrls.at(feed));
+    }
+    stream << feeds;
+
+    stream << quint32(m_documents.size());
+    for (const Document &document : std::as_const(m_documents)) {
+        stream << feedIndex.value(document.feed, -1) << document.guid;
+    }
+
+    stream << quint32(m_words.size());
+    for (qsizetype i = 0; i < m_words.size(); ++i) {
+        stream << m_words.at(i) << m_postings.at(i);
+    }
+    return file.commit();
+}
+
+void SearchIndex::clear()
+{
+    const QMutexLocker lock(&m_mutex);
+    if (m_pendingLoad) {
+        QFile::remove(pendingFile(m_filePath));
+        m_pendingLoad = false;
+    }
+    m_stale.clear();
+    m_feedUrls.clear();
+    m_feedIds.clear();
+    m_indexedFeeds.clear();
+    m_documents.clear();
+    m_documentIds.clear();
+    m_removedDocuments = 0;
+    m_words.clear();
+    m_wordIds.clear();
+    m_postings.clear();
+    m_trigrams.clear();
+    ++m_generation;
+}
+
+int SearchIndex::feedId(const QString &feedUrl)
+{
+    const auto it = m_feedIds.constFind(feedUrl);
+    if (it != m_feedIds.cend()) {
+        return it.value();
+    }
+    const int id = m_feedUrls.size();
+    m_feedUrls.append(feedUrl);
+    m_feedIds.insert(feedUrl, id);
+    return id;
+}
+
+bool SearchIndex::isIndexed(const QString &feedUrl)
+{
+    load();
+    const QMutexLocker lock(&m_mutex);
+    return m_indexedFeeds.contains(m_feedIds.value(feedUrl, -1));
+}
+
+void SearchIndex::setIndexed(const QString &feedUrl)
+{
+    const QMutexLocker lock(&m_mutex);
+    m_indexedFeeds.insert(feedId(feedUrl));
+    ++m_generation;
+}
+
+void SearchIndex::dropFeed(const QString &feedUrl)
+{
+    const QMutexLocker lock(&m_mutex);
+    if (m_pendingLoad) {
+        m_stale.insert(feedUrl);
+        return;
+    }
+    const int feed = m_feedIds.value(feedUrl, -1);
+    if (feed == -1) {
+        return;
+    }
+    m_indexedFeeds.remove(feed);
+    const QHash<QString, quint32> documents = m_documentIds.take(feed);
+    for (const quint32 id : documents) {
+        m_documents[id].alive = false;
+        m_documents[id].guid.clear();
+    }
+    m_removedDocuments += documents.size();
+    ++m_generation;
+}
+
+bool SearchIndex::articleChanged(const QString &feedUrl)
+{
+    const QMutexLocker lock(&m_mutex);
+    if (m_pendingLoad) {
+        m_stale.insert(feedUrl);
+        return false;
+    }
+    if (m_indexedFeeds.contains(m_feedIds.value(feedUrl, -1))) {
+        return true;
+    }
+    // lets searches notice that there is a feed to index
+    ++m_generation;
+    return false;
+}
+
+void SearchIndex::removeDocument(int feed, const QString &guid)
+{
+    const auto documents = m_documentIds.find(feed);
+    if (documents == m_documentIds.end()) {
+        return;
+    }
+    const auto it = documents->constFind(guid);
+    if (it == documents->cend()) {
+        return;
+    }
+    Document &document = m_documents[it.value()];
+    document.alive = false;
+    document.guid.clear();
+    documents->erase(it);
+    ++m_removedDocuments;
+    if (m_removedDocuments > maxRemovedDocuments && m_removedDocuments > m_documents.size() / 2) {
+        compact();
+    }
+}
+
+void SearchIndex::addArticle(const QString &feedUrl, const QString &guid, QStringView text)
+{
+    const QMutexLocker lock(&m_mutex);
+    const int feed = feedId(feedUrl);
+    removeDocument(feed, guid);
+    ++m_generation;
+
+    const QStringList articleWords = words(text);
+    if (articleWords.isEmpty()) {
+        return;
+    }
+    const auto id = static_cast<quint32>(m_documents.size());
+    m_documents.append({feed, guid, true});
+    m_documentIds[feed].insert(guid, id);
+    for (const QString &word : articleWords) {
+        const auto it = m_wordIds.constFind(word);
+        if (it != m_wordIds.cend()) {
+            m_postings[it.value()].append(id);
+        } else {
+            const auto wordId = static_cast<quint32>(m_words.size());
+            m_wordIds.insert(word, wordId);
+            m_words.append(word);
+            m_postings.append({id});
+            indexWord(wordId);
+        }
+    }
+}
+
+void SearchIndex::removeArticle(const QString &feedUrl, const QString &guid)
+{
+    const QMutexLocker lock(&m_mutex);
+    const int feed = m_feedIds.value(feedUrl, -1);
+    if (feed != -1) {
+        removeDocument(feed, guid);
+        ++m_generation;
+    }
+}
+
+void SearchIndex::compact()
+{
+    if (m_removedDocuments == 0) {
+        return;
+    }
+    constexpr quint32 removed = std::numeric_limits<quint32>::max();
+    QList<quint32> newIds(m_documents.size(), removed);
+    QList<Document> documents;
+    documents.reserve(m_documents.size() - m_removedDocuments);
+    for (qsizetype i = 0; i < m_documents.size(); ++i) {
+        if (m_documents.at(i).alive) {
+            newIds[i] = static_cast<quint32>(documents.size());
+            documents.append(m_documents.at(i));
+        }
+    }
+    m_documents = documents;
+    m_documentIds.clear();
+    for (qsizetype i = 0; i < m_documents.size(); ++i) {
+        m_documentIds[m_documents.at(i).feed].insert(m_documents.at(i).guid, static_cast<quint32>(i));
+    }
+
+    // renumbering keeps the posting lists ascending
+    QStringList words;
+    QList<QList<quint32>> postings;
+    m_wordIds.clear();
+    for (qsizetype i = 0; i < m_words.size(); ++i) {
+        QList<quint32> ids;
+        for (const quint32 id : std::as_const(m_postings.at(i))) {
+            if (newIds.at(id) != removed) {
+                ids.append(newIds.at(id));
+            }
+        }
+        if (!ids.isEmpty()) {
+            m_wordIds.insert(m_words.at(i), static_cast<quint32>(words.size()));
+            words.append(m_words.at(i));
+            postings.append(ids);
+        }
+    }
+    m_words = words;
+    m_postings = postings;
+    m_trigrams.clear();
+    for (qsizetype i = 0; i < m_words.size(); ++i) {
+        indexWord(static_cast<quint32>(i));
+    }
+    m_removedDocuments = 0;
+}
+
+void SearchIndex::indexWord(quint32 wordId)
+{
+    const QString &word = m_words.at(wordId);
+    for (qsizetype i = 0; i + trigramSize <= word.size(); ++i) {
+        QList<quint32> &wordIds = m_trigrams[trigram(word.constData() + i)];
+        // the word may contain the trigram more than once
+        if (wordIds.isEmpty() || wordIds.constLast() != wordId) {
+            wordIds.append(wordId);
+        }
+    }
+}
+
+QList<quint32> SearchIndex::wordsContaining(const QString &queryWord) const
+{
+    QList<quint32> result;
+    if (queryWord.size() < trigramSize) {
+        for (qsizetype i = 0; i < m_words.size(); ++i) {
+            if (m_words.at(i).contains(queryWord)) {
+                result.append(static_cast<quint32>(i));
+            }
+        }
+        return result;
+    }
+
+    // every word containing the query word contains all its trigrams: only the words listed
+    // for the rarest one need to be compared
+    const QList<quint32> *candidates = nullptr;
+    for (qsizetype i = 0; i + trigramSize <= queryWord.size(); ++i) {
+        const auto it = m_trigrams.constFind(trigram(queryWord.constData() + i));
+        if (it == m_trigrams.cend()) {
+            return result;
+        }
+        if (!candidates || it->size() < candidates->size()) {
+            candidates = &it.value();
+        }
+    }
+    for (const quint32 id : *candidates) {
+        if (m_words.at(id).contains(queryWord)) {
+            result.append(id);
+        }
+    }
+    return result;
+}
+
+std::optional<SearchIndex::Matches> SearchIndex::search(const QString &text)
+{
+    QStringList queryWords = words(text);
+    if (queryWords.isEmpty()) {
+        return std::nullopt;
+    }
+    // longer words match fewer documents
+    std::sort(queryWords.begin(), queryWords.end(), [](const QString &a, const QString &b) {
+        return a.size() > b.size();
+    });
+
+    load();
+    const QMutexLocker lock(&m_mutex);
+
+    // The query may start or end within a word, and so may each of its words: every indexed word
+    // containing a query word counts as a hit.
+    QBitArray hits;
+    for (const QString &queryWord : std::as_const(queryWords)) {
+        QBitArray wordHits(m_documents.size());
+        for (const quint32 word : wordsContaining(queryWord)) {
+            for (const quint32 id : std::as_const(m_postings.at(word))) {
+                wordHits.setBit(id);
+            }
+        }
+        hits = hits.isNull() ? wordHits : hits & wordHits;
+        if (hits.count(true) == 0) {
+            break;
+        }
+    }
+
+    Matches matches;
+    for (qsizetype id = 0; id < hits.size(); ++id) {
+        if (hits.testBit(id)) {
+            const Document &document = m_documents.at(id);
+            if (document.alive) {
+                matches[m_feedUrls.at(document.feed)].insert(document.guid);
+            }
+        }
+    }
+    return matches;
+}
+
+uint SearchIndex::generation() const
+{
+    const QMutexLocker lock(&m_mutex);
+    return m_generation;
+}
@@ -0,0 +1,130 @@
+/*
+    This file is part of Akregator.
+
+    SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+#pragma once
+
+#include "akregator_export.h"
+
+#include <QHash>
+#include <QList>
+#include <QRecursiveMutex>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include <optional>
+
+namespace Akregator
+{
+namespace Backend
+{
+/**
+ * Inverted index over the title, description and author of the archived articles of all feeds.
+ *
+ * The text is folded like TextUtils::ConvertText::normalize() does (case folding, diacritics
+ * stripped) and split into words at every character which is neither a letter nor a digit.
+ * A search looks up every word of the query in the dictionary of all indexed words, substrings
+ * included, so the result contains every article containing the query, as a plain substring
+ * search over the same fields would find it. Only the dictionary words sharing the rarest
+ * trigram (three consecutive characters) with a query word are compared to it; query words
+ * shorter than that are compared to the whole dictionary, a large share of which they match.
+ *
+ * Feeds are indexed on the first search, see Storage::searchArticles(), FeedStorage keeps them
+ * up to date afterwards.
+ * The index is written next to the archive when it is closed and adopted by the next session;
+ * it is only trusted if it was saved after the last change of the archive, see setFile().
+ */
+class AKREGATOR_EXPORT SearchIndex
+{
+public:
+    /** guids of matching articles, per feed url */
+    using Matches = QHash<QString, QSet<QString>>;
+
+    SearchIndex();
+    ~SearchIndex();
+
+    /** returns @p text folded for lookups */
+    [[nodiscard]] static QString fold(QStringView text);
+    /** returns the distinct words of @p text, folded */
+    [[nodiscard]] static QStringList words(QStringView text);
+
+    /** adopts the index saved at @p filePath by the previous session. It is loaded on the first
+        search; until then the file is moved aside, so that it is dropped if the application
+        crashes before save() wrote a current one. */
+    void setFile(const QString &filePath);
+    /** whether the file set by setFile() was read. It is read by the first isIndexed() or search(),
+        which may take a while: call them from a worker thread until then. */
+    [[nodiscard]] bool isLoaded() const;
+    /** writes the index to the file set by setFile() */
+    bool save();
+    /** forgets all feeds, e.g. after a rollback of the archive */
+    void clear();
+
+    /** whether the articles of @p feedUrl are in the index */
+    [[nodiscard]] bool isIndexed(const QString &feedUrl);
+    /** marks @p feedUrl as indexed, after all its articles were passed to addArticle() */
+    void setIndexed(const QString &feedUrl);
+    /** removes all articles of @p feedUrl, it is indexed again on the next search */
+    void dropFeed(const QString &feedUrl);
+
+    /** tells the index that an article of @p feedUrl is about to change.
+        Returns whether the feed is indexed, i.e. whether the new text must be passed to addArticle(). */
+    bool articleChanged(const QString &feedUrl);
+    /** adds or replaces the text of an article */
+    void addArticle(const QString &feedUrl, const QString &guid, QStringView text);
+    void removeArticle(const QString &feedUrl, const QString &guid);
+
+    /** returns the articles containing @p text, or nothing if @p text has no word to look up */
+    [[nodiscard]] std::optional<Matches> search(const QString &text);
+
+    /** bumped by every change of the indexed articles, and of articles of feeds still to be indexed */
+    [[nodiscard]] uint generation() const;
+
+private:
+    struct Document {
+        int feed = -1;
+        QString guid;
+        bool alive = false;
+    };
+
+    /** adopts the file set by setFile(), if not done yet. Must not be called with m_mutex held. */
+    void load();
+    /** reads @p filePath into this index, which must be empty */
+    bool read(const QString &filePath);
+    [[nodiscard]] int feedId(const QString &feedUrl);
+    void indexWord(quint32 wordId);
+    /** returns the ids of the dictionary words containing @p queryWord */
+    [[nodiscard]] QList<quint32> wordsContaining(const QString &queryWord) const;
+    void removeDocument(int feed, const QString &guid);
+    /** drops removed documents from the posting lists and renumbers the remaining ones */
+    void compact();
+
+    mutable QRecursiveMutex m_mutex;
+    QString m_filePath;
+    /** true until the file of the previous session was read */
+    bool m_pendingLoad = false;
+    /** feeds changed before the file of the previous session was read */
+    QSet<QString> m_stale;
+
+    QStringList m_feedUrls;
+    QHash<QString, int> m_feedIds;
+    QSet<int> m_indexedFeeds;
+
+    QList<Document> m_documents;
+    /** document ids per feed id and guid */
+    QHash<int, QHash<QString, quint32>> m_documentIds;
+    int m_removedDocuments = 0;
+
+    QStringList m_words;
+    QHash<QString, quint32> m_wordIds;
+    /** ascending document ids per word id */
+    QList<QList<quint32>> m_postings;
+    /** ascending ids of the words containing each trigram, see indexWord() */
+    QHash<quint64, QList<quint32>> m_trigrams;
+
+    uint m_generation = 0;
+};
+} // namespace Backend
+} // namespace Akregator
@@ -7,18 +7,31 @@
     SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
 */
 #include "storage.h"
+#include "akregator_debug.h"
+#include "countingfilestrategy.h"
 
 #include "mk4.h"
 
+#include <QElapsedTimer>
+#include <QFutureWatcher>
 #include <QMap>
+#include <QMutexLocker>
+#include <QPromise>
+#include <QRecursiveMutex>
+#include <QSet>
 #include <QString>
 #include <QStringList>
+#include <QThreadPool>
 #include <QTimer>
 
 #include <QDateTime>
 #include <QDir>
 #include <QStandardPaths>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <functional>
+#include <memory>
 
 using namespace std::chrono_literals;
 
@@ -31,6 +44,11 @@ public:
         , punread("unread")
         , ptotalCount("totalCount")
         , plastFetch("lastFetch")
+        , petag("etag")
+        , plastModified("lastModified")
+        , ppollInterval("pollInterval")
+        , pfetchFailures("fetchFailures")
+        , ppartition("id")
     {
     }
 
@@ -40,14 +58,57 @@ public:
     bool autoCommit = false;
     bool modified = false;
     mutable QMap<QString, Akregator::Backend::FeedStorage *> feeds;
+    /** feeds modified since the last commit */
+    QSet<Akregator::Backend::FeedStorage *> dirtyFeeds;
+    /** true if the shared archive file has changes not yet committed */
+    bool sharedModified = false;
+    /** bytes written by all archive files, see CountingFileStrategy */
+    std::atomic<qint64> bytesWritten{0};
+    Akregator::Backend::Storage::CommitStats lastCommitStats;
+    Akregator::Backend::SearchIndex searchIndex;
+    /** runs while feeds are added to searchIndex, see Storage::searchArticles() */
+    QFutureWatcher<void> searchIndexWatcher;
+
+    // Commits run on a single dedicated I/O thread. Each c4_Storage is guarded by a mutex
+    // taken by every access, so the GUI thread only waits if it touches a file being written.
+    QThreadPool ioThread;
+    QFutureWatcher<Akregator::Backend::Storage::CommitStats> commitWatcher;
+    /** set if commit() was called while a commit was running */
+    bool commitAgain = false;
+    /** guards storage, the feed index */
+    mutable QRecursiveMutex indexMutex;
+    /** guards sharedStorage */
+    QRecursiveMutex sharedMutex;
+
+    // write-behind scheduling, see Storage::markDirty()
+    QTimer commitTimer;
+    QElapsedTimer firstDirty;
+    QElapsedTimer lastDirty;
+    std::chrono::milliseconds minCommitDelay = 3s;
+    std::chrono::milliseconds maxCommitDelay = 30s;
+    QSet<const QObject *> commitHolds;
+    /** set when the last hold was released: commit without waiting for the delays */
+    bool flushWhenIdle = false;
+
+    void scheduleCommit();
+
     QStringList feedURLs;
     c4_StringProp purl, pFeedList;
     c4_IntProp punread, ptotalCount, plastFetch;
+    c4_StringProp petag, plastModified;
+    c4_IntProp ppollInterval, pfetchFailures;
     QString archivePath;
 
     c4_Storage *feedListStorage = nullptr;
     c4_View feedListView;
 
+    bool sharedArchive = false;
+    /** archive.mk4, holding the articles of all feeds when sharedArchive is set */
+    c4_Storage *sharedStorage = nullptr;
+    /** maps feed urls to the partition (pair of views) holding their articles */
+    c4_View partitionView;
+    c4_IntProp ppartition;
+
     Akregator::Backend::FeedStorage *createFeedStorage(const QString &url);
 };
 
@@ -55,14 +116,34 @@ Akregator::Backend::Storage::Storage()
     : d(new StoragePrivate)
 {
     d->q = this;
+    d->commitTimer.setSingleShot(true);
+    connect(&d->commitTimer, &QTimer::timeout, this, &Storage::slotCommit);
+    d->ioThread.setMaxThreadCount(1);
+    d->ioThread.setExpiryTimeout(-1);
+    connect(&d->commitWatcher, &QFutureWatcher<CommitStats>::finished, this, &Storage::slotCommitFinished);
     setArchivePath(QString());
 }
 
+void Akregator::Backend::Storage::StoragePrivate::scheduleCommit()
+{
+    if (!modified) {
+        commitTimer.stop();
+        return;
+    }
+    // a hold defers the commit up to the maximum delay, releaseCommits() writes earlier
+    std::chrono::nanoseconds due = maxCommitDelay - firstDirty.durationElapsed();
+    if (commitHolds.isEmpty()) {
+        due = flushWhenIdle ? 0ns : std::min(minCommitDelay - lastDirty.durationElapsed(), due);
+    }
+    commitTimer.start(std::max(std::chrono::duration_cast<std::chrono::milliseconds>(due), 0ms));
+}
+
 Akregator::Backend::FeedStorage *Akregator::Backend::Storage::StoragePrivate::createFeedStorage(const QString &url)
 {
     if (!feeds.contains(url)) {
         auto fs = new Akregator::Backend::FeedStorage(url, q);
         feeds[url] = fs;
+        const QMutexLocker lock(&indexMutex);
         c4_Row findrow;
         purl(findrow) = url.toLatin1().constData();
         int findidx = archiveView.Find(findrow);
@@ -71,7 +152,7 @@ Akregator::Backend::FeedStorage *Akregator::Backend::Storage::StoragePrivate::cr
             ptotalCount(findrow) = 0;
             plastFetch(findrow) = 0;
             archiveView.Add(findrow);
-            modified = true;
+            q->markDirty();
         }
     }
     return feeds[url];
@@ -101,6 +182,46 @@ QString Akregator::Backend::Storage::archivePath() const
     return d->archivePath;
 }
 
+void Akregator::Backend::Storage::setSharedArchive(bool shared)
+{
+    d->sharedArchive = shared;
+}
+
+bool Akregator::Backend::Storage::sharedArchive() const
+{
+    return d->sharedArchive;
+}
+
+c4_Storage *Akregator::Backend::Storage::sharedStorage() const
+{
+    return d->sharedStorage;
+}
+
+QRecursiveMutex *Akregator::Backend::Storage::sharedStorageMutex() const
+{
+    return &d->sharedMutex;
+}
+
+int Akregator::Backend::Storage::partitionFor(const QString &url, bool &created)
+{
+    const QMutexLocker lock(&d->sharedMutex);
+    c4_Row findrow;
+    d->purl(findrow) = url.toLatin1().constData();
+    const int findidx = d->partitionView.Find(findrow);
+    if (findidx != -1) {
+        created = false;
+        return d->ppartition(d->partitionView.GetAt(findidx));
+    }
+    // partitions are never removed, so the row count is a fresh id
+    const int id = d->partitionView.GetSize();
+    d->ppartition(findrow) = id;
+    d->partitionView.Add(findrow);
+    created = true;
+    d->sharedModified = true;
+    markDirty();
+    return id;
+}
+
 QString Akregator::Backend::Storage::defaultArchivePath()
 {
     const QString ret = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/akregator/Archive");
@@ -116,8 +237,8 @@ Akregator::Backend::Storage::~Storage()
 bool Akregator::Backend::Storage::open(bool autoCommit)
 {
     QString filePath = d->archivePath + QLatin1StringView("/archiveindex.mk4");
-    d->storage = new c4_Storage(filePath.toLocal8Bit().constData(), static_cast<int>(true));
-    d->archiveView = d->storage->GetAs("archive[url:S,unread:I,totalCount:I,lastFetch:I]");
+    d->storage = openArchiveFile(filePath);
+    d->archiveView = d->storage->GetAs("archive[url:S,unread:I,totalCount:I,lastFetch:I,etag:S,lastModified:S,pollInterval:I,fetchFailures:I]");
     c4_View hash = d->storage->GetAs("archiveHash[_H:I,_R:I]");
     d->archiveView = d->archiveView.Hash(hash, 1); // hash on url
     d->autoCommit = autoCommit;
@@ -125,9 +246,26 @@ bool Akregator::Backend::Storage::open(bool autoCommit)
     filePath = d->archivePath + QLatin1StringView("/feedlistbackup.mk4");
     d->feedListStorage = new c4_Storage(filePath.toLocal8Bit().constData(), static_cast<int>(true));
     d->feedListView = d->feedListStorage->GetAs("archive[feedList:S,tagSet:S]");
+
+    if (d->sharedArchive) {
+        filePath = d->archivePath + QLatin1StringView("/archive.mk4");
+        d->sharedStorage = openArchiveFile(filePath);
+        d->partitionView = d->sharedStorage->GetAs("partitions[url:S,id:I]");
+        c4_View partitionHash = d->sharedStorage->GetAs("partitionsHash[_H:I,_R:I]");
+        d->partitionView = d->partitionView.Hash(partitionHash, 1); // hash on url
+    }
+
+    d->searchIndex.setFile(d->archivePath + QLatin1StringView("/searchindex.dat"));
     return true;
 }
 
+c4_Storage *Akregator::Backend::Storage::openArchiveFile(const QString &filePath)
+{
+    auto strategy = new CountingFileStrategy(d->bytesWritten);
+    strategy->DataOpen(filePath.toLocal8Bit().constData(), 1);
+    return new c4_Storage(*strategy, true, 1);
+}
+
 bool Akregator::Backend::Storage::autoCommit() const
 {
     return d->autoCommit;
@@ -135,47 +273,140 @@ bool Akregator::Backend::Storage::autoCommit() const
 
 void Akregator::Backend::Storage::close()
 {
+    d->commitTimer.stop();
+    // let a running commit finish, the rest is written synchronously below
+    d->ioThread.waitForDone();
+    // the search index is built from the feed storages deleted below
+    d->searchIndexWatcher.cancel();
+    d->searchIndexWatcher.waitForFinished();
+    d->commitAgain = false;
     QMap<QString, FeedStorage *>::Iterator it;
     QMap<QString, FeedStorage *>::Iterator end(d->feeds.end());
     for (it = d->feeds.begin(); it != end; ++it) {
         it.value()->close();
         delete it.value();
     }
+    d->feeds.clear();
+    d->dirtyFeeds.clear();
     if (d->autoCommit) {
         d->storage->Commit();
     }
 
+    if (d->sharedStorage) {
+        d->sharedStorage->Commit();
+        delete d->sharedStorage;
+        d->sharedStorage = nullptr;
+    }
+
     delete d->storage;
     d->storage = nullptr;
 
     d->feedListStorage->Commit();
     delete d->feedListStorage;
     d->feedListStorage = nullptr;
+
+    // only an index saved after the last write of the archive can be trusted by the next session
+    if (d->autoCommit) {
+        d->searchIndex.save();
+    }
+    d->searchIndex.clear();
 }
 
 bool Akregator::Backend::Storage::commit()
 {
-    QMap<QString, FeedStorage *>::Iterator it;
-    QMap<QString, FeedStorage *>::Iterator end(d->feeds.end());
-    for (it = d->feeds.begin(); it != end; ++it) {
-        it.value()->commit();
+    if (!d->storage) {
+        return false;
     }
-
-    if (d->storage) {
-        d->storage->Commit();
+    if (d->commitWatcher.isRunning()) {
+        d->commitAgain = true;
         return true;
     }
 
-    return false;
+    // Only the list of files to write is collected here, the writing itself happens on the I/O thread
+    QList<std::function<bool()>> jobs;
+    jobs.reserve(d->dirtyFeeds.size() + 2);
+    for (FeedStorage *feed : std::as_const(d->dirtyFeeds)) {
+        if (auto job = feed->takeCommit()) {
+            jobs.append(std::move(job));
+        }
+    }
+    const int feeds = d->dirtyFeeds.size();
+    d->dirtyFeeds.clear();
+
+    // one commit covers the articles of all feeds
+    if (d->sharedStorage && d->sharedModified) {
+        jobs.append([storage = d->sharedStorage, mutex = &d->sharedMutex]() {
+            const QMutexLocker lock(mutex);
+            return storage->Commit();
+        });
+    }
+    d->sharedModified = false;
+
+    jobs.append([storage = d->storage, mutex = &d->indexMutex]() {
+        const QMutexLocker lock(mutex);
+        return storage->Commit();
+    });
+
+    auto promise = std::make_shared<QPromise<CommitStats>>();
+    d->commitWatcher.setFuture(promise->future());
+    promise->start();
+    d->ioThread.start([promise, jobs = std::move(jobs), feeds, bytesWritten = &d->bytesWritten]() {
+        QElapsedTimer timer;
+        timer.start();
+        const qint64 bytesBefore = *bytesWritten;
+        CommitStats stats;
+        stats.feeds = feeds;
+        for (const auto &job : jobs) {
+            if (!job()) {
+                stats.ok = false;
+            }
+        }
+        stats.bytesWritten = *bytesWritten - bytesBefore;
+        stats.duration = timer.durationElapsed();
+        promise->addResult(stats);
+        promise->finish();
+    });
+    return true;
+}
+
+void Akregator::Backend::Storage::slotCommitFinished()
+{
+    const CommitStats stats = d->commitWatcher.future().result();
+    d->lastCommitStats = stats;
+    qCDebug(AKREGATOR_LOG) << "Committed" << stats.feeds << "feeds," << stats.bytesWritten << "bytes in"
+                           << std::chrono::duration_cast<std::chrono::milliseconds>(stats.duration).count() << "ms";
+    if (!stats.ok) {
+        qCWarning(AKREGATOR_LOG) << "Writing the archive failed";
+    }
+    Q_EMIT commitFinished(stats);
+
+    if (d->commitAgain) {
+        d->commitAgain = false;
+        commit();
+    }
+}
+
+Akregator::Backend::Storage::CommitStats Akregator::Backend::Storage::lastCommitStats() const
+{
+    return d->lastCommitStats;
 }
 
 bool Akregator::Backend::Storage::rollback()
 {
+    d->ioThread.waitForDone();
     QMap<QString, FeedStorage *>::Iterator it;
     QMap<QString, FeedStorage *>::Iterator end(d->feeds.end());
     for (it = d->feeds.begin(); it != end; ++it) {
         it.value()->rollback();
     }
+    d->dirtyFeeds.clear();
+
+    if (d->sharedStorage) {
+        d->sharedStorage->Rollback();
+    }
+    d->sharedModified = false;
+    d->searchIndex.clear();
+    d->commitAgain = false;
 
     if (d->storage) {
         d->storage->Rollback();
@@ -186,6 +417,7 @@ bool Akregator::Backend::Storage::rollback()
 
 int Akregator::Backend::Storage::unreadFor(const QString &url) const
 {
+    const QMutexLocker lock(&d->indexMutex);
     c4_Row findrow;
     d->purl(findrow) = url.toLatin1().constData();
     int findidx = d->archiveView.Find(findrow);
@@ -195,6 +427,7 @@ int Akregator::Backend::Storage::unreadFor(const QString &url) const
 
 void Akregator::Backend::Storage::setUnreadFor(const QString &url, int unread)
 {
+    const QMutexLocker lock(&d->indexMutex);
     c4_Row findrow;
     d->purl(findrow) = url.toLatin1().constData();
     int findidx = d->archiveView.Find(findrow);
@@ -209,6 +442,7 @@ void Akregator::Backend::Storage::setUnreadFor(const QString &url, int unread)
 
 int Akregator::Backend::Storage::totalCountFor(const QString &url) const
 {
+    const QMutexLocker lock(&d->indexMutex);
     c4_Row findrow;
     d->purl(findrow) = url.toLatin1().constData();
     int findidx = d->archiveView.Find(findrow);
@@ -218,6 +452,7 @@ int Akregator::Backend::Storage::totalCountFor(const QString &url) const
 
 void Akregator::Backend::Storage::setTotalCountFor(const QString &url, int total)
 {
+    const QMutexLocker lock(&d->indexMutex);
     c4_Row findrow;
     d->purl(findrow) = url.toLatin1().constData();
     int findidx = d->archiveView.Find(findrow);
@@ -232,6 +467,7 @@ void Akregator::Backend::Storage::setTotalCountFor(const QString &url, int total
 
 QDateTime Akregator::Backend::Storage::lastFetchFor(const QString &url) const
 {
+    const QMutexLocker lock(&d->indexMutex);
     c4_Row findrow;
     d->purl(findrow) = url.toLatin1().constData();
     int findidx = d->archiveView.Find(findrow);
@@ -241,6 +477,7 @@ QDateTime Akregator::Backend::Storage::lastFetchFor(const QString &url) const
 
 void Akregator::Backend::Storage::setLastFetchFor(const QString &url, const QDateTime &lastFetch)
 {
+    const QMutexLocker lock(&d->indexMutex);
     c4_Row findrow;
     d->purl(findrow) = url.toLatin1().constData();
     int findidx = d->archiveView.Find(findrow);
@@ -253,26 +490,208 @@ void Akregator::Backend::Storage::setLastFetchFor(const QString &url, const QDat
     markDirty();
 }
 
+QString Akregator::Backend::Storage::etagFor(const QString &url) const
+{
+    const QMutexLocker lock(&d->indexMutex);
+    c4_Row findrow;
+    d->purl(findrow) = url.toLatin1().constData();
+    int findidx = d->archiveView.Find(findrow);
+
+    return findidx != -1 ? QString::fromLatin1(QByteArray(d->petag(d->archiveView.GetAt(findidx)))) : QString();
+}
+
+QString Akregator::Backend::Storage::lastModifiedFor(const QString &url) const
+{
+    const QMutexLocker lock(&d->indexMutex);
+    c4_Row findrow;
+    d->purl(findrow) = url.toLatin1().constData();
+    int findidx = d->archiveView.Find(findrow);
+
+    return findidx != -1 ? QString::fromLatin1(QByteArray(d->plastModified(d->archiveView.GetAt(findidx)))) : QString();
+}
+
+void Akregator::Backend::Storage::setValidatorsFor(const QString &url, const QString &etag, const QString &lastModified)
+{
+    const QMutexLocker lock(&d->indexMutex);
+    c4_Row findrow;
+    d->purl(findrow) = url.toLatin1().constData();
+    int findidx = d->archiveView.Find(findrow);
+    if (findidx == -1) {
+        return;
+    }
+    findrow = d->archiveView.GetAt(findidx);
+    d->petag(findrow) = etag.toLatin1().constData();
+    d->plastModified(findrow) = lastModified.toLatin1().constData();
+    d->archiveView.SetAt(findidx, findrow);
+    markDirty();
+}
+
+int Akregator::Backend::Storage::pollIntervalFor(const QString &url) const
+{
+    const QMutexLocker lock(&d->indexMutex);
+    c4_Row findrow;
+    d->purl(findrow) = url.toLatin1().constData();
+    int findidx = d->archiveView.Find(findrow);
+
+    return findidx != -1 ? d->ppollInterval(d->archiveView.GetAt(findidx)) : 0;
+}
+
+void Akregator::Backend::Storage::setPollIntervalFor(const QString &url, int seconds)
+{
+    const QMutexLocker lock(&d->indexMutex);
+    c4_Row findrow;
+    d->purl(findrow) = url.toLatin1().constData();
+    int findidx = d->archiveView.Find(findrow);
+    if (findidx == -1) {
+        return;
+    }
+    findrow = d->archiveView.GetAt(findidx);
+    d->ppollInterval(findrow) = seconds;
+    d->archiveView.SetAt(findidx, findrow);
+    markDirty();
+}
+
+int Akregator::Backend::Storage::fetchFailuresFor(const QString &url) const
+{
+    const QMutexLocker lock(&d->indexMutex);
+    c4_Row findrow;
+    d->purl(findrow) = url.toLatin1().constData();
+    int findidx = d->archiveView.Find(findrow);
+
+    return findidx != -1 ? d->pfetchFailures(d->archiveView.GetAt(findidx)) : 0;
+}
+
+void Akregator::Backend::Storage::setFetchFailuresFor(const QString &url, int failures)
+{
+    const QMutexLocker lock(&d->indexMutex);
+    c4_Row findrow;
+    d->purl(findrow) = url.toLatin1().constData();
+    int findidx = d->archiveView.Find(findrow);
+    if (findidx == -1) {
+        return;
+    }
+    findrow = d->archiveView.GetAt(findidx);
+    d->pfetchFailures(findrow) = failures;
+    d->archiveView.SetAt(findidx, findrow);
+    markDirty();
+}
+
 void Akregator::Backend::Storage::markDirty()
 {
+    // Bursts of changes are coalesced: only the time of the last change is recorded here,
+    // slotCommit() pushes the commit back while changes keep coming in.
+    d->lastDirty.start();
     if (!d->modified) {
         d->modified = true;
-        // commit changes after 3 seconds
-        QTimer::singleShot(3s, this, &Storage::slotCommit);
+        d->firstDirty.start();
+        d->scheduleCommit();
     }
 }
 
-void Akregator::Backend::Storage::slotCommit()
+void Akregator::Backend::Storage::setCommitDelays(std::chrono::milliseconds minDelay, std::chrono::milliseconds maxDelay)
+{
+    d->minCommitDelay = std::max(minDelay, 0ms);
+    d->maxCommitDelay = std::max(maxDelay, d->minCommitDelay);
+    if (d->commitTimer.isActive()) {
+        d->scheduleCommit();
+    }
+}
+
+void Akregator::Backend::Storage::holdCommits(QObject *holder)
 {
+    if (d->commitHolds.contains(holder)) {
+        return;
+    }
+    d->commitHolds.insert(holder);
+    connect(holder, &QObject::destroyed, this, &Storage::releaseCommits, Qt::UniqueConnection);
+    d->scheduleCommit();
+}
+
+void Akregator::Backend::Storage::releaseCommits(QObject *holder)
+{
+    if (!d->commitHolds.remove(holder)) {
+        return;
+    }
+    disconnect(holder, &QObject::destroyed, this, &Storage::releaseCommits);
+    if (!d->commitHolds.isEmpty() || !d->modified) {
+        return;
+    }
+    // flush once the event loop is idle again
+    d->flushWhenIdle = true;
+    d->commitTimer.start(0ms);
+}
+
+void Akregator::Backend::Storage::flush()
+{
+    d->commitTimer.stop();
+    d->flushWhenIdle = false;
     if (d->modified) {
         commit();
     }
     d->modified = false;
 }
 
+void Akregator::Backend::Storage::markDirty(FeedStorage *feed)
+{
+    d->dirtyFeeds.insert(feed);
+    if (d->sharedArchive) {
+        d->sharedModified = true;
+    }
+    markDirty();
+}
+
+void Akregator::Backend::Storage::slotCommit()
+{
+    if (!d->modified) {
+        return;
+    }
+    const bool quiet = d->lastDirty.durationElapsed() >= d->minCommitDelay;
+    const bool overdue = d->firstDirty.durationElapsed() >= d->maxCommitDelay;
+    if (!overdue && (!d->commitHolds.isEmpty() || (!quiet && !d->flushWhenIdle))) {
+        d->scheduleCommit();
+        return;
+    }
+    flush();
+}
+
+Akregator::Backend::SearchIndex *Akregator::Backend::Storage::searchIndex() const
+{
+    return &d->searchIndex;
+}
+
+std::optional<Akregator::Backend::SearchIndex::Matches> Akregator::Backend::Storage::searchArticles(const QString &text)
+{
+    if (d->searchIndexWatcher.isRunning()) {
+        return std::nullopt;
+    }
+    bool complete = d->searchIndex.isLoaded();
+    for (auto it = d->feeds.cbegin(), end = d->feeds.cend(); complete && it != end; ++it) {
+        complete = d->searchIndex.isIndexed(it.key());
+    }
+    if (complete) {
+        return d->searchIndex.search(text);
+    }
+
+    // Reading the index file and the articles of all feeds takes a while. FeedStorage holds its
+    // mutex while building, so articles changed meanwhile are indexed either way.
+    auto promise = std::make_shared<QPromise<void>>();
+    d->searchIndexWatcher.setFuture(promise->future());
+    promise->start();
+    QThreadPool::globalInstance()->start([promise, index = &d->searchIndex, feeds = d->feeds]() {
+        for (auto it = feeds.cbegin(), end = feeds.cend(); it != end && !promise->isCanceled(); ++it) {
+            if (!index->isIndexed(it.key())) {
+                it.value()->buildSearchIndex();
+            }
+        }
+        promise->finish();
+    });
+    return std::nullopt;
+}
+
 QStringList Akregator::Backend::Storage::feeds() const
 {
     // TODO: cache list
+    const QMutexLocker lock(&d->indexMutex);
     QStringList list;
     const int size = d->archiveView.GetSize();
     list.reserve(size);
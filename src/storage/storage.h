@@ -12,9 +12,14 @@
 #include "akregator_export.h"
 
 #include <QObject>
+#include <chrono>
 #include <memory>
 
 #include "feedstorage.h"
+#include "searchindex.h"
+
+class c4_Storage;
+class QRecursiveMutex;
 
 namespace Akregator
 {
@@ -24,6 +29,16 @@ class AKREGATOR_EXPORT Storage : public QObject
 {
     Q_OBJECT
 public:
+    /** figures of a single flush to disk */
+    struct CommitStats {
+        /** number of feed archives written */
+        int feeds = 0;
+        qint64 bytesWritten = 0;
+        std::chrono::nanoseconds duration{0};
+        /** false if writing any of the files failed */
+        bool ok = true;
+    };
+
     Storage();
     virtual ~Storage();
 
@@ -39,6 +54,14 @@ public:
     /** returns the path to the metakit archives */
     QString archivePath() const;
 
+    /** if @p shared is true, the articles of all feeds are kept in one archive file
+        instead of one file per feed. Must be called before open().
+     */
+    void setSharedArchive(bool shared);
+
+    /** returns whether all feeds share a single archive file */
+    [[nodiscard]] bool sharedArchive() const;
+
     /**
      * Open storage and prepare it for work.
      * @return true on success.
@@ -47,7 +70,8 @@ public:
 
     /**
      * Commit changes made in feeds and articles, making them persistent.
-     * @return true on success.
+     * The files are written on a background I/O thread, see commitFinished().
+     * @return true if the commit was started.
      */
     bool commit();
 
@@ -78,17 +102,71 @@ public:
     void setTotalCountFor(const QString &url, int total);
     QDateTime lastFetchFor(const QString &url) const;
     void setLastFetchFor(const QString &url, const QDateTime &lastFetch);
+    /** HTTP validators (ETag and Last-Modified headers) of the last successful fetch */
+    [[nodiscard]] QString etagFor(const QString &url) const;
+    [[nodiscard]] QString lastModifiedFor(const QString &url) const;
+    void setValidatorsFor(const QString &url, const QString &etag, const QString &lastModified);
+    /** fetch interval learned from the update frequency of the feed, in seconds; 0 if none */
+    [[nodiscard]] int pollIntervalFor(const QString &url) const;
+    void setPollIntervalFor(const QString &url, int seconds);
+    /** number of fetches in a row which failed */
+    [[nodiscard]] int fetchFailuresFor(const QString &url) const;
+    void setFetchFailuresFor(const QString &url, int failures);
+
+    // API for FeedStorage to find its partition of the shared archive file
+    c4_Storage *sharedStorage() const;
+    QRecursiveMutex *sharedStorageMutex() const;
+    /** returns the partition id for @p url, allocating one if needed; @p created tells whether it is new */
+    int partitionFor(const QString &url, bool &created);
 
     QStringList feeds() const;
 
     void storeFeedList(const QString &opmlStr);
     QString restoreFeedList() const;
 
+    /** schedules a commit, see setCommitDelays() */
     void markDirty();
+    /** marks @p feed as modified, so the next commit writes it */
+    void markDirty(FeedStorage *feed);
+
+    // API for FeedStorage to open its per-feed archive file
+    c4_Storage *openArchiveFile(const QString &filePath);
+
+    /** returns the figures of the last commit */
+    [[nodiscard]] CommitStats lastCommitStats() const;
+
+    /** sets when pending changes are written: @p minDelay after the last change,
+        but no later than @p maxDelay after the first uncommitted one.
+     */
+    void setCommitDelays(std::chrono::milliseconds minDelay, std::chrono::milliseconds maxDelay);
+
+    /** defers commits until releaseCommits() is called for @p holder or it is destroyed, but no longer
+        than the maximum delay of setCommitDelays(). Holding twice is a no-op. */
+    void holdCommits(QObject *holder);
+    /** ends a hold taken by @p holder; pending changes are written once no hold is left */
+    void releaseCommits(QObject *holder);
+
+    /** starts writing pending changes right away */
+    void flush();
+
+    /** returns the full-text index of the archived articles */
+    [[nodiscard]] SearchIndex *searchIndex() const;
+
+    /** returns the articles whose title, description or author contains @p text, see SearchIndex::search().
+        Returns nothing while feeds not in the index yet are indexed, which the first call starts
+        on a worker thread: callers must fall back to matching the articles themselves. */
+    [[nodiscard]] std::optional<SearchIndex::Matches> searchArticles(const QString &text);
+
+Q_SIGNALS:
+    /** emitted when a commit started by commit() was written, @p stats tells whether it succeeded */
+    void commitFinished(const Akregator::Backend::Storage::CommitStats &stats);
 
 protected Q_SLOTS:
     void slotCommit();
 
+private Q_SLOTS:
+    void slotCommitFinished();
+
 private:
     class StoragePrivate;
     std::unique_ptr<StoragePrivate> const d;
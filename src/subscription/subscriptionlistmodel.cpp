@@ -258,7 +258,7 @@ QVariant SubscriptionListModel::data(const QModelIndex &index, int role) const
         }
         break;
     case Qt::ForegroundRole:
-        return feed && feed->fetchErrorCode() ? m_errorColor : QApplication::palette().color(QPalette::Text);
+        return feed && (feed->fetchErrorCode() || feed->isParked()) ? m_errorColor : QApplication::palette().color(QPalette::Text);
     case Qt::ToolTipRole: {
         if (node->isGroup() || node->isAggregation()) {
             return node->title();
@@ -266,10 +266,22 @@ QVariant SubscriptionListModel::data(const QModelIndex &index, int role) const
         if (!feed) {
             return QString();
         }
-        if (feed->fetchErrorOccurred()) {
-            return i18n("Could not fetch feed: %1", errorCodeToString(feed->fetchErrorCode()));
+        QStringList lines;
+        if (feed->fetchSkipped()) {
+            lines.append(i18n("Not fetched: the server of the feed failed several times in a row."));
+        } else if (feed->fetchErrorOccurred()) {
+            lines.append(i18n("Could not fetch feed: %1", errorCodeToString(feed->fetchErrorCode())));
         }
-        return feed->title();
+        if (feed->isParked()) {
+            lines.append(i18np("Fetching failed %1 time in a row, the feed is only retried once a day.",
+                               "Fetching failed %1 times in a row, the feed is only retried once a day.",
+                               feed->fetchFailures()));
+        } else if (feed->fetchFailures() > 1) {
+            lines.append(i18np("Fetching failed %1 time in a row, retries are spaced out.",
+                               "Fetching failed %1 times in a row, retries are spaced out.",
+                               feed->fetchFailures()));
+        }
+        return lines.isEmpty() ? feed->title() : lines.join(QLatin1Char('\n'));
     }
     case Qt::DecorationRole: {
         if (index.column() != TitleColumn) {
@@ -303,6 +315,10 @@ QVariant SubscriptionListModel::data(const QModelIndex &index, int role) const
         return feed ? feed->activities() : QVariant();
     case ActivityEnabled:
         return feed ? feed->activityEnabled() : QVariant();
+    case FetchFailuresRole:
+        return feed ? feed->fetchFailures() : QVariant();
+    case IsParkedRole:
+        return feed ? feed->isParked() : QVariant();
     }
 
     return {};
@@ -66,6 +66,8 @@ public:
         HasUnreadRole,
         Activities,
         ActivityEnabled,
+        FetchFailuresRole,
+        IsParkedRole,
     };
 
     enum Column {
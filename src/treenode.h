@@ -9,6 +9,7 @@
 #pragma once
 
 #include "akregator_export.h"
+#include "types.h"
 #include <QList>
 #include <QObject>
 #include <QPoint>
@@ -162,8 +163,9 @@ public Q_SLOTS:
     /** adds node to a fetch queue
         @param queue pointer to the queue
         @param intervalFetchesOnly determines whether to allow only interval fetches
+        @param priority the lane of the queue to use
     */
-    virtual void slotAddToFetchQueue(Akregator::FetchQueue *queue, bool intervalFetchesOnly = false) = 0;
+    virtual void slotAddToFetchQueue(Akregator::FetchQueue *queue, bool intervalFetchesOnly = false, Akregator::FetchPriority priority = BackgroundFetch) = 0;
 
 Q_SIGNALS:
 
@@ -144,20 +144,8 @@ void SearchBar::slotStopActiveSearch()
 
 void SearchBar::slotActivateSearch()
 {
-    QList<Criterion> textCriteria;
     QList<Criterion> statusCriteria;
 
-    if (!m_searchText.isEmpty()) {
-        const QString searchTextDiacritic(TextUtils::ConvertText::normalize(m_searchText));
-        textCriteria.reserve(3);
-        Criterion subjCrit(Criterion::Title, Criterion::Contains, searchTextDiacritic);
-        textCriteria << subjCrit;
-        Criterion crit1(Criterion::Description, Criterion::Contains, searchTextDiacritic);
-        textCriteria << crit1;
-        Criterion authCrit(Criterion::Author, Criterion::Contains, searchTextDiacritic);
-        textCriteria << authCrit;
-    }
-
     switch (m_statusSearchButtons->status()) {
     case StatusSearchButtons::AllArticles:
         break;
@@ -186,8 +174,9 @@ void SearchBar::slotActivateSearch()
     }
 
     std::vector<QSharedPointer<const AbstractMatcher>> matchers;
-    if (!textCriteria.isEmpty()) {
-        matchers.push_back(QSharedPointer<const AbstractMatcher>(new ArticleMatcher(textCriteria, ArticleMatcher::LogicalOr)));
+    if (!m_searchText.isEmpty()) {
+        // title, description and author, looked up in the search index of the archive
+        matchers.push_back(QSharedPointer<const AbstractMatcher>(new FullTextMatcher(TextUtils::ConvertText::normalize(m_searchText))));
     }
     if (!statusCriteria.isEmpty()) {
         matchers.push_back(QSharedPointer<const AbstractMatcher>(new ArticleMatcher(statusCriteria, ArticleMatcher::LogicalOr)));